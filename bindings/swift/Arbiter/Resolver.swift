@@ -43,7 +43,9 @@ public final class Resolver<ProjectValue: ArbiterValue, VersionMetadata: Arbiter
     let behaviors = ArbiterResolverBehaviors(
       createDependencyList: createDependencyListBehavior,
       createAvailableVersionsList: createAvailableVersionsListBehavior,
-      createSelectedVersionForMetadata: createSelectedVersionForMetadataBehavior)
+      createSelectedVersionForMetadata: createSelectedVersionForMetadataBehavior,
+      requestDependencyList: nil,
+      requestAvailableVersionsList: nil)
 
     let context = Unmanaged.passUnretained(self).toOpaque()
     _pointer = ArbiterCreateResolver(behaviors, dependencies.pointer, UnsafePointer<Void>(context))
@@ -8,10 +8,13 @@ extern "C" {
 #include <arbiter/Value.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 
 // forward declarations
+struct ArbiterDependency;
 struct ArbiterDependencyList;
 struct ArbiterProjectIdentifier;
+struct ArbiterResolvedDependency;
 struct ArbiterResolvedDependencyGraph;
 struct ArbiterSelectedVersion;
 struct ArbiterSelectedVersionList;
@@ -22,6 +25,81 @@ struct ArbiterSelectedVersionList;
  */
 typedef struct ArbiterResolver ArbiterResolver;
 
+/**
+ * A handle for delivering the result of an asynchronous request made by the
+ * resolver. Every completion must be passed to exactly one of
+ * ArbiterResolverCompleteDependencyList() or
+ * ArbiterResolverCompleteAvailableVersionsList(), which frees it.
+ */
+typedef struct ArbiterResolverCompletion ArbiterResolverCompletion;
+
+/**
+ * Lists of available versions and of dependencies which can be shared by many
+ * resolvers, so that each list is requested only once between them.
+ */
+typedef struct ArbiterResolverCache ArbiterResolverCache;
+
+/**
+ * A requirement which a proposed dependency graph does not satisfy, as found
+ * by ArbiterResolverCreateVerifiedDependencyGraph().
+ */
+typedef struct ArbiterResolverViolation ArbiterResolverViolation;
+
+/**
+ * A list of violations found by ArbiterResolverCreateVerifiedDependencyGraph().
+ */
+typedef struct ArbiterResolverViolationList ArbiterResolverViolationList;
+
+/**
+ * How to order the projects at each level of the dependency graph when
+ * deciding upon their versions.
+ */
+typedef enum
+{
+  /**
+   * Decide first upon the projects with the fewest versions that satisfy the
+   * requirements upon them, breaking ties in favor of projects with more
+   * dependents. Conflicts are then discovered as early as possible, so less
+   * of the search has to be redone.
+   *
+   * This is the default.
+   */
+  ArbiterResolverDecisionOrderingMostConstrainedFirst,
+
+  /**
+   * Decide upon projects in the order of their identifiers, according to the
+   * `lessThan` function of their user values.
+   */
+  ArbiterResolverDecisionOrderingByIdentifier,
+} ArbiterResolverDecisionOrdering;
+
+/**
+ * A snapshot of the progress of dependency resolution.
+ */
+typedef struct
+{
+  /**
+   * The number of levels of the dependency graph currently being explored.
+   */
+  size_t depth;
+
+  /**
+   * The number of projects whose versions are currently decided.
+   */
+  size_t decisions;
+
+  /**
+   * The total number of candidate versions which have been tried so far.
+   */
+  size_t candidates;
+
+  /**
+   * The total number of times that the resolver has backtracked after
+   * a conflict so far.
+   */
+  size_t backtracks;
+} ArbiterResolverProgress;
+
 /**
  * User-provided behaviors for how dependency resolution should work.
  */
@@ -64,8 +142,64 @@ typedef struct
    * could not be found.
    */
   struct ArbiterSelectedVersion *(*createSelectedVersionForMetadata)(const ArbiterResolver *resolver, const void *metadata);
+
+  /**
+   * Asynchronously requests the list of dependencies needed by a specific
+   * version of a project.
+   *
+   * This behavior should return immediately, and later pass `completion` to
+   * ArbiterResolverCompleteDependencyList() from any thread. The resolver may
+   * have many requests outstanding at once, and may request lists it
+   * ultimately does not use.
+   *
+   * This behavior is optional. If set, it is used instead of
+   * `createDependencyList`, which may then be NULL.
+   */
+  void (*requestDependencyList)(const ArbiterResolver *resolver, const struct ArbiterProjectIdentifier *project, const struct ArbiterSelectedVersion *selectedVersion, ArbiterResolverCompletion *completion);
+
+  /**
+   * Asynchronously requests the list of versions available for a given
+   * project.
+   *
+   * This behavior should return immediately, and later pass `completion` to
+   * ArbiterResolverCompleteAvailableVersionsList() from any thread. The
+   * resolver may have many requests outstanding at once, and may request lists
+   * it ultimately does not use.
+   *
+   * This behavior is optional. If set, it is used instead of
+   * `createAvailableVersionsList`, which may then be NULL.
+   */
+  void (*requestAvailableVersionsList)(const ArbiterResolver *resolver, const struct ArbiterProjectIdentifier *project, ArbiterResolverCompletion *completion);
 } ArbiterResolverBehaviors;
 
+/**
+ * Delivers the result of a `requestDependencyList` behavior, and frees
+ * `completion`.
+ *
+ * On success, `dependencyList` should be non-NULL, and the resolver becomes
+ * responsible for freeing it. On failure, `dependencyList` should be NULL, and
+ * `error` may be set to a string describing the error, which the resolver
+ * becomes responsible for freeing.
+ *
+ * This function may be called from any thread, but must be called before the
+ * resolver is freed.
+ */
+void ArbiterResolverCompleteDependencyList (ArbiterResolverCompletion *completion, struct ArbiterDependencyList *dependencyList, char *error);
+
+/**
+ * Delivers the result of a `requestAvailableVersionsList` behavior, and frees
+ * `completion`.
+ *
+ * On success, `versionList` should be non-NULL, and the resolver becomes
+ * responsible for freeing it. On failure, `versionList` should be NULL, and
+ * `error` may be set to a string describing the error, which the resolver
+ * becomes responsible for freeing.
+ *
+ * This function may be called from any thread, but must be called before the
+ * resolver is freed.
+ */
+void ArbiterResolverCompleteAvailableVersionsList (ArbiterResolverCompletion *completion, struct ArbiterSelectedVersionList *versionList, char *error);
+
 /**
  * Creates a dependency resolver, implemented using the given behaviors, which
  * will attempt to pick compatible versions of all dependencies in
@@ -75,6 +209,30 @@ typedef struct
  */
 ArbiterResolver *ArbiterCreateResolver (ArbiterResolverBehaviors behaviors, const struct ArbiterDependencyList *dependencyList, const void *context);
 
+/**
+ * Creates an empty cache to share between resolvers.
+ *
+ * The cache is reference-counted: each resolver created with it keeps it
+ * alive, as does each copy made with ArbiterCreateCopy(). The returned
+ * reference must be freed with ArbiterFree().
+ */
+ArbiterResolverCache *ArbiterCreateResolverCache (void);
+
+/**
+ * Like ArbiterCreateResolver(), but the resolver fetches available versions
+ * and dependencies through `cache`, which may be shared with other resolvers
+ * (including those resolving concurrently on other threads).
+ *
+ * A list is requested from the behaviors of whichever resolver needs it first.
+ * Any other resolver which needs it while that request is outstanding waits
+ * for its result, rather than invoking its own behaviors, so resolvers sharing
+ * a cache must have behaviors which return the same lists for the same
+ * projects and versions. Failed requests are not cached.
+ *
+ * The returned dependency resolver must be freed with ArbiterFree().
+ */
+ArbiterResolver *ArbiterCreateResolverWithCache (ArbiterResolverBehaviors behaviors, const struct ArbiterDependencyList *dependencyList, const void *context, const ArbiterResolverCache *cache);
+
 /**
  * Returns any context data which was provided to ArbiterCreateResolver().
  *
@@ -93,6 +251,288 @@ const void *ArbiterResolverContext (const ArbiterResolver *resolver);
  */
 struct ArbiterResolvedDependencyGraph *ArbiterResolverCreateResolvedDependencyGraph (ArbiterResolver *resolver, char **error);
 
+/**
+ * Attempts to resolve all dependencies of each of `count` root dependency
+ * lists, in place of the resolver's own dependency list.
+ *
+ * The dependency lists are resolved together, sharing everything fetched from
+ * the resolver behaviors, the requirements computed from them, and the
+ * conflicts learned along the way, so resolving many lists which depend upon
+ * the same projects is much cheaper than resolving each with a separate
+ * resolver. If ArbiterResolverSetThreadCount() has been given a count greater
+ * than one, up to that many lists are resolved at once, each on its own
+ * thread. Limits set with ArbiterResolverSetTimeLimit() and
+ * ArbiterResolverSetCandidateLimit() apply to each list separately.
+ *
+ * For each index, `graphs` is set to the graph of resolved dependencies for
+ * that dependency list, which the caller is responsible for freeing, or NULL
+ * if an error occurred. If `errors` is not NULL, it is set at the same index
+ * to NULL or to a string describing the error, which the caller is
+ * responsible for freeing. Both arrays must have room for `count` elements.
+ *
+ * Returns the number of dependency lists which were resolved successfully.
+ */
+size_t ArbiterResolverCreateResolvedDependencyGraphs (ArbiterResolver *resolver, const struct ArbiterDependencyList * const *dependencyLists, size_t count, struct ArbiterResolvedDependencyGraph **graphs, char **errors);
+
+/**
+ * Checks that a proposed dependency graph, such as one recorded in a lockfile,
+ * satisfies every requirement in the resolver's dependency list and in the
+ * dependency lists of the versions it contains, without searching for any
+ * alternatives.
+ *
+ * Only the dependency lists of versions reachable from the root dependency
+ * list are requested, each at most once, so verification takes time linear
+ * in the size of the graph.
+ *
+ * Returns the verified graph, containing only the projects which are actually
+ * required, which the caller is responsible for freeing. If any requirement is
+ * violated, returns NULL, and if `violations` is not NULL, sets it to a list of
+ * every violated requirement that was found, which the caller is responsible
+ * for freeing. If NULL is returned for any other reason and `error` is not
+ * NULL, it may be set to a string describing the error, which the caller is
+ * responsible for freeing.
+ */
+struct ArbiterResolvedDependencyGraph *ArbiterResolverCreateVerifiedDependencyGraph (ArbiterResolver *resolver, const struct ArbiterResolvedDependencyGraph *graph, ArbiterResolverViolationList **violations, char **error);
+
+/**
+ * Returns the number of violations in the given list.
+ */
+size_t ArbiterResolverViolationListCount (const ArbiterResolverViolationList *violations);
+
+/**
+ * Returns the violation at the given index of the list.
+ *
+ * The returned pointer is only guaranteed to remain valid until the list is
+ * freed.
+ */
+const ArbiterResolverViolation *ArbiterResolverViolationListGet (const ArbiterResolverViolationList *violations, size_t index);
+
+/**
+ * Returns the resolved dependency whose dependency list contains the violated
+ * requirement, or NULL if the requirement came from the resolver's own
+ * dependency list.
+ *
+ * The returned pointer is only guaranteed to remain valid until the violation
+ * is freed.
+ */
+const struct ArbiterResolvedDependency *ArbiterResolverViolationDependent (const ArbiterResolverViolation *violation);
+
+/**
+ * Returns the dependency which was violated.
+ *
+ * The returned pointer is only guaranteed to remain valid until the violation
+ * is freed.
+ */
+const struct ArbiterDependency *ArbiterResolverViolationDependency (const ArbiterResolverViolation *violation);
+
+/**
+ * Returns the version which the proposed graph contained for the required
+ * project, or NULL if the project was missing from the graph.
+ *
+ * The returned pointer is only guaranteed to remain valid until the violation
+ * is freed.
+ */
+const struct ArbiterSelectedVersion *ArbiterResolverViolationSelectedVersion (const ArbiterResolverViolation *violation);
+
+/**
+ * Begins resolving all dependencies on a background thread, for use with
+ * asynchronous resolver behaviors.
+ *
+ * Once resolution has finished, the file descriptor returned by
+ * ArbiterResolverEventFileDescriptor() becomes readable, and the result can be
+ * retrieved with ArbiterResolverFinishResolving(). Freeing the resolver before
+ * then cancels resolution, without waiting for outstanding requests.
+ *
+ * Returns whether resolution was started. If false is returned and `error` is
+ * not NULL, it may be set to a string describing the error, which the caller
+ * is responsible for freeing.
+ */
+bool ArbiterResolverStartResolving (ArbiterResolver *resolver, char **error);
+
+/**
+ * Returns a file descriptor which becomes readable once resolution started
+ * with ArbiterResolverStartResolving() has finished, suitable for use with
+ * select(), poll(), epoll, and similar APIs. Returns -1 if resolution has not
+ * been started.
+ *
+ * The file descriptor is owned by the resolver, and must not be read from or
+ * closed.
+ */
+int ArbiterResolverEventFileDescriptor (const ArbiterResolver *resolver);
+
+/**
+ * Waits for resolution started with ArbiterResolverStartResolving() to finish,
+ * and returns its result, with the same semantics as
+ * ArbiterResolverCreateResolvedDependencyGraph().
+ *
+ * This will not block if the file descriptor returned by
+ * ArbiterResolverEventFileDescriptor() is already readable.
+ */
+struct ArbiterResolvedDependencyGraph *ArbiterResolverFinishResolving (ArbiterResolver *resolver, char **error);
+
+/**
+ * Sets the number of threads that the resolver may use to explore possible
+ * dependency graphs in parallel. A count of zero or one (the default) resolves
+ * sequentially on the calling thread.
+ *
+ * Parallel resolution always produces the same result (or error) as sequential
+ * resolution would. The resolver behaviors may be invoked from any of the
+ * threads, but never concurrently (unless permitted by
+ * ArbiterResolverSetFetchThreadCount()). Custom requirement predicates and the
+ * callbacks of user values may be invoked concurrently, and must be
+ * thread-safe.
+ */
+void ArbiterResolverSetThreadCount (ArbiterResolver *resolver, size_t threadCount);
+
+/**
+ * Sets the maximum number of threads that the resolver may use to request
+ * dependency lists from the synchronous `createDependencyList` behavior
+ * concurrently. Once versions have been chosen for every project at one level
+ * of the dependency graph, the dependency lists for all of them are requested
+ * at once.
+ *
+ * A count of zero or one (the default) makes requests one at a time. If
+ * greater than one, `createDependencyList` must be thread-safe. This setting
+ * has no effect when using the asynchronous `requestDependencyList` behavior.
+ */
+void ArbiterResolverSetFetchThreadCount (ArbiterResolver *resolver, size_t threadCount);
+
+/**
+ * Sets the heuristic used to decide which project's version to choose next.
+ *
+ * The ordering affects how quickly a solution is found, and may affect which
+ * solution is found if several are possible.
+ */
+void ArbiterResolverSetDecisionOrdering (ArbiterResolver *resolver, ArbiterResolverDecisionOrdering ordering);
+
+/**
+ * Limits each resolution to the given number of seconds of wall-clock time,
+ * after which it fails with an error. A limit of zero (the default) allows
+ * resolution to run indefinitely.
+ *
+ * The limit is checked between candidate versions, so it cannot interrupt a
+ * slow resolver behavior.
+ */
+void ArbiterResolverSetTimeLimit (ArbiterResolver *resolver, double seconds);
+
+/**
+ * Limits each resolution to trying the given number of candidate versions,
+ * after which it fails with an error. A limit of zero (the default) allows any
+ * number of candidates.
+ */
+void ArbiterResolverSetCandidateLimit (ArbiterResolver *resolver, size_t limit);
+
+/**
+ * Cancels any ongoing resolution, which will fail with an error once it next
+ * checks for cancellation or at once if it is waiting for an asynchronous
+ * request, and causes any later resolution with this resolver
+ * to fail in the same way.
+ *
+ * This function may be called from any thread.
+ */
+void ArbiterResolverCancel (ArbiterResolver *resolver);
+
+/**
+ * Sets a callback to report the progress of resolution to, at most once every
+ * `interval` seconds. `callback` may be NULL to stop reporting progress.
+ *
+ * The callback is invoked on whichever thread is resolving, but never
+ * concurrently, and must not free the resolver.
+ */
+void ArbiterResolverSetProgressCallback (ArbiterResolver *resolver, void (*callback)(const ArbiterResolver *resolver, const ArbiterResolverProgress *progress), double interval);
+
+/**
+ * Seeds the resolver with the result of a previous resolution, such as one
+ * recorded in a lockfile, replacing any previously preferred versions.
+ *
+ * Each version in `graph` is tried first for its project, and will be chosen
+ * again as long as it still satisfies every requirement upon it. The available
+ * versions of that project are not requested unless the preferred version has
+ * to be reconsidered.
+ *
+ * Resolution still walks the whole dependency graph, and still requests the
+ * dependency list of every version chosen, so it saves requests for version
+ * lists rather than making the work proportional to what has changed.
+ *
+ * Preferred versions are assumed to still be available. `graph` may be NULL to
+ * clear any preferences.
+ */
+void ArbiterResolverSetPreviousResolvedDependencyGraph (ArbiterResolver *resolver, const struct ArbiterResolvedDependencyGraph *graph);
+
+/**
+ * Like ArbiterResolverSetPreviousResolvedDependencyGraph(), but accepts the
+ * previous result as an array of `count` resolved dependencies, for when the
+ * structure of the graph was not recorded.
+ */
+void ArbiterResolverSetPreferredVersions (ArbiterResolver *resolver, const struct ArbiterResolvedDependency * const *dependencies, size_t count);
+
+/**
+ * Writes the incompatibilities learned by the resolver so far to the file at
+ * `path`, replacing its contents, so that they can be loaded into a later
+ * resolver with ArbiterResolverLoadIncompatibilities().
+ *
+ * Only incompatibilities whose projects, versions, and requirements all have
+ * user-provided descriptions can be saved. Incompatibilities involving custom
+ * requirements are skipped.
+ *
+ * Returns whether saving succeeded. If false is returned and `error` is not
+ * NULL, it may be set to a string describing the error, which the caller is
+ * responsible for freeing.
+ */
+bool ArbiterResolverSaveIncompatibilities (const ArbiterResolver *resolver, const char *path, char **error);
+
+/**
+ * Reads incompatibilities previously written by
+ * ArbiterResolverSaveIncompatibilities() from the file at `path`, and adds
+ * them to the resolver.
+ *
+ * Loaded incompatibilities are matched against projects by description, and
+ * only take effect once the resolver has verified that the available versions
+ * and dependencies they were derived from have not changed. Stale
+ * incompatibilities are discarded.
+ *
+ * Returns whether loading succeeded. If false is returned and `error` is not
+ * NULL, it may be set to a string describing the error, which the caller is
+ * responsible for freeing.
+ */
+bool ArbiterResolverLoadIncompatibilities (ArbiterResolver *resolver, const char *path, char **error);
+
+/**
+ * Writes every list of available versions and of dependencies which the
+ * resolver has fetched so far to the file at `path`, replacing its contents,
+ * so that a later resolver can load them with
+ * ArbiterResolverLoadBehaviorCache() instead of invoking its behaviors.
+ * Results from any cache the resolver loaded are carried over as well.
+ *
+ * Only lists whose project identifiers, version metadata, and requirements can
+ * all be serialized (see ArbiterUserValue.createSerialization) are saved.
+ * Lists involving custom requirements are skipped.
+ *
+ * Returns whether saving succeeded. If false is returned and `error` is not
+ * NULL, it may be set to a string describing the error, which the caller is
+ * responsible for freeing.
+ */
+bool ArbiterResolverSaveBehaviorCache (const ArbiterResolver *resolver, const char *path, char **error);
+
+/**
+ * Maps the behavior cache previously written by
+ * ArbiterResolverSaveBehaviorCache() at `path` into memory, so that the
+ * resolver consults it before requesting any list of available versions or of
+ * dependencies from its behaviors.
+ *
+ * Project identifiers read from the cache are recreated with
+ * `projectDeserializer`, and version metadata with `metadataDeserializer`.
+ *
+ * Cached lists are used as-is, without asking the behaviors whether they have
+ * changed, so the cache should not be loaded when fresh results are needed.
+ * Individual lists which have been damaged are ignored.
+ *
+ * Returns whether loading succeeded. If false is returned and `error` is not
+ * NULL, it may be set to a string describing the error, which the caller is
+ * responsible for freeing.
+ */
+bool ArbiterResolverLoadBehaviorCache (ArbiterResolver *resolver, const char *path, ArbiterUserValueDeserializer projectDeserializer, ArbiterUserValueDeserializer metadataDeserializer, char **error);
+
 #ifdef __cplusplus
 }
 #endif
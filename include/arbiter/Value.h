@@ -62,8 +62,29 @@ typedef struct
    * This may be NULL.
    */
   void (*destructor)(void *data);
+
+  /**
+   * An operation to convert this data object to bytes, from which an
+   * equivalent object can later be recreated with an
+   * ArbiterUserValueDeserializer. The returned value must be dynamically
+   * allocated and support being destroyed with free(), and its length must be
+   * written to `length`.
+   *
+   * This may be NULL, in which case results involving the value cannot be
+   * persisted.
+   */
+  void *(*createSerialization)(const void *data, size_t *length);
 } ArbiterUserValue;
 
+/**
+ * Recreates a data object from `length` bytes produced by the
+ * `createSerialization` operation of an ArbiterUserValue, filling in `value`
+ * with the new object and the operations upon it.
+ *
+ * Returns whether the object could be recreated.
+ */
+typedef bool (*ArbiterUserValueDeserializer)(const void *bytes, size_t length, ArbiterUserValue *value);
+
 #ifdef __cplusplus
 }
 #endif
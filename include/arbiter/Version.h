@@ -30,6 +30,15 @@ ArbiterSemanticVersion *ArbiterCreateSemanticVersion (unsigned major, unsigned m
  */
 ArbiterSemanticVersion *ArbiterCreateSemanticVersionFromString (const char *string);
 
+/**
+ * Attempts to parse the `length` characters starting at `string` into a
+ * semantic version, returning NULL if a parse failure occurs. The string does
+ * not need to be NUL-terminated.
+ *
+ * The returned version must be freed with ArbiterFree().
+ */
+ArbiterSemanticVersion *ArbiterCreateSemanticVersionFromStringWithLength (const char *string, size_t length);
+
 /**
  * Returns the major version number (X.y.z) from a semantic version.
  */
@@ -127,6 +136,22 @@ typedef struct ArbiterSelectedVersionList ArbiterSelectedVersionList;
  */
 ArbiterSelectedVersionList *ArbiterCreateSelectedVersionList (const ArbiterSelectedVersion * const *versions, size_t count);
 
+/**
+ * Parses each of the `count` strings in `strings` as a semantic version, and
+ * creates a version list containing a selected version for each one which
+ * parses successfully, associated with the corresponding entry in `metadata`.
+ * Strings which are not valid semantic versions are skipped.
+ *
+ * `lengths` may be NULL if every string is NUL-terminated. Otherwise, it
+ * provides the length of each string.
+ *
+ * Every value in `metadata` is owned by Arbiter after this call, including
+ * those for skipped strings.
+ *
+ * The returned list must be freed with ArbiterFree().
+ */
+ArbiterSelectedVersionList *ArbiterCreateSelectedVersionListFromStrings (const char * const *strings, const size_t *lengths, const ArbiterUserValue *metadata, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,654 @@
+#include "BehaviorCache.h"
+
+#include "Exception.h"
+#include "Requirement.h"
+#include "ToString.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Arbiter;
+using namespace Resolver;
+
+namespace {
+
+const char cacheMagic[8] = {'a', 'r', 'b', 'i', 't', 'e', 'r', 'c'};
+const uint32_t cacheVersion = 1;
+
+/**
+ * Integers are written in native byte order, so this distinguishes files
+ * written on a machine with the opposite byte order.
+ */
+const uint32_t cacheByteOrder = 0x01020304;
+
+/**
+ * The beginning of a cache file, which is followed immediately by
+ * `_recordCount` IndexEntries, then the records themselves.
+ */
+struct Header final
+{
+  public:
+    char _magic[8];
+    uint32_t _version;
+    uint32_t _byteOrder;
+    uint64_t _recordCount;
+    uint64_t _indexChecksum;
+};
+
+/**
+ * Locates a record, which consists of the length of its key as a uint32_t,
+ * the key, and then the payload.
+ */
+struct IndexEntry final
+{
+  public:
+    uint64_t _keyHash;
+    uint64_t _offset;
+    uint64_t _length;
+    uint64_t _checksum;
+};
+
+static_assert(sizeof(Header) == 32 && sizeof(IndexEntry) == 32, "Cache file structures must not be padded");
+
+enum class RecordKind : unsigned char
+{
+  AvailableVersions = 1,
+  Dependencies = 2,
+};
+
+/**
+ * Computes a 64-bit FNV-1a hash of the given bytes.
+ */
+uint64_t checksum (const char *bytes, size_t length) noexcept
+{
+  uint64_t hash = UINT64_C(14695981039346656037);
+
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(bytes[i]);
+    hash *= UINT64_C(1099511628211);
+  }
+
+  return hash;
+}
+
+uint64_t checksum (const std::string &string) noexcept
+{
+  return checksum(string.data(), string.size());
+}
+
+template<typename T>
+T load (const char *bytes) noexcept
+{
+  // The mapping may not be suitably aligned for T.
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+template<typename T>
+void store (std::string &bytes, const T &value)
+{
+  bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/**
+ * Appends the serialized form of data types to a string.
+ */
+class Encoder final
+{
+  public:
+    std::string _bytes;
+
+    void appendByte (unsigned char value)
+    {
+      _bytes += static_cast<char>(value);
+    }
+
+    void appendBytes (const std::string &bytes)
+    {
+      store(_bytes, static_cast<uint32_t>(bytes.size()));
+      _bytes += bytes;
+    }
+
+    template<typename Owner>
+    bool appendValue (const SharedUserValue<Owner> &value)
+    {
+      Optional<std::string> serialization = value.serialization();
+      if (!serialization) {
+        return false;
+      }
+
+      appendBytes(*serialization);
+      return true;
+    }
+
+    bool appendVersion (const ArbiterSelectedVersion &version)
+    {
+      if (version._semanticVersion) {
+        appendByte(1);
+        appendBytes(toString(*version._semanticVersion));
+      } else {
+        appendByte(0);
+      }
+
+      return appendValue(version._metadata);
+    }
+
+    bool appendRequirement (const ArbiterRequirement &requirement)
+    {
+      appendByte(static_cast<unsigned char>(requirement.kind()));
+
+      if (requirement.kind() == Requirement::Kind::Any) {
+        return true;
+      } else if (const auto *atLeast = Requirement::requirementCast<Requirement::AtLeast>(requirement)) {
+        appendBytes(toString(atLeast->_minimumVersion));
+        return true;
+      } else if (const auto *compatibleWith = Requirement::requirementCast<Requirement::CompatibleWith>(requirement)) {
+        appendBytes(toString(compatibleWith->_baseVersion));
+        appendByte(static_cast<unsigned char>(compatibleWith->_strictness));
+        return true;
+      } else if (const auto *exactly = Requirement::requirementCast<Requirement::Exactly>(requirement)) {
+        appendBytes(toString(exactly->_version));
+        return true;
+      } else if (const auto *unversioned = Requirement::requirementCast<Requirement::Unversioned>(requirement)) {
+        return appendValue(unversioned->_metadata);
+      } else if (const auto *compound = Requirement::requirementCast<Requirement::Compound>(requirement)) {
+        store(_bytes, static_cast<uint32_t>(compound->_requirements.size()));
+
+        for (const auto &child : compound->_requirements) {
+          if (!appendRequirement(*child)) {
+            return false;
+          }
+        }
+
+        return true;
+      } else {
+        // Custom predicates cannot be persisted.
+        return false;
+      }
+    }
+};
+
+/**
+ * Reads data types back out of bytes written by an Encoder.
+ *
+ * Throws Exception::PersistenceError if the bytes are malformed.
+ */
+class Decoder final
+{
+  public:
+    Decoder (const char *bytes, size_t length, ArbiterUserValueDeserializer projectDeserializer, ArbiterUserValueDeserializer metadataDeserializer)
+      : _position(bytes)
+      , _end(bytes + length)
+      , _projectDeserializer(projectDeserializer)
+      , _metadataDeserializer(metadataDeserializer)
+    {}
+
+    bool atEnd () const noexcept
+    {
+      return _position == _end;
+    }
+
+    unsigned char readByte () noexcept(false)
+    {
+      return static_cast<unsigned char>(*take(1));
+    }
+
+    uint32_t readCount () noexcept(false)
+    {
+      return load<uint32_t>(take(sizeof(uint32_t)));
+    }
+
+    std::string readBytes () noexcept(false)
+    {
+      const uint32_t length = readCount();
+      return std::string(take(length), length);
+    }
+
+    template<typename Owner>
+    SharedUserValue<Owner> readValue (ArbiterUserValueDeserializer deserializer) noexcept(false)
+    {
+      const std::string bytes = readBytes();
+
+      ArbiterUserValue value;
+      if (!deserializer || !deserializer(bytes.data(), bytes.size(), &value)) {
+        throw Exception::PersistenceError("Could not deserialize value");
+      }
+
+      return SharedUserValue<Owner>(value);
+    }
+
+    ArbiterSemanticVersion readSemanticVersion () noexcept(false)
+    {
+      const std::string string = readBytes();
+
+      Optional<ArbiterSemanticVersion> version = ArbiterSemanticVersion::fromString(string.data(), string.size());
+      if (!version) {
+        throw Exception::PersistenceError("Malformed semantic version " + string);
+      }
+
+      return std::move(*version);
+    }
+
+    ArbiterSelectedVersion readVersion () noexcept(false)
+    {
+      Optional<ArbiterSemanticVersion> semanticVersion;
+      if (readByte()) {
+        semanticVersion = readSemanticVersion();
+      }
+
+      return ArbiterSelectedVersion(std::move(semanticVersion), readValue<ArbiterSelectedVersion>(_metadataDeserializer));
+    }
+
+    std::shared_ptr<const ArbiterRequirement> readRequirement () noexcept(false)
+    {
+      switch (static_cast<Requirement::Kind>(readByte())) {
+        case Requirement::Kind::Any:
+          return std::make_shared<Requirement::Any>();
+
+        case Requirement::Kind::AtLeast:
+          return std::make_shared<Requirement::AtLeast>(readSemanticVersion());
+
+        case Requirement::Kind::CompatibleWith: {
+          ArbiterSemanticVersion version = readSemanticVersion();
+          const unsigned char strictness = readByte();
+          if (strictness > ArbiterRequirementStrictnessAllowVersionZeroPatches) {
+            throw Exception::PersistenceError("Malformed requirement strictness");
+          }
+
+          return std::make_shared<Requirement::CompatibleWith>(std::move(version), static_cast<ArbiterRequirementStrictness>(strictness));
+        }
+
+        case Requirement::Kind::Exactly:
+          return std::make_shared<Requirement::Exactly>(readSemanticVersion());
+
+        case Requirement::Kind::Unversioned:
+          return std::make_shared<Requirement::Unversioned>(readValue<ArbiterSelectedVersion>(_metadataDeserializer));
+
+        case Requirement::Kind::Compound: {
+          std::vector<std::shared_ptr<const ArbiterRequirement>> requirements;
+
+          for (uint32_t count = readCount(); count > 0; --count) {
+            requirements.emplace_back(readRequirement()->intern());
+          }
+
+          return std::make_shared<Requirement::Compound>(std::move(requirements));
+        }
+
+        default:
+          throw Exception::PersistenceError("Malformed requirement");
+      }
+    }
+
+    ArbiterSelectedVersionList readVersionList () noexcept(false)
+    {
+      std::vector<ArbiterSelectedVersion> versions;
+
+      for (uint32_t count = readCount(); count > 0; --count) {
+        versions.emplace_back(readVersion());
+      }
+
+      return ArbiterSelectedVersionList(std::move(versions));
+    }
+
+    ArbiterDependencyList readDependencyList () noexcept(false)
+    {
+      std::vector<ArbiterDependency> dependencies;
+
+      for (uint32_t count = readCount(); count > 0; --count) {
+        ArbiterProjectIdentifier project(readValue<ArbiterProjectIdentifier>(_projectDeserializer));
+        dependencies.emplace_back(std::move(project), *readRequirement());
+      }
+
+      return ArbiterDependencyList(std::move(dependencies));
+    }
+
+  private:
+    const char *_position;
+    const char *_end;
+
+    ArbiterUserValueDeserializer _projectDeserializer;
+    ArbiterUserValueDeserializer _metadataDeserializer;
+
+    const char *take (size_t length) noexcept(false)
+    {
+      if (static_cast<size_t>(_end - _position) < length) {
+        throw Exception::PersistenceError("Unexpected end of record");
+      }
+
+      const char *bytes = _position;
+      _position += length;
+      return bytes;
+    }
+};
+
+Optional<std::string> availableVersionsKey (const ArbiterProjectIdentifier &project)
+{
+  Encoder encoder;
+  encoder.appendByte(static_cast<unsigned char>(RecordKind::AvailableVersions));
+
+  if (!encoder.appendValue(project._value)) {
+    return None();
+  }
+
+  return makeOptional(std::move(encoder._bytes));
+}
+
+Optional<std::string> dependenciesKey (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version)
+{
+  Encoder encoder;
+  encoder.appendByte(static_cast<unsigned char>(RecordKind::Dependencies));
+
+  if (!encoder.appendValue(project._value) || !encoder.appendVersion(version)) {
+    return None();
+  }
+
+  return makeOptional(std::move(encoder._bytes));
+}
+
+/**
+ * Writes all of `length` bytes to `fd`, retrying after short writes.
+ *
+ * Returns whether every byte was written.
+ */
+bool writeAll (int fd, const char *bytes, size_t length)
+{
+  while (length > 0) {
+    const ssize_t written = ::write(fd, bytes, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return false;
+    }
+
+    bytes += written;
+    length -= static_cast<size_t>(written);
+  }
+
+  return true;
+}
+
+} // namespace
+
+bool BehaviorCache::Builder::addAvailableVersions (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersionList &versionList)
+{
+  Optional<std::string> key = availableVersionsKey(project);
+  if (!key) {
+    return false;
+  }
+
+  Encoder encoder;
+  store(encoder._bytes, static_cast<uint32_t>(versionList._versions.size()));
+
+  for (const ArbiterSelectedVersion &version : versionList._versions) {
+    if (!encoder.appendVersion(version)) {
+      return false;
+    }
+  }
+
+  _records[std::move(*key)] = std::move(encoder._bytes);
+  return true;
+}
+
+bool BehaviorCache::Builder::addDependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version, const ArbiterDependencyList &dependencyList)
+{
+  Optional<std::string> key = dependenciesKey(project, version);
+  if (!key) {
+    return false;
+  }
+
+  Encoder encoder;
+  store(encoder._bytes, static_cast<uint32_t>(dependencyList._dependencies.size()));
+
+  for (const ArbiterDependency &dependency : dependencyList._dependencies) {
+    if (!encoder.appendValue(dependency._projectIdentifier._value) || !encoder.appendRequirement(dependency.requirement())) {
+      return false;
+    }
+  }
+
+  _records[std::move(*key)] = std::move(encoder._bytes);
+  return true;
+}
+
+void BehaviorCache::Builder::addRecords (const BehaviorCache &cache)
+{
+  for (size_t index = 0; index < cache._recordCount; ++index) {
+    if (Optional<std::pair<Bytes, Bytes>> record = cache.record(index)) {
+      const Bytes &key = record->first;
+      const Bytes &payload = record->second;
+
+      _records.emplace(std::string(key.first, key.second), std::string(payload.first, payload.second));
+    }
+  }
+}
+
+void BehaviorCache::Builder::write (const std::string &path) const noexcept(false)
+{
+  std::vector<IndexEntry> index;
+  index.reserve(_records.size());
+
+  std::string records;
+  uint64_t offset = sizeof(Header) + _records.size() * sizeof(IndexEntry);
+
+  for (const auto &pair : _records) {
+    const size_t begin = records.size();
+
+    store(records, static_cast<uint32_t>(pair.first.size()));
+    records += pair.first;
+    records += pair.second;
+
+    const size_t length = records.size() - begin;
+    index.emplace_back(IndexEntry{checksum(pair.first), offset, length, checksum(records.data() + begin, length)});
+    offset += length;
+  }
+
+  std::stable_sort(index.begin(), index.end(), [](const IndexEntry &lhs, const IndexEntry &rhs) {
+    return lhs._keyHash < rhs._keyHash;
+  });
+
+  const char *indexBytes = reinterpret_cast<const char *>(index.data());
+  const size_t indexLength = index.size() * sizeof(IndexEntry);
+
+  Header header;
+  std::memcpy(header._magic, cacheMagic, sizeof(cacheMagic));
+  header._version = cacheVersion;
+  header._byteOrder = cacheByteOrder;
+  header._recordCount = index.size();
+  header._indexChecksum = checksum(indexBytes, indexLength);
+
+  // Use a unique file in the same directory, so that concurrent writers don't
+  // clobber each other's output and the rename below stays atomic.
+  std::vector<char> temporaryPath(path.begin(), path.end());
+  const char suffix[] = ".XXXXXX";
+  temporaryPath.insert(temporaryPath.end(), suffix, suffix + sizeof(suffix));
+
+  const int fd = mkstemp(temporaryPath.data());
+  if (fd < 0) {
+    throw Exception::PersistenceError("Could not create a temporary file for " + path + ": " + std::strerror(errno));
+  }
+
+  // mkstemp() makes the file private to its owner, which is needlessly strict
+  // for a cache.
+  fchmod(fd, 0644);
+
+  // Flush the contents to disk before renaming, so that a crash cannot leave
+  // a truncated cache in place of the old one.
+  const bool written = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header))
+    && writeAll(fd, indexBytes, indexLength)
+    && writeAll(fd, records.data(), records.size())
+    && fsync(fd) == 0;
+
+  const int writeError = errno;
+
+  if (close(fd) != 0 || !written) {
+    unlink(temporaryPath.data());
+    throw Exception::PersistenceError("Could not write to " + std::string(temporaryPath.data()) + ": " + std::strerror(written ? errno : writeError));
+  }
+
+  if (std::rename(temporaryPath.data(), path.c_str()) != 0) {
+    const int renameError = errno;
+    unlink(temporaryPath.data());
+    throw Exception::PersistenceError("Could not replace " + path + ": " + std::strerror(renameError));
+  }
+}
+
+BehaviorCache::BehaviorCache (const std::string &path, ArbiterUserValueDeserializer projectDeserializer, ArbiterUserValueDeserializer metadataDeserializer) noexcept(false)
+  : _projectDeserializer(projectDeserializer)
+  , _metadataDeserializer(metadataDeserializer)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw Exception::PersistenceError("Could not open " + path + " for reading: " + std::strerror(errno));
+  }
+
+  struct stat status;
+  if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Header))) {
+    close(fd);
+    throw Exception::PersistenceError(path + " is not a behavior cache");
+  }
+
+  _size = static_cast<size_t>(status.st_size);
+  void *mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED) {
+    throw Exception::PersistenceError("Could not map " + path + ": " + std::strerror(errno));
+  }
+
+  _data = static_cast<const char *>(mapping);
+
+  const Header header = load<Header>(_data);
+  const char *error = nullptr;
+
+  if (std::memcmp(header._magic, cacheMagic, sizeof(cacheMagic)) != 0) {
+    error = " is not a behavior cache";
+  } else if (header._version != cacheVersion || header._byteOrder != cacheByteOrder) {
+    error = " has an unsupported version";
+  } else if (header._recordCount > (_size - sizeof(Header)) / sizeof(IndexEntry)) {
+    error = " is truncated";
+  } else if (checksum(_data + sizeof(Header), header._recordCount * sizeof(IndexEntry)) != header._indexChecksum) {
+    error = " has a damaged index";
+  }
+
+  if (error) {
+    munmap(const_cast<char *>(_data), _size);
+    throw Exception::PersistenceError(path + error);
+  }
+
+  _recordCount = header._recordCount;
+}
+
+BehaviorCache::~BehaviorCache ()
+{
+  munmap(const_cast<char *>(_data), _size);
+}
+
+Optional<std::pair<BehaviorCache::Bytes, BehaviorCache::Bytes>> BehaviorCache::record (size_t index) const noexcept
+{
+  const IndexEntry entry = load<IndexEntry>(_data + sizeof(Header) + index * sizeof(IndexEntry));
+  const uint64_t recordsBegin = sizeof(Header) + _recordCount * sizeof(IndexEntry);
+
+  if (entry._offset < recordsBegin || entry._offset > _size || entry._length > _size - entry._offset || entry._length < sizeof(uint32_t)) {
+    return None();
+  }
+
+  const char *bytes = _data + entry._offset;
+  if (checksum(bytes, entry._length) != entry._checksum) {
+    return None();
+  }
+
+  const uint32_t keyLength = load<uint32_t>(bytes);
+  if (keyLength > entry._length - sizeof(uint32_t)) {
+    return None();
+  }
+
+  const char *key = bytes + sizeof(uint32_t);
+  const char *payload = key + keyLength;
+
+  return makeOptional(std::make_pair(Bytes(key, keyLength), Bytes(payload, bytes + entry._length - payload)));
+}
+
+Optional<BehaviorCache::Bytes> BehaviorCache::find (const std::string &key) const noexcept
+{
+  const uint64_t keyHash = checksum(key);
+
+  const auto keyHashAt = [this](size_t index) {
+    return load<IndexEntry>(_data + sizeof(Header) + index * sizeof(IndexEntry))._keyHash;
+  };
+
+  // Binary search for the first entry with this hash.
+  size_t begin = 0;
+  size_t end = _recordCount;
+
+  while (begin < end) {
+    const size_t middle = begin + (end - begin) / 2;
+
+    if (keyHashAt(middle) < keyHash) {
+      begin = middle + 1;
+    } else {
+      end = middle;
+    }
+  }
+
+  for (size_t index = begin; index < _recordCount && keyHashAt(index) == keyHash; ++index) {
+    Optional<std::pair<Bytes, Bytes>> record = this->record(index);
+    if (record && record->first.second == key.size() && std::memcmp(record->first.first, key.data(), key.size()) == 0) {
+      return makeOptional(record->second);
+    }
+  }
+
+  return None();
+}
+
+std::shared_ptr<const ArbiterSelectedVersionList> BehaviorCache::availableVersions (const ArbiterProjectIdentifier &project) const
+{
+  Optional<std::string> key = availableVersionsKey(project);
+  if (!key) {
+    return nullptr;
+  }
+
+  Optional<Bytes> payload = find(*key);
+  if (!payload) {
+    return nullptr;
+  }
+
+  try {
+    Decoder decoder(payload->first, payload->second, _projectDeserializer, _metadataDeserializer);
+    auto versionList = std::make_shared<const ArbiterSelectedVersionList>(decoder.readVersionList());
+    return decoder.atEnd() ? versionList : nullptr;
+  } catch (const Exception::PersistenceError &) {
+    return nullptr;
+  }
+}
+
+std::shared_ptr<const ArbiterDependencyList> BehaviorCache::dependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version) const
+{
+  Optional<std::string> key = dependenciesKey(project, version);
+  if (!key) {
+    return nullptr;
+  }
+
+  Optional<Bytes> payload = find(*key);
+  if (!payload) {
+    return nullptr;
+  }
+
+  try {
+    Decoder decoder(payload->first, payload->second, _projectDeserializer, _metadataDeserializer);
+    auto dependencyList = std::make_shared<const ArbiterDependencyList>(decoder.readDependencyList());
+    return decoder.atEnd() ? dependencyList : nullptr;
+  } catch (const Exception::PersistenceError &) {
+    return nullptr;
+  }
+}
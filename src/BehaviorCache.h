@@ -0,0 +1,144 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include <arbiter/Value.h>
+
+#include "Dependency.h"
+#include "Optional.h"
+#include "Version.h"
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace Arbiter {
+namespace Resolver {
+
+/**
+ * A read-only, memory-mapped file of version lists and dependency lists
+ * previously returned by the resolver behaviors, so that a later resolver can
+ * start without requesting them again.
+ *
+ * The file begins with an index of records sorted by the hash of their keys,
+ * so opening it reads only the index. Each record has its own checksum, which
+ * is verified when it's looked up; records which fail verification are
+ * treated as though they were missing.
+ */
+class BehaviorCache final
+{
+  public:
+    /**
+     * The records to be written to a cache file.
+     */
+    class Builder final
+    {
+      public:
+        /**
+         * Adds the available versions of `project`.
+         *
+         * Returns false (and adds nothing) if any of the values involved
+         * cannot be serialized.
+         */
+        bool addAvailableVersions (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersionList &versionList);
+
+        /**
+         * Adds the dependencies of `version` of `project`.
+         *
+         * Returns false (and adds nothing) if any of the values or
+         * requirements involved cannot be serialized.
+         */
+        bool addDependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version, const ArbiterDependencyList &dependencyList);
+
+        /**
+         * Adds every intact record from `cache` which has not already been
+         * added.
+         */
+        void addRecords (const BehaviorCache &cache);
+
+        size_t size () const noexcept
+        {
+          return _records.size();
+        }
+
+        /**
+         * Writes the records to the file at `path`, replacing it.
+         *
+         * The file is written elsewhere and then moved into place, so any
+         * BehaviorCache which has mapped the old file remains valid.
+         *
+         * Throws Exception::PersistenceError if the file cannot be written.
+         */
+        void write (const std::string &path) const noexcept(false);
+
+      private:
+        /**
+         * The payload of each record, keyed by its encoded key.
+         */
+        std::map<std::string, std::string> _records;
+    };
+
+    /**
+     * Maps the cache file at `path` into memory. Project identifiers will be
+     * recreated with `projectDeserializer`, and version metadata with
+     * `metadataDeserializer`.
+     *
+     * Throws Exception::PersistenceError if the file cannot be read, or if its
+     * header or index are malformed.
+     */
+    BehaviorCache (const std::string &path, ArbiterUserValueDeserializer projectDeserializer, ArbiterUserValueDeserializer metadataDeserializer) noexcept(false);
+
+    BehaviorCache (const BehaviorCache &) = delete;
+    BehaviorCache &operator= (const BehaviorCache &) = delete;
+
+    ~BehaviorCache ();
+
+    /**
+     * Returns the number of records in the cache, whether intact or not.
+     */
+    size_t size () const noexcept
+    {
+      return _recordCount;
+    }
+
+    /**
+     * Returns the cached available versions of `project`, or nullptr if there
+     * are none or they could not be read.
+     */
+    std::shared_ptr<const ArbiterSelectedVersionList> availableVersions (const ArbiterProjectIdentifier &project) const;
+
+    /**
+     * Returns the cached dependencies of `version` of `project`, or nullptr if
+     * there are none or they could not be read.
+     */
+    std::shared_ptr<const ArbiterDependencyList> dependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version) const;
+
+  private:
+    using Bytes = std::pair<const char *, size_t>;
+
+    const char *_data;
+    size_t _size;
+    size_t _recordCount;
+
+    ArbiterUserValueDeserializer _projectDeserializer;
+    ArbiterUserValueDeserializer _metadataDeserializer;
+
+    /**
+     * Returns the key and payload of the record at `index` in the index, or
+     * None if the record is damaged.
+     */
+    Optional<std::pair<Bytes, Bytes>> record (size_t index) const noexcept;
+
+    /**
+     * Returns the payload of the intact record with the given key, or None if
+     * there is none.
+     */
+    Optional<Bytes> find (const std::string &key) const noexcept;
+};
+
+} // namespace Resolver
+} // namespace Arbiter
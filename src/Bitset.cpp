@@ -0,0 +1,86 @@
+#include "Bitset.h"
+
+#include <climits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace Arbiter;
+
+static_assert(sizeof(unsigned long long) * CHAR_BIT == 64, "Bitset words must be 64 bits");
+
+void Bitset::setRange (size_t begin, size_t end) noexcept
+{
+  assert(begin <= end && end <= _size);
+
+  while (begin < end && begin % wordBits != 0) {
+    set(begin++);
+  }
+
+  // Fill whole words at once.
+  while (end - begin >= wordBits) {
+    _words[begin / wordBits] = ~Word(0);
+    begin += wordBits;
+  }
+
+  while (begin < end) {
+    set(begin++);
+  }
+}
+
+size_t Bitset::count () const noexcept
+{
+  size_t count = 0;
+  for (Word word : _words) {
+    count += __builtin_popcountll(word);
+  }
+
+  return count;
+}
+
+bool Bitset::none () const noexcept
+{
+  const Word *words = _words.data();
+  const size_t wordCount = _words.size();
+  size_t i = 0;
+
+#ifdef __AVX2__
+  for (; i + 4 <= wordCount; i += 4) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i));
+    if (!_mm256_testz_si256(block, block)) {
+      return false;
+    }
+  }
+#endif
+
+  for (; i < wordCount; ++i) {
+    if (words[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void Bitset::intersect (const Bitset &other) noexcept
+{
+  assert(_size == other._size);
+
+  Word *lhs = _words.data();
+  const Word *rhs = other._words.data();
+  const size_t wordCount = _words.size();
+  size_t i = 0;
+
+#ifdef __AVX2__
+  for (; i + 4 <= wordCount; i += 4) {
+    const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i));
+    const __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lhs + i), _mm256_and_si256(left, right));
+  }
+#endif
+
+  for (; i < wordCount; ++i) {
+    lhs[i] &= rhs[i];
+  }
+}
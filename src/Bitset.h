@@ -0,0 +1,106 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Arbiter {
+
+/**
+ * A fixed-size set of bits.
+ *
+ * Intersection is vectorized with AVX2 when the library is built with it
+ * enabled (e.g., with `-mavx2`), and falls back to one machine word at a time
+ * otherwise.
+ */
+class Bitset final
+{
+  public:
+    Bitset () = default;
+
+    /**
+     * Creates a bitset of `size` bits, all of which are clear.
+     */
+    explicit Bitset (size_t size)
+      : _size(size)
+      , _words((size + wordBits - 1) / wordBits, 0)
+    {}
+
+    /**
+     * Returns the number of bits in the set, whether set or clear.
+     */
+    size_t size () const noexcept
+    {
+      return _size;
+    }
+
+    void set (size_t index) noexcept
+    {
+      assert(index < _size);
+      _words[index / wordBits] |= Word(1) << (index % wordBits);
+    }
+
+    /**
+     * Sets every bit from `begin` up to but not including `end`.
+     */
+    void setRange (size_t begin, size_t end) noexcept;
+
+    bool test (size_t index) const noexcept
+    {
+      assert(index < _size);
+      return (_words[index / wordBits] >> (index % wordBits)) & 1;
+    }
+
+    /**
+     * Returns the number of bits which are set.
+     */
+    size_t count () const noexcept;
+
+    /**
+     * Returns whether no bits are set.
+     */
+    bool none () const noexcept;
+
+    /**
+     * Clears every bit which is not also set in `other`, which must be the
+     * same size.
+     */
+    void intersect (const Bitset &other) noexcept;
+
+    /**
+     * Invokes `visitor` with the index of each set bit, from highest to
+     * lowest.
+     */
+    template<typename Visitor>
+    void forEachReversed (Visitor &&visitor) const
+    {
+      for (size_t i = _words.size(); i-- > 0; ) {
+        Word word = _words[i];
+
+        while (word) {
+          const unsigned bit = wordBits - 1 - __builtin_clzll(word);
+          visitor(i * wordBits + bit);
+          word &= ~(Word(1) << bit);
+        }
+      }
+    }
+
+    bool operator== (const Bitset &other) const noexcept
+    {
+      return _size == other._size && _words == other._words;
+    }
+
+  private:
+    using Word = unsigned long long;
+    static constexpr unsigned wordBits = 64;
+
+    size_t _size = 0;
+    std::vector<Word> _words;
+};
+
+} // namespace Arbiter
@@ -113,20 +113,9 @@ bool ArbiterProjectIdentifier::operator== (const Arbiter::Base &other) const
 
 ArbiterDependency::ArbiterDependency (ArbiterProjectIdentifier projectIdentifier, const ArbiterRequirement &requirement)
   : _projectIdentifier(std::move(projectIdentifier))
-  , _requirement(requirement.cloneRequirement())
+  , _requirement(requirement.intern())
 {}
 
-ArbiterDependency &ArbiterDependency::operator= (const ArbiterDependency &other)
-{
-  if (this == &other) {
-    return *this;
-  }
-
-  _projectIdentifier = other._projectIdentifier;
-  _requirement = other.requirement().cloneRequirement();
-  return *this;
-}
-
 std::unique_ptr<Arbiter::Base> ArbiterDependency::clone () const
 {
   return std::make_unique<ArbiterDependency>(*this);
@@ -144,7 +133,8 @@ bool ArbiterDependency::operator== (const Base &other) const
     return false;
   }
 
-  return _projectIdentifier == ptr->_projectIdentifier && *_requirement == *(ptr->_requirement);
+  // Interned requirements are equal only if they're identical.
+  return _projectIdentifier == ptr->_projectIdentifier && _requirement == ptr->_requirement;
 }
 
 std::unique_ptr<Arbiter::Base> ArbiterDependencyList::clone () const
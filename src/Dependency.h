@@ -49,17 +49,26 @@ struct ArbiterDependency final : public Arbiter::Base
 
     ArbiterDependency (ArbiterProjectIdentifier projectIdentifier, const ArbiterRequirement &requirement);
 
-    ArbiterDependency (const ArbiterDependency &other)
-      : ArbiterDependency(other._projectIdentifier, other.requirement())
-    {}
+    // Requirements are interned, so copies share them.
+    ArbiterDependency (const ArbiterDependency &) = default;
+    ArbiterDependency &operator= (const ArbiterDependency &) = default;
 
-    ArbiterDependency &operator= (const ArbiterDependency &other);
+    ArbiterDependency (ArbiterDependency &&) = default;
+    ArbiterDependency &operator= (ArbiterDependency &&) = default;
 
     const ArbiterRequirement &requirement() const noexcept
     {
       return *_requirement;
     }
 
+    /**
+     * Returns the interned requirement, which can be shared freely.
+     */
+    const std::shared_ptr<const ArbiterRequirement> &sharedRequirement () const noexcept
+    {
+      return _requirement;
+    }
+
     std::unique_ptr<Arbiter::Base> clone () const override;
     std::ostream &describe (std::ostream &os) const override;
     bool operator== (const Arbiter::Base &other) const override;
@@ -70,7 +79,7 @@ struct ArbiterDependency final : public Arbiter::Base
     }
 
   private:
-    std::unique_ptr<ArbiterRequirement> _requirement;
+    std::shared_ptr<const ArbiterRequirement> _requirement;
 };
 
 struct ArbiterDependencyList final : public Arbiter::Base
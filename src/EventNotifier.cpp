@@ -0,0 +1,62 @@
+#include "EventNotifier.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+using namespace Arbiter;
+
+EventNotifier::EventNotifier () noexcept(false)
+{
+#ifdef __linux__
+  _readDescriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (_readDescriptor < 0) {
+    throw std::system_error(errno, std::generic_category(), "eventfd()");
+  }
+
+  _writeDescriptor = _readDescriptor;
+#else
+  int descriptors[2];
+  if (pipe(descriptors) != 0) {
+    throw std::system_error(errno, std::generic_category(), "pipe()");
+  }
+
+  for (int descriptor : descriptors) {
+    fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+    fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+  }
+
+  _readDescriptor = descriptors[0];
+  _writeDescriptor = descriptors[1];
+#endif
+}
+
+EventNotifier::~EventNotifier ()
+{
+  if (_writeDescriptor != _readDescriptor) {
+    close(_writeDescriptor);
+  }
+
+  close(_readDescriptor);
+}
+
+void EventNotifier::signal () noexcept
+{
+#ifdef __linux__
+  const uint64_t value = 1;
+#else
+  const char value = 1;
+#endif
+
+  ssize_t result;
+  do {
+    result = write(_writeDescriptor, &value, sizeof(value));
+  } while (result < 0 && errno == EINTR);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+namespace Arbiter {
+
+/**
+ * A file descriptor which becomes readable once an event has occurred, for
+ * integration with select(), poll(), epoll, kqueue, and similar event loops.
+ *
+ * This uses an eventfd on Linux, and a pipe on other platforms.
+ */
+class EventNotifier final
+{
+  public:
+    /**
+     * Creates a notifier in the unsignaled state.
+     *
+     * Throws std::system_error if the file descriptor could not be created.
+     */
+    EventNotifier () noexcept(false);
+    ~EventNotifier ();
+
+    EventNotifier (const EventNotifier &) = delete;
+    EventNotifier &operator= (const EventNotifier &) = delete;
+
+    /**
+     * Returns the file descriptor to wait upon. It is owned by the notifier,
+     * and must not be closed or read from.
+     */
+    int fileDescriptor () const noexcept
+    {
+      return _readDescriptor;
+    }
+
+    /**
+     * Makes the file descriptor readable.
+     */
+    void signal () noexcept;
+
+  private:
+    int _readDescriptor = -1;
+    int _writeDescriptor = -1;
+};
+
+} // namespace Arbiter
@@ -64,6 +64,52 @@ struct UnsatisfiableConstraints final : Base
     {}
 };
 
+/**
+ * Exception type indicating that the selected versions of some projects
+ * depend upon each other in a cycle.
+ */
+struct DependencyCycle final : Base
+{
+  public:
+    explicit DependencyCycle (const std::string &string)
+      : Base(string)
+    {}
+};
+
+/**
+ * Exception type indicating that resolution was cancelled.
+ */
+struct Cancelled final : Base
+{
+  public:
+    explicit Cancelled (const std::string &string)
+      : Base(string)
+    {}
+};
+
+/**
+ * Exception type indicating that resolution exceeded one of the limits placed
+ * upon it.
+ */
+struct LimitExceeded final : Base
+{
+  public:
+    explicit LimitExceeded (const std::string &string)
+      : Base(string)
+    {}
+};
+
+/**
+ * Exception type indicating that persisted data could not be read or written.
+ */
+struct PersistenceError final : Base
+{
+  public:
+    explicit PersistenceError (const std::string &string)
+      : Base(string)
+    {}
+};
+
 }
 } // namespace Arbiter
 
@@ -0,0 +1,124 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include "Exception.h"
+#include "Optional.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+namespace Arbiter {
+
+/**
+ * The eventual result of an asynchronous request, which may be fulfilled with
+ * a value or rejected with an error message from any thread.
+ */
+template<typename T>
+class Future final
+{
+  public:
+    Future () = default;
+
+    Future (const Future &) = delete;
+    Future &operator= (const Future &) = delete;
+
+    /**
+     * Completes the future successfully. Has no effect if the future was
+     * already completed.
+     */
+    void fulfill (T value)
+    {
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (_completed) {
+          return;
+        }
+
+        _value = std::move(value);
+        _completed = true;
+      }
+
+      _condition.notify_all();
+    }
+
+    /**
+     * Completes the future with an error. Has no effect if the future was
+     * already completed.
+     */
+    void reject (Optional<std::string> error)
+    {
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (_completed) {
+          return;
+        }
+
+        _error = std::move(error);
+        _completed = true;
+      }
+
+      _condition.notify_all();
+    }
+
+    /**
+     * Returns whether the future has been fulfilled or rejected.
+     */
+    bool completed () const
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      return _completed;
+    }
+
+    /**
+     * Wakes any threads blocked in wait(), so that they check whether they
+     * have been cancelled. The future itself is unaffected.
+     */
+    void interrupt () const
+    {
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+      }
+
+      _condition.notify_all();
+    }
+
+    /**
+     * Blocks until the future has completed, then returns a copy of its value.
+     *
+     * Throws Exception::UserError if the future was rejected, or
+     * Exception::Cancelled if `cancelled` is set (and interrupt() called)
+     * before the future completes.
+     */
+    T wait (const std::atomic<bool> &cancelled) const noexcept(false)
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [&] {
+        return _completed || cancelled;
+      });
+
+      if (!_completed) {
+        throw Exception::Cancelled("Resolution was cancelled");
+      } else if (_value) {
+        return *_value;
+      } else if (_error) {
+        throw Exception::UserError(*_error);
+      } else {
+        throw Exception::UserError();
+      }
+    }
+
+  private:
+    mutable std::mutex _mutex;
+    mutable std::condition_variable _condition;
+
+    bool _completed = false;
+    Optional<T> _value;
+    Optional<std::string> _error;
+};
+
+} // namespace Arbiter
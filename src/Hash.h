@@ -4,6 +4,7 @@
 #error "This file must be compiled as C++."
 #endif
 
+#include <cstddef>
 #include <functional>
 #include <type_traits>
 
@@ -0,0 +1,357 @@
+#include "Incompatibility.h"
+
+#include "Exception.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <ostream>
+#include <sstream>
+
+using namespace Arbiter;
+using namespace Resolver;
+
+namespace {
+
+const char * const archiveHeader = "arbiter-incompatibilities";
+const unsigned archiveVersion = 1;
+
+/**
+ * Encodes a string such that it contains no whitespace, so it can be read back
+ * as a single token.
+ */
+std::string escape (const std::string &string)
+{
+  std::string escaped;
+  escaped.reserve(string.size());
+
+  for (unsigned char ch : string) {
+    if (ch > ' ' && ch < 0x7F && ch != '%') {
+      escaped += static_cast<char>(ch);
+    } else {
+      char buffer[4];
+      snprintf(buffer, sizeof(buffer), "%%%02X", static_cast<unsigned>(ch));
+      escaped += buffer;
+    }
+  }
+
+  return escaped;
+}
+
+std::string unescape (const std::string &string) noexcept(false)
+{
+  std::string unescaped;
+  unescaped.reserve(string.size());
+
+  for (size_t i = 0; i < string.size(); ++i) {
+    if (string[i] != '%') {
+      unescaped += string[i];
+      continue;
+    }
+
+    if (i + 2 >= string.size()) {
+      throw Exception::PersistenceError("Truncated escape sequence in " + string);
+    }
+
+    unsigned value = 0;
+    if (sscanf(string.c_str() + i + 1, "%2X", &value) != 1) {
+      throw Exception::PersistenceError("Invalid escape sequence in " + string);
+    }
+
+    unescaped += static_cast<char>(value);
+    i += 2;
+  }
+
+  return unescaped;
+}
+
+std::string formatFingerprint (uint64_t fingerprint)
+{
+  char buffer[17];
+  snprintf(buffer, sizeof(buffer), "%016" PRIx64, fingerprint);
+  return buffer;
+}
+
+uint64_t parseFingerprint (const std::string &string) noexcept(false)
+{
+  uint64_t value = 0;
+  if (string.size() != 16 || sscanf(string.c_str(), "%" SCNx64, &value) != 1) {
+    throw Exception::PersistenceError("Invalid fingerprint " + string);
+  }
+
+  return value;
+}
+
+/**
+ * Reads the next line from `is` and splits it into whitespace-separated
+ * tokens, verifying that it begins with `keyword` and contains exactly
+ * `count` tokens after that.
+ */
+std::vector<std::string> readRecord (std::istream &is, const char *keyword, size_t count) noexcept(false)
+{
+  std::string line;
+  if (!std::getline(is, line)) {
+    throw Exception::PersistenceError(std::string("Expected ") + keyword + " but reached the end of the archive");
+  }
+
+  std::istringstream tokenizer(line);
+  std::vector<std::string> tokens;
+
+  std::string token;
+  while (tokenizer >> token) {
+    tokens.emplace_back(std::move(token));
+  }
+
+  if (tokens.empty() || tokens.front() != keyword || tokens.size() != count + 1) {
+    throw Exception::PersistenceError(std::string("Expected ") + keyword + " but found: " + line);
+  }
+
+  tokens.erase(tokens.begin());
+  return tokens;
+}
+
+size_t parseCount (const std::string &string) noexcept(false)
+{
+  if (string.empty() || string.find_first_not_of("0123456789") != std::string::npos) {
+    throw Exception::PersistenceError("Invalid number " + string);
+  }
+
+  try {
+    return std::stoul(string);
+  } catch (const std::out_of_range &) {
+    throw Exception::PersistenceError("Number out of range " + string);
+  }
+}
+
+size_t parseIndex (const std::string &string, size_t limit) noexcept(false)
+{
+  const size_t index = parseCount(string);
+  if (index >= limit) {
+    throw Exception::PersistenceError("Index out of bounds: " + string);
+  }
+
+  return index;
+}
+
+} // namespace
+
+void Incompatibility::addSelection (ProjectID project, const ArbiterSelectedVersion &version)
+{
+  _selections.emplace(project, version);
+}
+
+void Incompatibility::addRootRequirement (ProjectID project, const ArbiterRequirement &requirement)
+{
+  std::shared_ptr<const ArbiterRequirement> interned = requirement.intern();
+  std::vector<std::shared_ptr<const ArbiterRequirement>> &requirements = _rootRequirements[project];
+
+  if (std::find(requirements.begin(), requirements.end(), interned) == requirements.end()) {
+    requirements.emplace_back(std::move(interned));
+  }
+}
+
+void Incompatibility::addVersionList (ProjectID project)
+{
+  _versionLists.insert(project);
+}
+
+void Incompatibility::merge (const Incompatibility &other)
+{
+  _selections.insert(other._selections.begin(), other._selections.end());
+
+  for (const auto &pair : other._rootRequirements) {
+    std::vector<std::shared_ptr<const ArbiterRequirement>> &requirements = _rootRequirements[pair.first];
+
+    for (const auto &requirement : pair.second) {
+      if (std::find(requirements.begin(), requirements.end(), requirement) == requirements.end()) {
+        requirements.emplace_back(requirement);
+      }
+    }
+  }
+
+  _versionLists.insert(other._versionLists.begin(), other._versionLists.end());
+}
+
+bool Incompatibility::operator== (const Incompatibility &other) const
+{
+  if (_selections != other._selections || _versionLists != other._versionLists || _rootRequirements.size() != other._rootRequirements.size()) {
+    return false;
+  }
+
+  // Requirements are never repeated for a project, so the lists are equal if
+  // they have the same length and one contains everything in the other.
+  auto otherIt = other._rootRequirements.begin();
+  for (const auto &pair : _rootRequirements) {
+    if (pair.first != otherIt->first || pair.second.size() != otherIt->second.size()) {
+      return false;
+    }
+
+    for (const auto &requirement : pair.second) {
+      if (std::find(otherIt->second.begin(), otherIt->second.end(), requirement) == otherIt->second.end()) {
+        return false;
+      }
+    }
+
+    ++otherIt;
+  }
+
+  return true;
+}
+
+bool IncompatibilityStore::add (Incompatibility incompatibility)
+{
+  if (incompatibility._selections.empty()) {
+    return false;
+  }
+
+  const auto it = _indicesBySelection.find(*incompatibility._selections.begin());
+  if (it != _indicesBySelection.end()) {
+    for (size_t index : it->second) {
+      if (_incompatibilities[index] == incompatibility) {
+        return false;
+      }
+    }
+  }
+
+  const size_t index = _incompatibilities.size();
+  for (const auto &pair : incompatibility._selections) {
+    _indicesBySelection[pair].emplace_back(index);
+  }
+
+  _incompatibilities.emplace_back(std::move(incompatibility));
+  return true;
+}
+
+size_t IncompatibilityArchive::indexOfProject (const std::string &description, uint64_t versionsFingerprint)
+{
+  for (size_t i = 0; i < _projects.size(); ++i) {
+    const Project &project = _projects[i];
+    if (project._description == description && project._versionsFingerprint == versionsFingerprint) {
+      return i;
+    }
+  }
+
+  _projects.emplace_back(Project{description, versionsFingerprint});
+  return _projects.size() - 1;
+}
+
+uint64_t IncompatibilityArchive::fingerprint (const std::string &string) noexcept
+{
+  // 64-bit FNV-1a
+  uint64_t hash = UINT64_C(14695981039346656037);
+
+  for (unsigned char ch : string) {
+    hash ^= ch;
+    hash *= UINT64_C(1099511628211);
+  }
+
+  return hash;
+}
+
+void IncompatibilityArchive::write (std::ostream &os) const
+{
+  os << archiveHeader << ' ' << archiveVersion << '\n';
+  os << "projects " << _projects.size() << '\n';
+
+  for (const Project &project : _projects) {
+    os << "project " << formatFingerprint(project._versionsFingerprint) << ' ' << escape(project._description) << '\n';
+  }
+
+  os << "entries " << _entries.size() << '\n';
+
+  for (const Entry &entry : _entries) {
+    os << "entry " << entry._selections.size() << ' ' << entry._rootRequirements.size() << ' ' << entry._versionLists.size() << '\n';
+
+    for (const Selection &selection : entry._selections) {
+      os << "selection " << selection._projectIndex << ' ';
+
+      if (selection._dependenciesFingerprint) {
+        os << formatFingerprint(*selection._dependenciesFingerprint);
+      } else {
+        os << '-';
+      }
+
+      os << ' ' << escape(selection._version) << '\n';
+    }
+
+    for (const RootRequirement &root : entry._rootRequirements) {
+      os << "root " << root._projectIndex << ' ' << escape(root._requirement) << '\n';
+    }
+
+    for (size_t projectIndex : entry._versionLists) {
+      os << "versions " << projectIndex << '\n';
+    }
+  }
+}
+
+IncompatibilityArchive IncompatibilityArchive::read (std::istream &is) noexcept(false)
+{
+  const std::vector<std::string> header = readRecord(is, archiveHeader, 1);
+  if (header.front() != std::to_string(archiveVersion)) {
+    throw Exception::PersistenceError("Unsupported archive version " + header.front());
+  }
+
+  IncompatibilityArchive archive;
+
+  const size_t projectCount = parseCount(readRecord(is, "projects", 1).front());
+  for (size_t i = 0; i < projectCount; ++i) {
+    const std::vector<std::string> tokens = readRecord(is, "project", 2);
+    archive._projects.emplace_back(Project{unescape(tokens[1]), parseFingerprint(tokens[0])});
+  }
+
+  const size_t entryCount = parseCount(readRecord(is, "entries", 1).front());
+  for (size_t i = 0; i < entryCount; ++i) {
+    const std::vector<std::string> counts = readRecord(is, "entry", 3);
+    const size_t selectionCount = parseCount(counts[0]);
+    const size_t rootCount = parseCount(counts[1]);
+    const size_t versionListCount = parseCount(counts[2]);
+
+    Entry entry;
+
+    for (size_t j = 0; j < selectionCount; ++j) {
+      const std::vector<std::string> tokens = readRecord(is, "selection", 3);
+
+      Optional<uint64_t> dependenciesFingerprint;
+      if (tokens[1] != "-") {
+        dependenciesFingerprint = parseFingerprint(tokens[1]);
+      }
+
+      entry._selections.emplace_back(Selection{parseIndex(tokens[0], projectCount), unescape(tokens[2]), dependenciesFingerprint});
+    }
+
+    for (size_t j = 0; j < rootCount; ++j) {
+      const std::vector<std::string> tokens = readRecord(is, "root", 2);
+      entry._rootRequirements.emplace_back(RootRequirement{parseIndex(tokens[0], projectCount), unescape(tokens[1])});
+    }
+
+    for (size_t j = 0; j < versionListCount; ++j) {
+      const std::vector<std::string> tokens = readRecord(is, "versions", 1);
+      entry._versionLists.emplace_back(parseIndex(tokens[0], projectCount));
+    }
+
+    archive._entries.emplace_back(std::move(entry));
+  }
+
+  return archive;
+}
+
+std::ostream &operator<< (std::ostream &os, const Incompatibility &incompatibility)
+{
+  os << "Incompatibility:";
+
+  for (const auto &pair : incompatibility._selections) {
+    os << "\n\tProject " << pair.first << " @ " << pair.second;
+  }
+
+  for (const auto &pair : incompatibility._rootRequirements) {
+    for (const auto &requirement : pair.second) {
+      os << "\n\tProject " << pair.first << " (root) " << *requirement;
+    }
+  }
+
+  for (ProjectID project : incompatibility._versionLists) {
+    os << "\n\tProject " << project << " (available versions)";
+  }
+
+  return os;
+}
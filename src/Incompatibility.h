@@ -0,0 +1,284 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include "Dependency.h"
+#include "Optional.h"
+#include "ProjectTable.h"
+#include "Requirement.h"
+#include "Version.h"
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Arbiter {
+namespace Resolver {
+
+/**
+ * A set of facts which cannot all hold at once in any valid dependency graph.
+ *
+ * An incompatibility consists of selected versions (each of which holds only if
+ * the corresponding project was resolved to exactly that version), along with
+ * any root dependencies that contributed to the conflict.
+ *
+ * Incompatibilities also keep track of which projects' lists of available
+ * versions they were derived from, since adding a new version to one of those
+ * lists could invalidate them.
+ *
+ * Projects are referred to by their IDs within the resolver's ProjectTable.
+ */
+class Incompatibility final
+{
+  public:
+    using Selections = std::map<ProjectID, ArbiterSelectedVersion>;
+    using RootRequirements = std::map<ProjectID, std::vector<std::shared_ptr<const ArbiterRequirement>>>;
+    using Projects = std::set<ProjectID>;
+
+    Selections _selections;
+
+    /**
+     * Every distinct requirement from the root dependency list which
+     * contributed to this incompatibility, grouped by project, since a root
+     * dependency list may place several requirements upon the same project.
+     *
+     * Requirements are interned, so they can be compared by address.
+     */
+    RootRequirements _rootRequirements;
+    Projects _versionLists;
+
+    /**
+     * Adds the choice of `version` for `project` to this incompatibility.
+     */
+    void addSelection (ProjectID project, const ArbiterSelectedVersion &version);
+
+    /**
+     * Adds a requirement upon `project` from the root dependency list to this
+     * incompatibility, unless an equal one was already added.
+     */
+    void addRootRequirement (ProjectID project, const ArbiterRequirement &requirement);
+
+    /**
+     * Records that this incompatibility relies upon the list of available
+     * versions for `project`.
+     */
+    void addVersionList (ProjectID project);
+
+    /**
+     * Adds all of the facts from `other` into this incompatibility.
+     *
+     * If both incompatibilities select a version for the same project, the
+     * existing selection is kept.
+     */
+    void merge (const Incompatibility &other);
+
+    /**
+     * Returns whether this incompatibility depends upon the version selected
+     * for `project`.
+     */
+    bool involves (ProjectID project) const
+    {
+      return _selections.find(project) != _selections.end();
+    }
+
+    bool operator== (const Incompatibility &other) const;
+
+    bool operator!= (const Incompatibility &other) const
+    {
+      return !(*this == other);
+    }
+};
+
+/**
+ * Records incompatibilities learned during dependency resolution, and indexes
+ * them so that any partial graph which has already been proven invalid can be
+ * recognized again cheaply.
+ */
+class IncompatibilityStore final
+{
+  public:
+    /**
+     * Records the given incompatibility.
+     *
+     * Returns whether it was added, which will be false if an equal
+     * incompatibility was already recorded, or if it does not contain any
+     * selections to match against.
+     */
+    bool add (Incompatibility incompatibility);
+
+    /**
+     * Looks for a recorded incompatibility which involves the choice of
+     * `version` for `project`, and whose other selections are all satisfied
+     * according to `lookup`.
+     *
+     * `hasRootRequirement` will be invoked with a project ID and requirement
+     * for each root requirement of a candidate incompatibility, and should
+     * return whether the root dependency list being resolved places that
+     * requirement upon that project. Version lists are assumed to be
+     * unchanged, and are not checked.
+     *
+     * `lookup` will be invoked with project IDs, and should return
+     * a pointer to the version currently selected for that project, or nullptr
+     * if no version has been selected yet.
+     *
+     * Returns a pointer to the incompatibility if one was found, or else
+     * nullptr.
+     */
+    template<typename Lookup, typename RootLookup>
+    const Incompatibility *findSatisfied (ProjectID project, const ArbiterSelectedVersion &version, const Lookup &lookup, const RootLookup &hasRootRequirement) const
+    {
+      const auto it = _indicesBySelection.find(ProjectVersion(project, version));
+      if (it == _indicesBySelection.end()) {
+        return nullptr;
+      }
+
+      for (size_t index : it->second) {
+        const Incompatibility &incompatibility = _incompatibilities[index];
+
+        bool satisfied = true;
+        for (const auto &pair : incompatibility._selections) {
+          const ArbiterSelectedVersion *version = lookup(pair.first);
+          if (!version || *version != pair.second) {
+            satisfied = false;
+            break;
+          }
+        }
+
+        for (auto it = incompatibility._rootRequirements.begin(); satisfied && it != incompatibility._rootRequirements.end(); ++it) {
+          for (const auto &requirement : it->second) {
+            if (!hasRootRequirement(it->first, *requirement)) {
+              satisfied = false;
+              break;
+            }
+          }
+        }
+
+        if (satisfied) {
+          return &incompatibility;
+        }
+      }
+
+      return nullptr;
+    }
+
+    /**
+     * Returns the number of recorded incompatibilities.
+     */
+    size_t count () const noexcept
+    {
+      return _incompatibilities.size();
+    }
+
+    /**
+     * Returns all recorded incompatibilities, in the order they were added.
+     */
+    const std::vector<Incompatibility> &incompatibilities () const noexcept
+    {
+      return _incompatibilities;
+    }
+
+  private:
+    std::vector<Incompatibility> _incompatibilities;
+    std::unordered_map<ProjectVersion, std::vector<size_t>, ProjectVersionHash> _indicesBySelection;
+};
+
+/**
+ * A serializable form of learned incompatibilities, in which projects,
+ * versions, and requirements are identified by their descriptions.
+ *
+ * Archives can be written to a file and later read into a different resolver,
+ * so that conflicts discovered once don't need to be relearned. Each archived
+ * project carries fingerprints of the data its incompatibilities were derived
+ * from, so that stale entries can be detected if the resolver behaviors start
+ * returning something different.
+ */
+class IncompatibilityArchive final
+{
+  public:
+    /**
+     * A project referenced by archived incompatibilities, along with
+     * a fingerprint of the versions that were available for it.
+     */
+    struct Project final
+    {
+      public:
+        std::string _description;
+        uint64_t _versionsFingerprint;
+    };
+
+    /**
+     * An archived selected version, along with a fingerprint of its dependency
+     * list (if that list had been fetched when the archive was created).
+     */
+    struct Selection final
+    {
+      public:
+        size_t _projectIndex;
+        std::string _version;
+        Optional<uint64_t> _dependenciesFingerprint;
+    };
+
+    /**
+     * An archived requirement from the root dependency list.
+     */
+    struct RootRequirement final
+    {
+      public:
+        size_t _projectIndex;
+        std::string _requirement;
+    };
+
+    /**
+     * An archived incompatibility.
+     *
+     * `_versionLists` contains the indices of projects whose lists of
+     * available versions the incompatibility was derived from.
+     */
+    struct Entry final
+    {
+      public:
+        std::vector<Selection> _selections;
+        std::vector<RootRequirement> _rootRequirements;
+        std::vector<size_t> _versionLists;
+    };
+
+    std::vector<Project> _projects;
+    std::vector<Entry> _entries;
+
+    /**
+     * Returns the index of the given project within `_projects`, adding it if
+     * necessary.
+     */
+    size_t indexOfProject (const std::string &description, uint64_t versionsFingerprint);
+
+    /**
+     * Computes a fingerprint of the given string which is stable across
+     * processes and platforms.
+     */
+    static uint64_t fingerprint (const std::string &string) noexcept;
+
+    /**
+     * Writes this archive to the given stream.
+     */
+    void write (std::ostream &os) const;
+
+    /**
+     * Reads an archive previously created with write().
+     *
+     * Throws Exception::PersistenceError if the data is malformed.
+     */
+    static IncompatibilityArchive read (std::istream &is) noexcept(false);
+};
+
+} // namespace Resolver
+} // namespace Arbiter
+
+std::ostream &operator<< (std::ostream &os, const Arbiter::Resolver::Incompatibility &incompatibility);
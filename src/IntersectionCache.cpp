@@ -0,0 +1,44 @@
+#include "IntersectionCache.h"
+
+#include "Requirement.h"
+
+using namespace Arbiter;
+using namespace Resolver;
+
+bool IntersectionCache::Key::operator== (const Key &other) const
+{
+  return *_lhs == *other._lhs && *_rhs == *other._rhs;
+}
+
+size_t IntersectionCache::KeyHash::operator() (const Key &key) const
+{
+  // Intersection isn't guaranteed to produce the same description in both
+  // directions, so the order of the pair matters.
+  return key._lhs->hash() * 31 ^ key._rhs->hash();
+}
+
+std::shared_ptr<const ArbiterRequirement> IntersectionCache::intersect (const ArbiterRequirement &lhs, const ArbiterRequirement &rhs) noexcept(false)
+{
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+
+    const auto it = _entries.find(Key{&lhs, &rhs});
+    if (it != _entries.end()) {
+      return it->second._intersection;
+    }
+  }
+
+  // Intersect without holding the lock, since it may be expensive. If another
+  // thread gets there first, its result wins.
+  Entry entry{lhs.intern(), rhs.intern(), lhs.intersect(rhs)};
+  const Key key{entry._lhs.get(), entry._rhs.get()};
+
+  std::lock_guard<std::mutex> guard(_mutex);
+  return _entries.emplace(key, std::move(entry)).first->second._intersection;
+}
+
+size_t IntersectionCache::size () const
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  return _entries.size();
+}
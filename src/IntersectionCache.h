@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+struct ArbiterRequirement;
+
+namespace Arbiter {
+namespace Resolver {
+
+/**
+ * Memoizes ArbiterRequirement::intersect() for the lifetime of a resolver.
+ *
+ * The same pairs of requirements are intersected over and over as the search
+ * explores different combinations of versions, so each distinct pair is only
+ * intersected once, and every caller receives the same immutable result.
+ *
+ * This class is safe to use from multiple threads.
+ */
+class IntersectionCache final
+{
+  public:
+    IntersectionCache () = default;
+
+    IntersectionCache (const IntersectionCache &) = delete;
+    IntersectionCache &operator= (const IntersectionCache &) = delete;
+
+    /**
+     * Returns the intersection of `lhs` and `rhs`, or nullptr if they are
+     * mutually exclusive.
+     */
+    std::shared_ptr<const ArbiterRequirement> intersect (const ArbiterRequirement &lhs, const ArbiterRequirement &rhs) noexcept(false);
+
+    /**
+     * Returns the number of distinct pairs intersected so far.
+     */
+    size_t size () const;
+
+  private:
+    /**
+     * A pair of requirements, compared by value.
+     */
+    struct Key final
+    {
+      public:
+        const ArbiterRequirement *_lhs;
+        const ArbiterRequirement *_rhs;
+
+        bool operator== (const Key &other) const;
+    };
+
+    struct KeyHash final
+    {
+      public:
+        size_t operator() (const Key &key) const;
+    };
+
+    struct Entry final
+    {
+      public:
+        // The interned inputs, which the entry's key points into.
+        std::shared_ptr<const ArbiterRequirement> _lhs;
+        std::shared_ptr<const ArbiterRequirement> _rhs;
+
+        std::shared_ptr<const ArbiterRequirement> _intersection;
+    };
+
+    mutable std::mutex _mutex;
+    std::unordered_map<Key, Entry, KeyHash> _entries;
+};
+
+} // namespace Resolver
+} // namespace Arbiter
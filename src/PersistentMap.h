@@ -0,0 +1,210 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace Arbiter {
+
+/**
+ * An immutable ordered map which shares structure between copies.
+ *
+ * The map is implemented as a balanced binary search tree (AVL) whose nodes
+ * are never modified after creation. Inserting into a map copies only the
+ * nodes along the path to the changed key, so copying a map is O(1),
+ * insertion is O(log n), and any number of maps derived from one another use
+ * memory proportional to their differences rather than their sizes.
+ *
+ * Keys and values are stored behind their own reference-counted allocation,
+ * so rebalancing never needs to copy them.
+ */
+template<typename Key, typename Value, typename Compare = std::less<Key>>
+class PersistentMap final
+{
+  public:
+    using Entry = std::pair<const Key, Value>;
+
+    PersistentMap () = default;
+
+    explicit PersistentMap (Compare compare)
+      : _compare(std::move(compare))
+    {}
+
+    /**
+     * Returns the number of entries in the map.
+     */
+    size_t size () const noexcept
+    {
+      return _size;
+    }
+
+    bool empty () const noexcept
+    {
+      return _size == 0;
+    }
+
+    /**
+     * Returns a pointer to the value associated with `key`, or nullptr if
+     * there is no such entry.
+     *
+     * The returned pointer remains valid for as long as any map containing
+     * the entry is alive.
+     */
+    const Value *find (const Key &key) const
+    {
+      const Node *node = _root.get();
+
+      while (node) {
+        if (_compare(key, node->_entry->first)) {
+          node = node->_left.get();
+        } else if (_compare(node->_entry->first, key)) {
+          node = node->_right.get();
+        } else {
+          return &node->_entry->second;
+        }
+      }
+
+      return nullptr;
+    }
+
+    /**
+     * Returns the value associated with `key`.
+     *
+     * Throws std::out_of_range if there is no such entry.
+     */
+    const Value &at (const Key &key) const noexcept(false)
+    {
+      if (const Value *value = find(key)) {
+        return *value;
+      } else {
+        throw std::out_of_range("Key not found in PersistentMap");
+      }
+    }
+
+    /**
+     * Associates `value` with `key`, replacing any existing entry.
+     *
+     * Other maps which share structure with this one are unaffected.
+     *
+     * Returns whether a new entry was added.
+     */
+    bool insert (Key key, Value value)
+    {
+      bool inserted = false;
+      _root = insert(_root, std::make_shared<const Entry>(std::move(key), std::move(value)), inserted);
+
+      if (inserted) {
+        ++_size;
+      }
+
+      return inserted;
+    }
+
+    /**
+     * Invokes `visitor` with the key and value of each entry, in ascending
+     * order of keys.
+     */
+    template<typename Visitor>
+    void forEach (Visitor &&visitor) const
+    {
+      forEach(_root.get(), visitor);
+    }
+
+  private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node final
+    {
+      public:
+        std::shared_ptr<const Entry> _entry;
+        NodePtr _left;
+        NodePtr _right;
+        unsigned _height;
+
+        Node (std::shared_ptr<const Entry> entry, NodePtr left, NodePtr right)
+          : _entry(std::move(entry))
+          , _left(std::move(left))
+          , _right(std::move(right))
+          , _height(1 + std::max(height(_left), height(_right)))
+        {}
+    };
+
+    NodePtr _root;
+    size_t _size = 0;
+    Compare _compare;
+
+    static unsigned height (const NodePtr &node) noexcept
+    {
+      return node ? node->_height : 0;
+    }
+
+    static NodePtr makeNode (std::shared_ptr<const Entry> entry, NodePtr left, NodePtr right)
+    {
+      return std::make_shared<const Node>(std::move(entry), std::move(left), std::move(right));
+    }
+
+    /**
+     * Creates a node from the given parts, rotating as necessary to restore
+     * balance. The heights of `left` and `right` may differ by at most two.
+     */
+    static NodePtr balance (std::shared_ptr<const Entry> entry, NodePtr left, NodePtr right)
+    {
+      const unsigned leftHeight = height(left);
+      const unsigned rightHeight = height(right);
+
+      if (leftHeight > rightHeight + 1) {
+        if (height(left->_left) >= height(left->_right)) {
+          return makeNode(left->_entry, left->_left, makeNode(std::move(entry), left->_right, std::move(right)));
+        } else {
+          const Node &pivot = *left->_right;
+          return makeNode(pivot._entry, makeNode(left->_entry, left->_left, pivot._left), makeNode(std::move(entry), pivot._right, std::move(right)));
+        }
+      } else if (rightHeight > leftHeight + 1) {
+        if (height(right->_right) >= height(right->_left)) {
+          return makeNode(right->_entry, makeNode(std::move(entry), std::move(left), right->_left), right->_right);
+        } else {
+          const Node &pivot = *right->_left;
+          return makeNode(pivot._entry, makeNode(std::move(entry), std::move(left), pivot._left), makeNode(right->_entry, pivot._right, right->_right));
+        }
+      } else {
+        return makeNode(std::move(entry), std::move(left), std::move(right));
+      }
+    }
+
+    NodePtr insert (const NodePtr &node, std::shared_ptr<const Entry> entry, bool &inserted) const
+    {
+      if (!node) {
+        inserted = true;
+        return makeNode(std::move(entry), nullptr, nullptr);
+      }
+
+      if (_compare(entry->first, node->_entry->first)) {
+        return balance(node->_entry, insert(node->_left, std::move(entry), inserted), node->_right);
+      } else if (_compare(node->_entry->first, entry->first)) {
+        return balance(node->_entry, node->_left, insert(node->_right, std::move(entry), inserted));
+      } else {
+        return makeNode(std::move(entry), node->_left, node->_right);
+      }
+    }
+
+    template<typename Visitor>
+    static void forEach (const Node *node, Visitor &visitor)
+    {
+      if (!node) {
+        return;
+      }
+
+      forEach(node->_left.get(), visitor);
+      visitor(node->_entry->first, node->_entry->second);
+      forEach(node->_right.get(), visitor);
+    }
+};
+
+} // namespace Arbiter
@@ -0,0 +1,53 @@
+#include "ProjectTable.h"
+
+#include "Requirement.h"
+
+#include <limits>
+#include <stdexcept>
+
+using namespace Arbiter;
+using namespace Resolver;
+
+ProjectID ProjectTable::intern (const ArbiterProjectIdentifier &project) noexcept(false)
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+
+  const auto it = _ids.find(project);
+  if (it != _ids.end()) {
+    return it->second;
+  }
+
+  if (_projects.size() > std::numeric_limits<ProjectID>::max()) {
+    throw std::length_error("Too many projects to resolve");
+  }
+
+  const auto id = static_cast<ProjectID>(_projects.size());
+  _projects.emplace_back(project);
+  _ids.emplace(project, id);
+
+  return id;
+}
+
+Optional<ProjectID> ProjectTable::find (const ArbiterProjectIdentifier &project) const
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+
+  const auto it = _ids.find(project);
+  if (it == _ids.end()) {
+    return None();
+  } else {
+    return makeOptional(it->second);
+  }
+}
+
+const ArbiterProjectIdentifier &ProjectTable::lookup (ProjectID id) const
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  return _projects.at(id);
+}
+
+size_t ProjectTable::size () const
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  return _projects.size();
+}
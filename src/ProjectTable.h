@@ -0,0 +1,104 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include "Dependency.h"
+#include "Hash.h"
+#include "Optional.h"
+#include "Version.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace Arbiter {
+namespace Resolver {
+
+/**
+ * A dense integer which stands in for an ArbiterProjectIdentifier within
+ * a single resolver.
+ */
+using ProjectID = uint32_t;
+
+/**
+ * A version selected for an interned project.
+ */
+using ProjectVersion = std::pair<ProjectID, ArbiterSelectedVersion>;
+
+struct ProjectVersionHash final
+{
+  public:
+    size_t operator() (const ProjectVersion &projectVersion) const
+    {
+      return hashOf(projectVersion.first) ^ hashOf(projectVersion.second);
+    }
+};
+
+/**
+ * Assigns each distinct project identifier a ProjectID the first time it is
+ * seen, so that the resolver can compare, hash, and order projects without
+ * calling back into user code.
+ *
+ * IDs are handed out in order of first appearance, which can vary between
+ * runs when resolving with multiple threads. They must therefore not be used
+ * to order projects in any way that could affect the result of resolution;
+ * use lessThan() for that instead.
+ *
+ * This class is safe to use from multiple threads.
+ */
+class ProjectTable final
+{
+  public:
+    ProjectTable () = default;
+
+    ProjectTable (const ProjectTable &) = delete;
+    ProjectTable &operator= (const ProjectTable &) = delete;
+
+    /**
+     * Returns the ID of `project`, assigning a new one if it has not been seen
+     * before.
+     *
+     * Throws std::length_error if every ID is already in use.
+     */
+    ProjectID intern (const ArbiterProjectIdentifier &project) noexcept(false);
+
+    /**
+     * Returns the ID of `project` if it has been interned, or else None.
+     */
+    Optional<ProjectID> find (const ArbiterProjectIdentifier &project) const;
+
+    /**
+     * Returns the project identifier which was interned as `id`.
+     *
+     * The returned reference remains valid for the lifetime of the table.
+     */
+    const ArbiterProjectIdentifier &lookup (ProjectID id) const;
+
+    /**
+     * Orders two interned projects by their identifiers.
+     */
+    bool lessThan (ProjectID lhs, ProjectID rhs) const
+    {
+      return lhs != rhs && lookup(lhs) < lookup(rhs);
+    }
+
+    /**
+     * Returns the number of projects interned so far.
+     */
+    size_t size () const;
+
+  private:
+    mutable std::mutex _mutex;
+
+    // A deque, so that references handed out by lookup() are never
+    // invalidated by later insertions.
+    std::deque<ArbiterProjectIdentifier> _projects;
+    std::unordered_map<ArbiterProjectIdentifier, ProjectID> _ids;
+};
+
+} // namespace Resolver
+} // namespace Arbiter
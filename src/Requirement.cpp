@@ -1,9 +1,11 @@
 #include "Requirement.h"
 
 #include "Hash.h"
-#include "ToString.h"
 
-#include <typeinfo>
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <unordered_map>
 
 ArbiterRequirement *ArbiterCreateRequirementAny (void)
 {
@@ -37,11 +39,11 @@ ArbiterRequirement *ArbiterCreateRequirementCustom (ArbiterRequirementPredicate
 
 ArbiterRequirement *ArbiterCreateRequirementCompound (const ArbiterRequirement * const *requirements, size_t count)
 {
-  std::vector<std::shared_ptr<ArbiterRequirement>> vec;
+  std::vector<std::shared_ptr<const ArbiterRequirement>> vec;
   vec.reserve(count);
 
   for (size_t i = 0; i < count; i++) {
-    vec.emplace_back(requirements[i]->cloneRequirement());
+    vec.emplace_back(requirements[i]->intern());
   }
 
   return new Arbiter::Requirement::Compound(std::move(vec));
@@ -54,7 +56,7 @@ bool ArbiterRequirementSatisfiedBy (const ArbiterRequirement *requirement, const
 
 std::unique_ptr<ArbiterRequirement> ArbiterRequirement::cloneRequirement () const
 {
-  return std::unique_ptr<ArbiterRequirement>(dynamic_cast<ArbiterRequirement *>(clone().release()));
+  return std::unique_ptr<ArbiterRequirement>(static_cast<ArbiterRequirement *>(clone().release()));
 }
 
 void ArbiterRequirement::visit (Arbiter::Requirement::Visitor &visitor) const
@@ -62,6 +64,111 @@ void ArbiterRequirement::visit (Arbiter::Requirement::Visitor &visitor) const
   visitor(*this);
 }
 
+namespace {
+
+/**
+ * Every interned requirement which is still alive. Requirements remove
+ * themselves from the table as they are destroyed.
+ */
+class InternTable final
+{
+  public:
+    std::shared_ptr<const ArbiterRequirement> intern (const ArbiterRequirement &requirement)
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      if (auto existing = find(requirement)) {
+        return existing;
+      }
+
+      // Copy the requirement without holding the lock, since destroying the
+      // copy (if another thread wins the race) would need it.
+      lock.unlock();
+
+      std::shared_ptr<const ArbiterRequirement> interned(requirement.cloneRequirement().release(), [this](const ArbiterRequirement *requirement) {
+        remove(*requirement);
+        delete requirement;
+      });
+
+      lock.lock();
+      if (auto existing = find(requirement)) {
+        lock.unlock();
+        return existing;
+      }
+
+      _requirements.emplace(Key{interned.get()}, interned);
+      return interned;
+    }
+
+  private:
+    struct Key final
+    {
+      public:
+        const ArbiterRequirement *_requirement;
+
+        bool operator== (const Key &other) const
+        {
+          return _requirement == other._requirement || *_requirement == *other._requirement;
+        }
+    };
+
+    struct KeyHash final
+    {
+      public:
+        size_t operator() (const Key &key) const
+        {
+          return key._requirement->hash();
+        }
+    };
+
+    std::mutex _mutex;
+    std::unordered_map<Key, std::weak_ptr<const ArbiterRequirement>, KeyHash> _requirements;
+
+    /**
+     * Returns the live interned requirement equal to `requirement`, if there
+     * is one.
+     *
+     * The lock must be held.
+     */
+    std::shared_ptr<const ArbiterRequirement> find (const ArbiterRequirement &requirement)
+    {
+      const auto it = _requirements.find(Key{&requirement});
+      if (it == _requirements.end()) {
+        return nullptr;
+      }
+
+      if (auto existing = it->second.lock()) {
+        return existing;
+      }
+
+      // The requirement is in the middle of being destroyed, so a new one has
+      // to take its place.
+      _requirements.erase(it);
+      return nullptr;
+    }
+
+    void remove (const ArbiterRequirement &requirement)
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+
+      // The entry may already have been replaced by an equal requirement.
+      const auto it = _requirements.find(Key{&requirement});
+      if (it != _requirements.end() && it->first._requirement == &requirement) {
+        _requirements.erase(it);
+      }
+    }
+};
+
+} // namespace
+
+std::shared_ptr<const ArbiterRequirement> ArbiterRequirement::intern () const
+{
+  // Never destroyed, since interned requirements may outlive static
+  // destructors.
+  static InternTable *table = new InternTable;
+
+  return table->intern(*this);
+}
+
 namespace Arbiter {
 namespace Requirement {
 
@@ -202,9 +309,9 @@ struct Intersect<Unversioned, Other> final
 
   Result operator() (const Unversioned &unversioned, const Other &other) const
   {
-    std::vector<std::shared_ptr<ArbiterRequirement>> requirements = {
-      std::shared_ptr<ArbiterRequirement>(other.cloneRequirement()),
-      std::shared_ptr<ArbiterRequirement>(unversioned.cloneRequirement())
+    std::vector<std::shared_ptr<const ArbiterRequirement>> requirements = {
+      other.intern(),
+      unversioned.intern()
     };
 
     return std::make_unique<Compound>(std::move(requirements));
@@ -218,9 +325,9 @@ struct Intersect<Custom, Other> final
 
   Result operator() (const Custom &custom, const Other &other) const
   {
-    std::vector<std::shared_ptr<ArbiterRequirement>> requirements = {
-      std::shared_ptr<ArbiterRequirement>(other.cloneRequirement()),
-      std::shared_ptr<ArbiterRequirement>(custom.cloneRequirement())
+    std::vector<std::shared_ptr<const ArbiterRequirement>> requirements = {
+      other.intern(),
+      custom.intern()
     };
 
     return std::make_unique<Compound>(std::move(requirements));
@@ -234,7 +341,7 @@ struct Intersect<Compound, Compound> final
 
   Result operator() (const Compound &compound, const Compound &other) const
   {
-    std::vector<std::shared_ptr<ArbiterRequirement>> requirements = compound._requirements;
+    std::vector<std::shared_ptr<const ArbiterRequirement>> requirements = compound._requirements;
     requirements.insert(requirements.end(), other._requirements.begin(), other._requirements.end());
     return std::make_unique<Compound>(std::move(requirements));
   }
@@ -247,42 +354,77 @@ struct Intersect<Compound, Other> final
 
   Result operator() (const Compound &compound, const Other &other) const
   {
-    std::vector<std::shared_ptr<ArbiterRequirement>> requirements = compound._requirements;
-    requirements.emplace_back(other.cloneRequirement());
+    std::vector<std::shared_ptr<const ArbiterRequirement>> requirements = compound._requirements;
+    requirements.emplace_back(other.intern());
     return std::make_unique<Compound>(std::move(requirements));
   }
 };
 
-const std::type_info &any = typeid(Any);
-const std::type_info &atLeast = typeid(AtLeast);
-const std::type_info &compatibleWith = typeid(CompatibleWith);
-const std::type_info &exactly = typeid(Exactly);
-const std::type_info &unversioned = typeid(Unversioned);
-const std::type_info &custom = typeid(Custom);
-const std::type_info &compound = typeid(Compound);
-
-template<typename Left>
-std::unique_ptr<ArbiterRequirement> intersectRight(const Left &lhs, const ArbiterRequirement &rhs)
-{
-  if (typeid(rhs) == any) {
-    return Intersect<Left, Any>()(lhs, dynamic_cast<const Any &>(rhs));
-  } else if (typeid(rhs) == atLeast) {
-    return Intersect<Left, AtLeast>()(lhs, dynamic_cast<const AtLeast &>(rhs));
-  } else if (typeid(rhs) == compatibleWith) {
-    return Intersect<Left, CompatibleWith>()(lhs, dynamic_cast<const CompatibleWith &>(rhs));
-  } else if (typeid(rhs) == exactly) {
-    return Intersect<Left, Exactly>()(lhs, dynamic_cast<const Exactly &>(rhs));
-  } else if (typeid(rhs) == unversioned) {
-    return Intersect<Left, Unversioned>()(lhs, dynamic_cast<const Unversioned &>(rhs));
-  } else if (typeid(rhs) == custom) {
-    return Intersect<Left, Custom>()(lhs, dynamic_cast<const Custom &>(rhs));
-  } else if (typeid(rhs) == compound) {
-    return Intersect<Left, Compound>()(lhs, dynamic_cast<const Compound &>(rhs));
-  } else {
-    throw std::invalid_argument("Unrecognized type for requirement: " + toString(rhs));
+template<typename... Types>
+struct TypeList final
+{};
+
+/**
+ * Every built-in kind of requirement, in the order of Kind.
+ */
+using Kinds = TypeList<Any, AtLeast, CompatibleWith, Exactly, Unversioned, Custom, Compound>;
+
+template<typename... Types>
+constexpr bool isInKindOrder (TypeList<Types...>)
+{
+  const Kind kinds[] = { Types::requirementKind... };
+
+  for (size_t i = 0; i < sizeof...(Types); ++i) {
+    if (static_cast<size_t>(kinds[i]) != i) {
+      return false;
+    }
   }
+
+  return true;
 }
 
+static_assert(isInKindOrder(Kinds()), "Requirement types must be listed in the same order as Kind");
+
+using EqualFunction = bool (*)(const ArbiterRequirement &, const ArbiterRequirement &);
+using IntersectFunction = std::unique_ptr<ArbiterRequirement> (*)(const ArbiterRequirement &, const ArbiterRequirement &);
+
+template<typename Type>
+bool equalAs (const ArbiterRequirement &lhs, const ArbiterRequirement &rhs)
+{
+  return static_cast<const Type &>(lhs).equals(static_cast<const Type &>(rhs));
+}
+
+template<typename Left, typename Right>
+std::unique_ptr<ArbiterRequirement> intersectAs (const ArbiterRequirement &lhs, const ArbiterRequirement &rhs)
+{
+  return Intersect<Left, Right>()(static_cast<const Left &>(lhs), static_cast<const Right &>(rhs));
+}
+
+template<typename... Types>
+constexpr std::array<EqualFunction, sizeof...(Types)> equalTable (TypeList<Types...>)
+{
+  return {{ &equalAs<Types>... }};
+}
+
+template<typename Left, typename... Rights>
+constexpr std::array<IntersectFunction, sizeof...(Rights)> intersectRow (TypeList<Rights...>)
+{
+  return {{ &intersectAs<Left, Rights>... }};
+}
+
+/**
+ * Builds a table of Intersect<Left, Right> for every pair of requirement
+ * types, indexed by the Kind of each side.
+ */
+template<typename... Types>
+constexpr std::array<std::array<IntersectFunction, sizeof...(Types)>, sizeof...(Types)> intersectTable (TypeList<Types...> types)
+{
+  return {{ intersectRow<Types>(types)... }};
+}
+
+constexpr auto equalFunctions = equalTable(Kinds());
+constexpr auto intersectFunctions = intersectTable(Kinds());
+
 } // namespace
 
 std::ostream &Any::describe (std::ostream &os) const
@@ -295,13 +437,9 @@ bool AtLeast::satisfiedBy (const ArbiterSemanticVersion &version) const noexcept
   return version >= _minimumVersion;
 }
 
-bool AtLeast::operator== (const Base &other) const
+bool AtLeast::equals (const AtLeast &other) const noexcept
 {
-  if (auto *ptr = dynamic_cast<const AtLeast *>(&other)) {
-    return _minimumVersion == ptr->_minimumVersion;
-  } else {
-    return false;
-  }
+  return _minimumVersion == other._minimumVersion;
 }
 
 size_t AtLeast::hash () const noexcept
@@ -347,18 +485,14 @@ bool CompatibleWith::satisfiedBy (const ArbiterSemanticVersion &version) const n
   return version >= _baseVersion;
 }
 
-bool CompatibleWith::operator== (const Base &other) const
+bool CompatibleWith::equals (const CompatibleWith &other) const noexcept
 {
-  if (auto *ptr = dynamic_cast<const CompatibleWith *>(&other)) {
-    return _baseVersion == ptr->_baseVersion;
-  } else {
-    return false;
-  }
+  return _baseVersion == other._baseVersion && _strictness == other._strictness;
 }
 
 size_t CompatibleWith::hash () const noexcept
 {
-  return hashOf(_baseVersion);
+  return hashOf(_baseVersion) ^ _strictness;
 }
 
 std::ostream &CompatibleWith::describe (std::ostream &os) const
@@ -371,13 +505,9 @@ bool Exactly::satisfiedBy (const ArbiterSemanticVersion &version) const noexcept
   return version == _version;
 }
 
-bool Exactly::operator== (const Base &other) const
+bool Exactly::equals (const Exactly &other) const noexcept
 {
-  if (auto *ptr = dynamic_cast<const Exactly *>(&other)) {
-    return _version == ptr->_version;
-  } else {
-    return false;
-  }
+  return _version == other._version;
 }
 
 size_t Exactly::hash () const noexcept
@@ -400,13 +530,9 @@ bool Unversioned::satisfiedBy (const ArbiterSelectedVersion &selectedVersion) co
   return selectedVersion._metadata == _metadata;
 }
 
-bool Unversioned::operator== (const Arbiter::Base &other) const
+bool Unversioned::equals (const Unversioned &other) const
 {
-  if (auto *ptr = dynamic_cast<const Unversioned *>(&other)) {
-    return _metadata == ptr->_metadata;
-  } else {
-    return false;
-  }
+  return _metadata == other._metadata;
 }
 
 size_t Unversioned::hash () const noexcept
@@ -419,13 +545,9 @@ bool Custom::satisfiedBy (const ArbiterSelectedVersion &selectedVersion) const
   return _predicate(&selectedVersion, _context);
 }
 
-bool Custom::operator== (const Arbiter::Base &other) const
+bool Custom::equals (const Custom &other) const
 {
-  if (auto *ptr = dynamic_cast<const Custom *>(&other)) {
-    return _predicate == ptr->_predicate && _context == ptr->_context;
-  } else {
-    return false;
-  }
+  return _predicate == other._predicate && _context == other._context;
 }
 
 size_t Custom::hash () const noexcept
@@ -459,13 +581,11 @@ std::ostream &Compound::describe (std::ostream &os) const
   return os << " }";
 }
 
-bool Compound::operator== (const Arbiter::Base &other) const
+bool Compound::equals (const Compound &other) const
 {
-  if (auto *ptr = dynamic_cast<const Compound *>(&other)) {
-    return _requirements == ptr->_requirements;
-  } else {
-    return false;
-  }
+  return std::equal(_requirements.begin(), _requirements.end(), other._requirements.begin(), other._requirements.end(), [](const auto &lhs, const auto &rhs) {
+    return lhs == rhs || *lhs == *rhs;
+  });
 }
 
 size_t Compound::hash () const noexcept
@@ -488,40 +608,28 @@ void Compound::visit (Visitor &visitor) const
   }
 }
 
-std::unique_ptr<ArbiterRequirement> Any::intersect (const ArbiterRequirement &rhs) const
-{
-  return intersectRight<Any>(*this, rhs);
-}
+} // namespace Requirement
+} // namespace Arbiter
 
-std::unique_ptr<ArbiterRequirement> AtLeast::intersect (const ArbiterRequirement &rhs) const
+std::unique_ptr<ArbiterRequirement> ArbiterRequirement::intersect (const ArbiterRequirement &rhs) const
 {
-  return intersectRight<AtLeast>(*this, rhs);
-}
+  using namespace Arbiter::Requirement;
 
-std::unique_ptr<ArbiterRequirement> CompatibleWith::intersect (const ArbiterRequirement &rhs) const
-{
-  return intersectRight<CompatibleWith>(*this, rhs);
+  return intersectFunctions[static_cast<size_t>(kind())][static_cast<size_t>(rhs.kind())](*this, rhs);
 }
 
-std::unique_ptr<ArbiterRequirement> Exactly::intersect (const ArbiterRequirement &rhs) const
+bool ArbiterRequirement::operator== (const ArbiterRequirement &other) const
 {
-  return intersectRight<Exactly>(*this, rhs);
-}
+  using namespace Arbiter::Requirement;
 
-std::unique_ptr<ArbiterRequirement> Unversioned::intersect (const ArbiterRequirement &rhs) const
-{
-  return intersectRight<Unversioned>(*this, rhs);
+  return kind() == other.kind() && equalFunctions[static_cast<size_t>(kind())](*this, other);
 }
 
-std::unique_ptr<ArbiterRequirement> Custom::intersect (const ArbiterRequirement &rhs) const
+bool ArbiterRequirement::operator== (const Arbiter::Base &other) const
 {
-  return intersectRight<Custom>(*this, rhs);
-}
-
-std::unique_ptr<ArbiterRequirement> Compound::intersect (const ArbiterRequirement &rhs) const
-{
-  return intersectRight<Compound>(*this, rhs);
+  if (auto *ptr = dynamic_cast<const ArbiterRequirement *>(&other)) {
+    return *this == *ptr;
+  } else {
+    return false;
+  }
 }
-
-} // namespace Requirement
-} // namespace Arbiter
@@ -18,12 +18,34 @@ namespace Requirement {
 
 class Visitor;
 
+/**
+ * The built-in kinds of requirement.
+ *
+ * These are listed in the same order as the rows and columns of the dispatch
+ * tables in Requirement.cpp.
+ */
+enum class Kind : unsigned char
+{
+  Any,
+  AtLeast,
+  CompatibleWith,
+  Exactly,
+  Unversioned,
+  Custom,
+  Compound
+};
+
 } // namespace Requirement
 } // namespace Arbiter
 
 struct ArbiterRequirement : public Arbiter::Base
 {
   public:
+    Arbiter::Requirement::Kind kind () const noexcept
+    {
+      return _kind;
+    }
+
     /**
      * Returns whether this requirement would be satisfied by using the given
      * selected version.
@@ -41,7 +63,22 @@ struct ArbiterRequirement : public Arbiter::Base
      *
      * Returns `nullptr` if no intersection is possible.
      */
-    virtual std::unique_ptr<ArbiterRequirement> intersect (const ArbiterRequirement &rhs) const = 0;
+    std::unique_ptr<ArbiterRequirement> intersect (const ArbiterRequirement &rhs) const;
+
+    /**
+     * Compares two requirements by value. This dispatches upon kind() rather
+     * than using RTTI.
+     */
+    bool operator== (const ArbiterRequirement &other) const;
+
+    bool operator== (const Arbiter::Base &other) const final;
+
+    bool operator!= (const ArbiterRequirement &other) const
+    {
+      return !(*this == other);
+    }
+
+    using Arbiter::Base::operator!=;
 
     /**
      * Visits the requirement, then any child requirements.
@@ -52,6 +89,26 @@ struct ArbiterRequirement : public Arbiter::Base
 
     std::unique_ptr<ArbiterRequirement> cloneRequirement () const;
     virtual size_t hash () const noexcept = 0;
+
+    /**
+     * Returns the shared instance of a requirement equal to this one, creating
+     * it if necessary.
+     *
+     * Interned requirements are immutable, and each distinct requirement is
+     * only stored once per process, so two interned requirements are equal if
+     * and only if they are the same object. Copying one is just a pointer copy.
+     *
+     * This method is safe to call from multiple threads.
+     */
+    std::shared_ptr<const ArbiterRequirement> intern () const;
+
+  protected:
+    explicit ArbiterRequirement (Arbiter::Requirement::Kind kind) noexcept
+      : _kind(kind)
+    {}
+
+  private:
+    Arbiter::Requirement::Kind _kind;
 };
 
 namespace Arbiter {
@@ -74,6 +131,12 @@ class Visitor
 class Any final : public ArbiterRequirement
 {
   public:
+    static constexpr Kind requirementKind = Kind::Any;
+
+    Any () noexcept
+      : ArbiterRequirement(requirementKind)
+    {}
+
     bool satisfiedBy (const ArbiterSemanticVersion &) const noexcept
     {
       return true;
@@ -84,9 +147,9 @@ class Any final : public ArbiterRequirement
       return true;
     }
 
-    bool operator== (const Arbiter::Base &other) const override
+    bool equals (const Any &) const noexcept
     {
-      return (bool)dynamic_cast<const Any *>(&other);
+      return true;
     }
 
     std::unique_ptr<Arbiter::Base> clone () const override
@@ -95,7 +158,6 @@ class Any final : public ArbiterRequirement
     }
 
     std::ostream &describe (std::ostream &os) const override;
-    std::unique_ptr<ArbiterRequirement> intersect (const ArbiterRequirement &rhs) const override;
 
     size_t hash () const noexcept override
     {
@@ -110,10 +172,13 @@ class Any final : public ArbiterRequirement
 class AtLeast final : public ArbiterRequirement
 {
   public:
+    static constexpr Kind requirementKind = Kind::AtLeast;
+
     ArbiterSemanticVersion _minimumVersion;
 
     explicit AtLeast (ArbiterSemanticVersion version) noexcept
-      : _minimumVersion(std::move(version))
+      : ArbiterRequirement(requirementKind)
+      , _minimumVersion(std::move(version))
     {}
 
     bool satisfiedBy (const ArbiterSelectedVersion &selectedVersion) const override
@@ -132,8 +197,7 @@ class AtLeast final : public ArbiterRequirement
 
     bool satisfiedBy (const ArbiterSemanticVersion &version) const noexcept;
     std::ostream &describe (std::ostream &os) const override;
-    bool operator== (const Arbiter::Base &other) const override;
-    std::unique_ptr<ArbiterRequirement> intersect (const ArbiterRequirement &rhs) const override;
+    bool equals (const AtLeast &other) const noexcept;
     size_t hash () const noexcept override;
 };
 
@@ -144,11 +208,14 @@ class AtLeast final : public ArbiterRequirement
 class CompatibleWith final : public ArbiterRequirement
 {
   public:
+    static constexpr Kind requirementKind = Kind::CompatibleWith;
+
     ArbiterSemanticVersion _baseVersion;
     ArbiterRequirementStrictness _strictness;
 
     explicit CompatibleWith (ArbiterSemanticVersion version, ArbiterRequirementStrictness strictness) noexcept
-      : _baseVersion(std::move(version))
+      : ArbiterRequirement(requirementKind)
+      , _baseVersion(std::move(version))
       , _strictness(strictness)
     {}
 
@@ -168,8 +235,7 @@ class CompatibleWith final : public ArbiterRequirement
 
     bool satisfiedBy (const ArbiterSemanticVersion &version) const noexcept;
     std::ostream &describe (std::ostream &os) const override;
-    bool operator== (const Arbiter::Base &other) const override;
-    std::unique_ptr<ArbiterRequirement> intersect (const ArbiterRequirement &rhs) const override;
+    bool equals (const CompatibleWith &other) const noexcept;
     size_t hash () const noexcept override;
 };
 
@@ -179,10 +245,13 @@ class CompatibleWith final : public ArbiterRequirement
 class Exactly final : public ArbiterRequirement
 {
   public:
+    static constexpr Kind requirementKind = Kind::Exactly;
+
     ArbiterSemanticVersion _version;
 
     explicit Exactly (ArbiterSemanticVersion version) noexcept
-      : _version(std::move(version))
+      : ArbiterRequirement(requirementKind)
+      , _version(std::move(version))
     {}
 
     bool satisfiedBy (const ArbiterSelectedVersion &selectedVersion) const override
@@ -201,8 +270,7 @@ class Exactly final : public ArbiterRequirement
 
     bool satisfiedBy (const ArbiterSemanticVersion &version) const noexcept;
     std::ostream &describe (std::ostream &os) const override;
-    bool operator== (const Arbiter::Base &other) const override;
-    std::unique_ptr<ArbiterRequirement> intersect (const ArbiterRequirement &rhs) const override;
+    bool equals (const Exactly &other) const noexcept;
     size_t hash () const noexcept override;
 };
 
@@ -213,10 +281,13 @@ class Unversioned final : public ArbiterRequirement
     // associated with the selected version.
     using Metadata = Arbiter::SharedUserValue<ArbiterSelectedVersion>;
 
+    static constexpr Kind requirementKind = Kind::Unversioned;
+
     Metadata _metadata;
 
     explicit Unversioned (Metadata metadata)
-      : _metadata(std::move(metadata))
+      : ArbiterRequirement(requirementKind)
+      , _metadata(std::move(metadata))
     {}
 
     std::unique_ptr<Base> clone () const override
@@ -226,17 +297,18 @@ class Unversioned final : public ArbiterRequirement
 
     std::ostream &describe (std::ostream &os) const override;
     bool satisfiedBy (const ArbiterSelectedVersion &selectedVersion) const override;
-    std::unique_ptr<ArbiterRequirement> intersect (const ArbiterRequirement &rhs) const override;
-    bool operator== (const Arbiter::Base &other) const override;
+    bool equals (const Unversioned &other) const;
     size_t hash () const noexcept override;
-
 };
 
 class Custom final : public ArbiterRequirement
 {
   public:
+    static constexpr Kind requirementKind = Kind::Custom;
+
     explicit Custom (ArbiterRequirementPredicate predicate, const void *context)
-      : _predicate(std::move(predicate))
+      : ArbiterRequirement(requirementKind)
+      , _predicate(std::move(predicate))
       , _context(context)
     {
       assert(_predicate);
@@ -253,8 +325,7 @@ class Custom final : public ArbiterRequirement
     }
 
     bool satisfiedBy (const ArbiterSelectedVersion &selectedVersion) const override;
-    std::unique_ptr<ArbiterRequirement> intersect (const ArbiterRequirement &rhs) const override;
-    bool operator== (const Arbiter::Base &other) const override;
+    bool equals (const Custom &other) const;
     size_t hash () const noexcept override;
 
   private:
@@ -265,10 +336,13 @@ class Custom final : public ArbiterRequirement
 class Compound final : public ArbiterRequirement
 {
   public:
-    std::vector<std::shared_ptr<ArbiterRequirement>> _requirements;
+    static constexpr Kind requirementKind = Kind::Compound;
 
-    explicit Compound (std::vector<std::shared_ptr<ArbiterRequirement>> requirements)
-      : _requirements(std::move(requirements))
+    std::vector<std::shared_ptr<const ArbiterRequirement>> _requirements;
+
+    explicit Compound (std::vector<std::shared_ptr<const ArbiterRequirement>> requirements)
+      : ArbiterRequirement(requirementKind)
+      , _requirements(std::move(requirements))
     {}
 
     std::unique_ptr<Base> clone () const override
@@ -277,13 +351,26 @@ class Compound final : public ArbiterRequirement
     }
 
     bool satisfiedBy (const ArbiterSelectedVersion &selectedVersion) const override;
-    std::unique_ptr<ArbiterRequirement> intersect (const ArbiterRequirement &rhs) const override;
     std::ostream &describe (std::ostream &os) const override;
-    bool operator== (const Arbiter::Base &other) const override;
+    bool equals (const Compound &other) const;
     size_t hash () const noexcept override;
     void visit (Visitor &visitor) const override;
 };
 
+/**
+ * Returns `requirement` as a `T`, or nullptr if it is a different kind of
+ * requirement.
+ */
+template<typename T>
+const T *requirementCast (const ArbiterRequirement &requirement) noexcept
+{
+  if (requirement.kind() == T::requirementKind) {
+    return static_cast<const T *>(&requirement);
+  } else {
+    return nullptr;
+  }
+}
+
 } // namespace Requirement
 } // namespace Arbiter
 
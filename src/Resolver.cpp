@@ -1,149 +1,308 @@
 #include "Resolver.h"
 
 #include "Algorithm.h"
+#include "Bitset.h"
 #include "Exception.h"
-#include "Iterator.h"
+#include "Incompatibility.h"
+#include "IntersectionCache.h"
 #include "Optional.h"
+#include "PersistentMap.h"
+#include "ProjectTable.h"
 #include "Requirement.h"
 #include "ToString.h"
+#include "VersionTable.h"
+#include "WorkStealingPool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <exception>
+#include <fstream>
 #include <map>
 #include <set>
+#include <sstream>
+#include <tuple>
 #include <unordered_set>
 
 using namespace Arbiter;
 
 namespace {
 
+using Resolver::BehaviorCache;
+using Resolver::Incompatibility;
+using Resolver::IncompatibilityArchive;
+using Resolver::IncompatibilityStore;
+using Resolver::CandidateList;
+using Resolver::IntersectionCache;
+using Resolver::ProjectID;
+using Resolver::ProjectTable;
+using Resolver::ProjectVersion;
+using Resolver::VersionTable;
+
+/**
+ * Thrown when a proposed dependency graph turns out to be inconsistent.
+ *
+ * In addition to the error which should be reported to the user, a conflict
+ * carries the incompatibility which caused it, so the search can backjump
+ * directly to the most recent choice involved.
+ */
+struct Conflict final
+{
+  public:
+    std::exception_ptr _error;
+    Incompatibility _incompatibility;
+
+    Conflict (std::exception_ptr error, Incompatibility incompatibility)
+      : _error(std::move(error))
+      , _incompatibility(std::move(incompatibility))
+    {}
+};
+
+template<typename Error>
+Conflict makeConflict (const Error &error, Incompatibility incompatibility)
+{
+  return Conflict(std::make_exception_ptr(error), std::move(incompatibility));
+}
+
 /**
  * Represents an acyclic dependency graph in which each project appears at most
- * once.
+ * once. Projects are referred to by their IDs within the resolver's
+ * ProjectTable.
  *
  * Dependency graphs can exist in an incomplete state, but will never be
  * inconsistent (i.e., include versions that are known to be invalid given the
  * current graph).
+ *
+ * Graphs are persistent: copying one is O(1), and the copy shares all of its
+ * storage with the original until nodes are added to either of them.
  */
 class DependencyGraph final
 {
   public:
     /**
-     * Attempts to add the given node into the graph, as a dependency of
-     * `dependent` if specified.
+     * Attempts to add `version` of `project` into the graph, as a dependency
+     * of `dependent` if specified.
      *
      * If the given node refers to a project which already exists in the graph,
-     * this method will attempt to intersect the version requirements of both.
+     * this method will attempt to intersect the version requirements of both,
+     * using `intersections` to avoid repeating work.
      *
-     * Throws an exception if this addition would make the graph inconsistent.
+     * Throws a Conflict if this addition would make the graph inconsistent.
      */
-    void addNode (ArbiterResolvedDependency node, const ArbiterRequirement &initialRequirement, const Optional<ArbiterProjectIdentifier> &dependent) noexcept(false)
+    void addNode (IntersectionCache &intersections, ProjectID project, const ArbiterSelectedVersion &version, const std::shared_ptr<const ArbiterRequirement> &requirement, const Optional<ProjectID> &dependent) noexcept(false)
     {
-      assert(initialRequirement.satisfiedBy(node._version));
-
-      const NodeKey &key = node._project;
+      const ArbiterRequirement &initialRequirement = *requirement;
 
-      const auto it = _nodeMap.find(key);
-      if (it != _nodeMap.end()) {
-        NodeValue &value = it->second;
+      const NodeValue *existing = _nodeMap.find(project);
+      NodeValue value = (existing ? *existing : NodeValue(version, requirement));
 
+      if (existing) {
         // We need to unify our input with what was already there.
-        if (auto newRequirement = initialRequirement.intersect(value.requirement())) {
+        if (auto newRequirement = intersections.intersect(initialRequirement, value.requirement())) {
           if (!newRequirement->satisfiedBy(value._version)) {
-            throw Exception::UnsatisfiableConstraints("Cannot satisfy " + toString(*newRequirement) + " with " + toString(value._version));
+            Incompatibility incompatibility;
+            incompatibility.addSelection(project, value._version);
+            blameDependent(incompatibility, project, initialRequirement, dependent);
+
+            // If the new requirement would've been satisfied on its own, the
+            // existing requirements are also at fault.
+            if (initialRequirement.satisfiedBy(value._version)) {
+              blameDependents(incompatibility, project);
+            }
+
+            throw makeConflict(Exception::UnsatisfiableConstraints("Cannot satisfy " + toString(*newRequirement) + " with " + toString(value._version)), std::move(incompatibility));
           }
 
-          value.setRequirement(std::move(newRequirement));
+          value._requirement = std::move(newRequirement);
         } else {
-          throw Exception::MutuallyExclusiveConstraints(toString(value.requirement()) + " and " + toString(initialRequirement) + " are mutually exclusive");
+          // The requirements are at fault, regardless of the version chosen.
+          Incompatibility incompatibility;
+          blameDependent(incompatibility, project, initialRequirement, dependent);
+          blameDependents(incompatibility, project);
+
+          throw makeConflict(Exception::MutuallyExclusiveConstraints(toString(value.requirement()) + " and " + toString(initialRequirement) + " are mutually exclusive"), std::move(incompatibility));
         }
       } else {
-        _nodeMap.emplace(std::make_pair(key, NodeValue(node._version, initialRequirement)));
+        assert(initialRequirement.satisfiedBy(value._version));
       }
 
       if (dependent) {
-        _edges[*dependent].insert(key);
+        value._dependents = std::make_shared<const Dependent>(Dependent{*dependent, std::move(value._dependents)});
       } else {
-        _roots.insert(key);
+        value._rootRequirements.emplace_back(requirement);
       }
+
+      _nodeMap.insert(project, std::move(value));
     }
 
-    ArbiterResolvedDependencyGraph resolvedGraph () const
+    /**
+     * Returns the version selected for the given project, or nullptr if the
+     * project does not exist in the graph.
+     */
+    const ArbiterSelectedVersion *selectedVersion (ProjectID project) const
     {
-      ArbiterResolvedDependencyGraph resolved;
-      if (_nodeMap.empty()) {
-        return resolved;
+      if (const NodeValue *value = _nodeMap.find(project)) {
+        return &value->_version;
+      } else {
+        return nullptr;
+      }
+    }
+
+    /**
+     * Adds the choice which introduced `requirement` upon `project` to the
+     * given incompatibility.
+     *
+     * `dependent` must already exist in the graph, if specified.
+     */
+    void blameDependent (Incompatibility &incompatibility, ProjectID project, const ArbiterRequirement &requirement, const Optional<ProjectID> &dependent) const
+    {
+      if (dependent) {
+        incompatibility.addSelection(*dependent, _nodeMap.at(*dependent)._version);
+      } else {
+        incompatibility.addRootRequirement(project, requirement);
       }
+    }
 
-      // Contains edges which still need to be added to the resolved graph.
-      std::unordered_map<NodeKey, std::unordered_set<NodeKey>> remainingEdges;
+    /**
+     * Adds all of the choices which have placed requirements upon `project`
+     * so far to the given incompatibility.
+     */
+    void blameDependents (Incompatibility &incompatibility, ProjectID project) const
+    {
+      const NodeValue *value = _nodeMap.find(project);
+      if (!value) {
+        return;
+      }
 
-      // Contains dependencies without any dependencies themselves.
-      ArbiterResolvedDependencyGraph::DepthSet leaves;
+      for (const auto &rootRequirement : value->_rootRequirements) {
+        incompatibility.addRootRequirement(project, *rootRequirement);
+      }
 
-      for (const auto &pair : _nodeMap) {
-        const NodeKey &key = pair.first;
-        const auto it = _edges.find(key);
+      for (const Dependent *dependent = value->_dependents.get(); dependent; dependent = dependent->_next.get()) {
+        incompatibility.addSelection(dependent->_project, _nodeMap.at(dependent->_project)._version);
+      }
+    }
 
-        if (it == _edges.end()) {
-          leaves.emplace(resolveNode(key));
-        } else {
-          remainingEdges[key] = it->second;
+    /**
+     * Converts this graph into layers, in which each project appears one
+     * depth beyond the deepest of its dependencies (or at depth zero if it
+     * has none).
+     *
+     * Throws Exception::DependencyCycle if any projects depend upon each
+     * other.
+     */
+    ArbiterResolvedDependencyGraph resolvedGraph (const ProjectTable &projects) const noexcept(false)
+    {
+      const size_t count = _nodeMap.size();
+
+      // Number every node, so the rest can work with flat arrays.
+      std::vector<const NodeKey *> keys;
+      std::vector<const NodeValue *> values;
+      std::unordered_map<NodeKey, size_t> indices;
+
+      keys.reserve(count);
+      values.reserve(count);
+      indices.reserve(count);
+
+      _nodeMap.forEach([&](const NodeKey &key, const NodeValue &value) {
+        indices.emplace(key, keys.size());
+        keys.emplace_back(&key);
+        values.emplace_back(&value);
+      });
+
+      // For each node, the distinct nodes which depend upon it, and the number
+      // of its own dependencies which have not been placed yet.
+      std::vector<std::vector<size_t>> dependents(count);
+      std::vector<size_t> unplacedDependencies(count, 0);
+      std::vector<size_t> lastDependency(count, count);
+
+      for (size_t index = 0; index < count; ++index) {
+        for (const Dependent *dependent = values[index]->_dependents.get(); dependent; dependent = dependent->_next.get()) {
+          const size_t dependentIndex = indices.at(dependent->_project);
+
+          // The same project may have placed several requirements upon this
+          // one, but that's still only one edge.
+          if (lastDependency[dependentIndex] != index) {
+            lastDependency[dependentIndex] = index;
+            dependents[index].emplace_back(dependentIndex);
+            ++unplacedDependencies[dependentIndex];
+          }
         }
       }
 
-      resolved._depths.emplace_back(std::move(leaves));
+      std::vector<size_t> current;
+      for (size_t index = 0; index < count; ++index) {
+        if (unplacedDependencies[index] == 0) {
+          current.emplace_back(index);
+        }
+      }
 
-      while (!remainingEdges.empty()) {
-        ArbiterResolvedDependencyGraph::DepthSet thisDepth;
+      ArbiterResolvedDependencyGraph resolved;
+      size_t placedCount = 0;
+      std::vector<size_t> next;
 
-        for (auto edgeIt = remainingEdges.begin(); edgeIt != remainingEdges.end(); ) {
-          const NodeKey &dependent = edgeIt->first;
-          auto &dependencies = edgeIt->second;
+      while (!current.empty()) {
+        ArbiterResolvedDependencyGraph::DepthSet depth;
+        depth.reserve(current.size());
 
-          for (auto depIt = dependencies.begin(); depIt != dependencies.end(); ) {
-            const NodeKey &dependency = *depIt;
+        for (size_t index : current) {
+          depth.emplace(resolveNode(projects, *keys[index], *values[index]));
 
-            // If this dependency is in the graph already, it can be removed
-            // from the list of remaining edges.
-            if (resolved.contains(resolveNode(dependency))) {
-              depIt = dependencies.erase(depIt);
-            } else {
-              ++depIt;
+          for (size_t dependentIndex : dependents[index]) {
+            if (--unplacedDependencies[dependentIndex] == 0) {
+              next.emplace_back(dependentIndex);
             }
           }
+        }
 
-          // If all dependencies are now in the graph, we can add this node to
-          // the current depth we're building.
-          if (dependencies.empty()) {
-            thisDepth.emplace(resolveNode(dependent));
-            edgeIt = remainingEdges.erase(edgeIt);
-          } else {
-            ++edgeIt;
-          }
+        placedCount += current.size();
+        resolved._depths.emplace_back(std::move(depth));
+
+        current.clear();
+        std::swap(current, next);
+      }
+
+      if (placedCount < count) {
+        std::ostringstream description;
+        description << "Dependency cycle between";
+
+        // Describe the cycle in the order of its identifiers, rather than
+        // whatever order the IDs happened to be assigned in.
+        std::vector<size_t> cycle = findCycle(dependents, unplacedDependencies);
+        std::sort(cycle.begin(), cycle.end(), [&](size_t lhs, size_t rhs) {
+          return projects.lessThan(*keys[lhs], *keys[rhs]);
+        });
+
+        const char *separator = " ";
+        for (size_t index : cycle) {
+          description << separator << resolveNode(projects, *keys[index], *values[index]);
+          separator = ", ";
         }
 
-        resolved._depths.emplace_back(std::move(thisDepth));
+        throw Exception::DependencyCycle(description.str());
       }
 
-      assert(resolved.count() == _nodeMap.size());
+      assert(resolved.count() == count);
       return resolved;
     }
 
-    std::ostream &describe (std::ostream &os) const
+    std::ostream &describe (std::ostream &os, const ProjectTable &projects) const
     {
       os << "Roots:";
-      for (const NodeKey &key : _roots) {
-        os << "\n\t" << resolveNode(key);
-      }
+      _nodeMap.forEach([&](const NodeKey &key, const NodeValue &value) {
+        if (!value._rootRequirements.empty()) {
+          os << "\n\t" << resolveNode(projects, key, value);
+        }
+      });
 
       os << "\n\nEdges";
-      for (const auto &pair : _edges) {
+      for (const auto &pair : edges()) {
         const NodeKey &key = pair.first;
-        os << "\n\t" << key << " ->";
+        os << "\n\t" << projects.lookup(key) << " ->";
 
         for (const NodeKey &dependency : pair.second) {
-          os << "\n\t\t" << resolveNode(dependency);
+          os << "\n\t\t" << resolveNode(projects, dependency, _nodeMap.at(dependency));
         }
       }
 
@@ -151,273 +310,2449 @@ class DependencyGraph final
     }
 
   private:
-    using NodeKey = ArbiterProjectIdentifier;
+    using NodeKey = ProjectID;
+    using Edges = std::map<NodeKey, std::unordered_set<NodeKey>>;
+
+    /**
+     * An entry in the list of projects which depend upon a node, most recent
+     * first. Like the nodes themselves, these lists are shared between graphs.
+     */
+    struct Dependent final
+    {
+      public:
+        NodeKey _project;
+        std::shared_ptr<const Dependent> _next;
+    };
 
+    /**
+     * The state of a single project in the graph.
+     *
+     * Values are never modified once they have been inserted into the graph,
+     * since other graphs may be sharing them.
+     */
     struct NodeValue final
     {
       public:
-        const ArbiterSelectedVersion _version;
+        ArbiterSelectedVersion _version;
+
+        /**
+         * The intersection of all requirements placed upon this project.
+         */
+        std::shared_ptr<const ArbiterRequirement> _requirement;
 
-        NodeValue (ArbiterSelectedVersion version, const ArbiterRequirement &requirement)
+        /**
+         * Every requirement placed upon this project by the root dependency
+         * list, which is empty if the project was not listed there.
+         */
+        std::vector<std::shared_ptr<const ArbiterRequirement>> _rootRequirements;
+
+        std::shared_ptr<const Dependent> _dependents;
+
+        NodeValue (ArbiterSelectedVersion version, std::shared_ptr<const ArbiterRequirement> requirement)
           : _version(std::move(version))
-        {
-          setRequirement(requirement);
-        }
+          , _requirement(std::move(requirement))
+        {}
 
         const ArbiterRequirement &requirement () const
         {
           return *_requirement;
         }
+    };
 
-        void setRequirement (const ArbiterRequirement &requirement)
-        {
-          setRequirement(requirement.cloneRequirement());
+    static ArbiterResolvedDependency resolveNode (const ProjectTable &projects, const NodeKey &key, const NodeValue &value)
+    {
+      return ArbiterResolvedDependency(projects.lookup(key), value._version);
+    }
+
+    /**
+     * Finds a strongly connected component of more than one node (or a node
+     * which depends upon itself) among the nodes with unplaced dependencies,
+     * using Tarjan's algorithm with an explicit stack.
+     *
+     * Returns the indices of its nodes.
+     */
+    static std::vector<size_t> findCycle (const std::vector<std::vector<size_t>> &dependents, const std::vector<size_t> &unplacedDependencies)
+    {
+      const size_t count = dependents.size();
+      const size_t unvisited = count;
+
+      std::vector<size_t> order(count, unvisited);
+      std::vector<size_t> lowLink(count, 0);
+      std::vector<char> onStack(count, 0);
+      std::vector<size_t> stack;
+      size_t nextOrder = 0;
+
+      // Each entry is a node being visited, and the index of the next edge
+      // from it to follow.
+      std::vector<std::pair<size_t, size_t>> visits;
+
+      for (size_t root = 0; root < count; ++root) {
+        if (unplacedDependencies[root] == 0 || order[root] != unvisited) {
+          continue;
         }
 
-        void setRequirement (std::unique_ptr<ArbiterRequirement> requirement)
-        {
-          assert(requirement->satisfiedBy(_version));
-          _requirement = std::move(requirement);
+        const auto visit = [&](size_t index) {
+          order[index] = lowLink[index] = nextOrder++;
+          stack.emplace_back(index);
+          onStack[index] = 1;
+          visits.emplace_back(index, 0);
+        };
+
+        visit(root);
+
+        while (!visits.empty()) {
+          const size_t index = visits.back().first;
+          size_t &edge = visits.back().second;
+
+          if (edge < dependents[index].size()) {
+            const size_t other = dependents[index][edge++];
+
+            if (order[other] == unvisited) {
+              visit(other);
+            } else if (onStack[other]) {
+              lowLink[index] = std::min(lowLink[index], order[other]);
+            }
+
+            continue;
+          }
+
+          visits.pop_back();
+          if (!visits.empty()) {
+            const size_t parent = visits.back().first;
+            lowLink[parent] = std::min(lowLink[parent], lowLink[index]);
+          }
+
+          if (lowLink[index] != order[index]) {
+            continue;
+          }
+
+          std::vector<size_t> component;
+          size_t member;
+          do {
+            member = stack.back();
+            stack.pop_back();
+            onStack[member] = 0;
+            component.emplace_back(member);
+          } while (member != index);
+
+          const bool selfDependent = std::find(dependents[index].begin(), dependents[index].end(), index) != dependents[index].end();
+          if (component.size() > 1 || selfDependent) {
+            return component;
+          }
         }
+      }
 
-      private:
-        std::shared_ptr<ArbiterRequirement> _requirement;
-    };
+      // Nodes can only be left unplaced by a cycle.
+      assert(false);
+      return {};
+    }
 
-    static ArbiterResolvedDependency resolveNode (const NodeKey &key, const NodeValue &value)
+    /**
+     * Returns the dependencies of each project which has any, computed from
+     * the recorded dependents of every node.
+     */
+    Edges edges () const
     {
-      return ArbiterResolvedDependency(key, value._version);
+      Edges edges;
+
+      _nodeMap.forEach([&](const NodeKey &key, const NodeValue &value) {
+        for (const Dependent *dependent = value._dependents.get(); dependent; dependent = dependent->_next.get()) {
+          edges[dependent->_project].insert(key);
+        }
+      });
+
+      return edges;
     }
 
-    ArbiterResolvedDependency resolveNode (const NodeKey &key) const
+    PersistentMap<NodeKey, NodeValue> _nodeMap;
+};
+
+/**
+ * A version requirement upon a project, along with the project which
+ * introduced it (or None, if it came from the root dependency list).
+ */
+struct Constraint final
+{
+  public:
+    Optional<ProjectID> _dependent;
+    std::shared_ptr<const ArbiterRequirement> _requirement;
+
+    Constraint (Optional<ProjectID> dependent, std::shared_ptr<const ArbiterRequirement> requirement)
+      : _dependent(std::move(dependent))
+      , _requirement(std::move(requirement))
+    {}
+
+    /**
+     * Returns the versions in `table`, which must be the table for the
+     * project this constraint applies to, that satisfy the requirement.
+     *
+     * The mask is computed on first use and then kept, since the same
+     * constraints are consulted again every time the search returns to their
+     * level. Copies share it.
+     */
+    const Bitset &mask (const VersionTable &table) const
     {
-      return resolveNode(key, _nodeMap.at(key));
+      if (!_mask) {
+        _mask = std::make_shared<const Bitset>(table.mask(*_requirement));
+      }
+
+      return *_mask;
     }
 
-    // TODO: Should these be unordered, with ordering instead applied in
-    // resolvedGraph?
-    std::set<NodeKey> _roots;
-    // TODO: This should probably be a multimap.
-    std::map<NodeKey, std::unordered_set<NodeKey>> _edges;
-    std::unordered_map<NodeKey, NodeValue> _nodeMap;
+  private:
+    mutable std::shared_ptr<const Bitset> _mask;
 };
 
-DependencyGraph resolveDependencies (ArbiterResolver &resolver, const DependencyGraph &baseGraph, std::set<ArbiterDependency> dependencySet, const std::unordered_map<ArbiterProjectIdentifier, ArbiterProjectIdentifier> &dependentsByProject) noexcept(false)
+/**
+ * All of the constraints introduced at one level of the dependency graph,
+ * grouped by the project they apply to.
+ *
+ * Levels are ordered by project ID, which is not stable between runs, so use
+ * sortedProjects() wherever the order matters.
+ */
+using Level = std::map<ProjectID, std::vector<Constraint>>;
+
+/**
+ * Returns the projects in `level`, ordered by their identifiers.
+ */
+std::vector<ProjectID> sortedProjects (const ProjectTable &projects, const Level &level)
 {
-  if (dependencySet.empty()) {
-    return baseGraph;
+  std::vector<ProjectID> sorted;
+  sorted.reserve(level.size());
+
+  for (const auto &pair : level) {
+    sorted.emplace_back(pair.first);
   }
 
-  // This collection is reused when actually building the new dependency graph
-  // below.
-  std::map<ArbiterProjectIdentifier, std::unique_ptr<ArbiterRequirement>> requirementsByProject;
+  std::sort(sorted.begin(), sorted.end(), [&projects](ProjectID lhs, ProjectID rhs) {
+    return projects.lessThan(lhs, rhs);
+  });
+
+  return sorted;
+}
 
-  for (const ArbiterDependency &dependency : dependencySet) {
-    requirementsByProject[dependency._projectIdentifier] = dependency.requirement().cloneRequirement();
+/**
+ * Adds the choices which introduced the given constraints upon `project` to
+ * an incompatibility.
+ */
+void blameConstraints (Incompatibility &incompatibility, const DependencyGraph &graph, ProjectID project, const std::vector<Constraint> &constraints)
+{
+  for (const Constraint &constraint : constraints) {
+    graph.blameDependent(incompatibility, project, *constraint._requirement, constraint._dependent);
   }
+}
 
-  assert(requirementsByProject.size() == dependencySet.size());
+/**
+ * Thrown to unwind a parallel search of a subtree whose result can no longer
+ * be used.
+ */
+struct Abandoned final
+{};
 
-  // Free the dependencySet, as it will no longer be used.
-  reset(dependencySet);
+/**
+ * Enforces the limits configured on a resolver over the course of a single
+ * resolution, and reports its progress. A budget is shared between every
+ * thread exploring the search space.
+ */
+class Budget final
+{
+  public:
+    explicit Budget (const ArbiterResolver &resolver)
+      : _resolver(resolver)
+      , _start(std::chrono::steady_clock::now())
+      , _lastReport(_start)
+    {}
 
-  // This collection needs to exist for as long as the permuted iterators do below.
-  std::map<ArbiterProjectIdentifier, std::vector<ArbiterResolvedDependency>> possibilities;
+    /**
+     * Accounts for trying another candidate version, and reports progress if
+     * it is due.
+     *
+     * Throws an exception if resolution has been cancelled or has exceeded any
+     * limit.
+     */
+    void spendCandidate (size_t depth, size_t decisions) noexcept(false)
+    {
+      const size_t candidates = ++_candidates;
 
-  for (const auto &pair : requirementsByProject) {
-    const ArbiterProjectIdentifier &project = pair.first;
-    const ArbiterRequirement &requirement = *pair.second;
+      if (_resolver.cancelled()) {
+        throw Exception::Cancelled("Resolution was cancelled");
+      }
 
-    std::vector<ArbiterSelectedVersion> versions = resolver.availableVersionsSatisfying(project, requirement);
-    if (versions.empty()) {
-      throw Exception::UnsatisfiableConstraints("Cannot satisfy " + toString(requirement) + " from available versions of " + toString(project));
-    }
+      if (_resolver._candidateLimit && candidates > _resolver._candidateLimit) {
+        throw Exception::LimitExceeded("Exceeded the limit of " + std::to_string(_resolver._candidateLimit) + " candidate versions");
+      }
 
-    // Sort the version list with highest precedence first, so we try the newest
-    // possible versions first.
-    std::sort(versions.begin(), versions.end(), std::greater<ArbiterSelectedVersion>());
+      const bool hasTimeLimit = _resolver._timeLimit != std::chrono::steady_clock::duration::zero();
+      if (!hasTimeLimit && !_resolver._progressCallback) {
+        return;
+      }
 
-    std::vector<ArbiterResolvedDependency> resolutions;
-    resolutions.reserve(versions.size());
+      const auto now = std::chrono::steady_clock::now();
+      if (hasTimeLimit && now - _start > _resolver._timeLimit) {
+        throw Exception::LimitExceeded("Exceeded the time limit for resolution");
+      }
 
-    for (ArbiterSelectedVersion &version : versions) {
-      resolutions.emplace_back(project, std::move(version));
+      if (_resolver._progressCallback) {
+        report(now, ArbiterResolverProgress{depth, decisions, candidates, _backtracks.load()});
+      }
     }
 
-    possibilities[project] = std::move(resolutions);
-  }
+    /**
+     * Accounts for backtracking after a conflict.
+     */
+    void recordBacktrack () noexcept
+    {
+      ++_backtracks;
+    }
 
-  assert(possibilities.size() == requirementsByProject.size());
+  private:
+    const ArbiterResolver &_resolver;
+    const std::chrono::steady_clock::time_point _start;
 
-  using Iterator = std::vector<ArbiterResolvedDependency>::const_iterator;
+    std::atomic<size_t> _candidates{0};
+    std::atomic<size_t> _backtracks{0};
 
-  std::vector<IteratorRange<Iterator>> ranges;
-  for (const auto &pair : possibilities) {
-    const std::vector<ArbiterResolvedDependency> &dependencies = pair.second;
-    ranges.emplace_back(dependencies.cbegin(), dependencies.cend());
-  }
+    /**
+     * Guarded by the resolver's `_progressMutex`.
+     */
+    std::chrono::steady_clock::time_point _lastReport;
 
-  assert(ranges.size() == possibilities.size());
+    void report (std::chrono::steady_clock::time_point now, const ArbiterResolverProgress &progress)
+    {
+      std::lock_guard<std::mutex> guard(_resolver._progressMutex);
+      if (now - _lastReport < _resolver._progressInterval) {
+        return;
+      }
 
-  std::exception_ptr lastException = std::make_exception_ptr(Exception::UnsatisfiableConstraints("No further combinations to attempt"));
+      _lastReport = now;
+      _resolver._progressCallback(&_resolver, &progress);
+    }
+};
 
-  for (PermutationIterator<Iterator> permuter(std::move(ranges)); permuter; ++permuter) {
-    try {
-      std::vector<ArbiterResolvedDependency> choices = *permuter;
+/**
+ * The state of a single search through possible dependency graphs.
+ */
+struct Search final
+{
+  public:
+    ArbiterResolver &_resolver;
+    Budget &_budget;
 
-      DependencyGraph candidate = baseGraph;
+    /**
+     * The constraints from the root dependency list being resolved.
+     */
+    const Level &_roots;
 
-      // Add everything to the graph first, to throw any exceptions that would
-      // occur before we perform the computation- and memory-expensive stuff for
-      // transitive dependencies.
-      for (ArbiterResolvedDependency &dependency : choices) {
-        const ArbiterRequirement &requirement = *requirementsByProject.at(dependency._project);
-        candidate.addNode(dependency, requirement, maybeAt(dependentsByProject, dependency._project));
-      }
+    /**
+     * When searching one subtree of a parallel search, the index of that
+     * subtree.
+     */
+    size_t _subtree = 0;
 
-      // Collect immediate children for the next phase of dependency resolution,
-      // so we can permute their versions as a group (for something
-      // approximating breadth-first search).
-      std::set<ArbiterDependency> collectedTransitives;
-      std::unordered_map<ArbiterProjectIdentifier, ArbiterProjectIdentifier> dependentsByTransitive;
+    /**
+     * When searching one subtree of a parallel search, the lowest index of any
+     * subtree which has finished with a definitive result.
+     */
+    const std::atomic<size_t> *_finishedSubtree = nullptr;
 
-      for (ArbiterResolvedDependency &dependency : choices) {
-        std::vector<ArbiterDependency> transitives = resolver.fetchDependencies(dependency._project, dependency._version)._dependencies;
+    /**
+     * When searching one subtree of a parallel search, the incompatibilities
+     * learned by this search. They are kept apart from the resolver's until
+     * the parallel search has finished, so that what each subtree learns does
+     * not depend upon how far the others have got.
+     */
+    IncompatibilityStore *_learned = nullptr;
 
-        for (const ArbiterDependency &transitive : transitives) {
-          dependentsByTransitive[transitive._projectIdentifier] = dependency._project;
-        }
+    Search (ArbiterResolver &resolver, Budget &budget, const Level &roots)
+      : _resolver(resolver)
+      , _budget(budget)
+      , _roots(roots)
+    {}
 
-        collectedTransitives.insert(transitives.begin(), transitives.end());
+    /**
+     * Returns whether the root dependency list places `requirement`, which
+     * must be interned, upon `project`, so that incompatibilities blamed upon
+     * it still hold.
+     */
+    bool hasRootRequirement (ProjectID project, const ArbiterRequirement &requirement) const
+    {
+      const auto it = _roots.find(project);
+      if (it == _roots.end()) {
+        return false;
       }
 
-      reset(choices);
+      // Root constraints come straight from dependencies, which intern their
+      // requirements.
+      return std::any_of(it->second.begin(), it->second.end(), [&](const Constraint &constraint) {
+        return constraint._requirement.get() == &requirement;
+      });
+    }
 
-      return resolveDependencies(resolver, candidate, std::move(collectedTransitives), std::move(dependentsByTransitive));
-    } catch (Arbiter::Exception::Base &ex) {
-      lastException = std::current_exception();
+    /**
+     * Records an incompatibility learned during this search.
+     */
+    void learnIncompatibility (const Incompatibility &incompatibility)
+    {
+      if (_learned) {
+        _learned->add(incompatibility);
+      } else {
+        _resolver.learnIncompatibility(incompatibility);
+      }
     }
-  }
 
-  std::rethrow_exception(lastException);
-}
+    /**
+     * Looks for an incompatibility known to this search which involves the
+     * choice of `version` for `project`, and whose other selections are all
+     * satisfied according to `lookup`.
+     */
+    template<typename Lookup>
+    Optional<Incompatibility> findKnownIncompatibility (ProjectID project, const ArbiterSelectedVersion &version, const Lookup &lookup) const
+    {
+      const auto hasRootRequirement = [this](ProjectID other, const ArbiterRequirement &requirement) {
+        return this->hasRootRequirement(other, requirement);
+      };
 
-class UnversionedRequirementVisitor final : public Requirement::Visitor
-{
-  public:
-    std::vector<Requirement::Unversioned::Metadata> _allMetadata;
+      if (Optional<Incompatibility> known = _resolver.findKnownIncompatibility(project, version, lookup, hasRootRequirement)) {
+        return known;
+      }
 
-    void operator() (const ArbiterRequirement &requirement) override
+      if (_learned) {
+        if (const Incompatibility *incompatibility = _learned->findSatisfied(project, version, lookup, hasRootRequirement)) {
+          return makeOptional(*incompatibility);
+        }
+      }
+
+      return None();
+    }
+
+    /**
+     * Throws Abandoned if the result of this search will not be used.
+     */
+    void checkAbandoned () const noexcept(false)
     {
-      if (const auto *ptr = dynamic_cast<const Requirement::Unversioned *>(&requirement)) {
-        _allMetadata.emplace_back(ptr->_metadata);
+      if (_finishedSubtree && _finishedSubtree->load(std::memory_order_relaxed) < _subtree) {
+        throw Abandoned();
       }
     }
 };
 
-} // namespace
-
-ArbiterResolver *ArbiterCreateResolver (ArbiterResolverBehaviors behaviors, const ArbiterDependencyList *dependencyList, const void *context)
+/**
+ * Intersects all of the constraints upon `project` into a single requirement.
+ *
+ * Throws a Conflict if they are mutually exclusive.
+ */
+std::shared_ptr<const ArbiterRequirement> combinedRequirement (ArbiterResolver &resolver, const DependencyGraph &graph, ProjectID project, const std::vector<Constraint> &constraints) noexcept(false)
 {
-  return new ArbiterResolver(std::move(behaviors), *dependencyList, context);
-}
+  std::shared_ptr<const ArbiterRequirement> requirement = constraints.front()._requirement;
+  for (auto it = std::next(constraints.begin()); it != constraints.end(); ++it) {
+    std::shared_ptr<const ArbiterRequirement> intersected = resolver._intersections.intersect(*requirement, *it->_requirement);
+    if (!intersected) {
+      Incompatibility incompatibility;
+      blameConstraints(incompatibility, graph, project, constraints);
+
+      throw makeConflict(Exception::MutuallyExclusiveConstraints(toString(*requirement) + " and " + toString(*it->_requirement) + " are mutually exclusive"), std::move(incompatibility));
+    }
 
-const void *ArbiterResolverContext (const ArbiterResolver *resolver)
-{
-  return resolver->_context;
+    requirement = std::move(intersected);
+  }
+
+  return requirement;
 }
 
-ArbiterResolvedDependencyGraph *ArbiterResolverCreateResolvedDependencyGraph (ArbiterResolver *resolver, char **error)
+/**
+ * Returns the versions in `table` which satisfy every one of `constraints`.
+ */
+Bitset candidateDomain (const VersionTable &table, const std::vector<Constraint> &constraints)
 {
-  Optional<ArbiterResolvedDependencyGraph> dependencies;
-
-  try {
-    dependencies = resolver->resolve();
-  } catch (const std::exception &ex) {
-    if (error) {
-      *error = copyCString(ex.what()).release();
-    }
-
-    return nullptr;
+  Bitset domain = constraints.front().mask(table);
+  for (auto it = std::next(constraints.begin()); it != constraints.end() && !domain.none(); ++it) {
+    domain.intersect(it->mask(table));
   }
 
-  return new ArbiterResolvedDependencyGraph(std::move(*dependencies));
+  return domain;
 }
 
-void ArbiterFreeResolver (ArbiterResolver *resolver)
+/**
+ * Returns the version of `project` chosen by a previous resolution, if there
+ * is one and it satisfies all of the constraints upon the project.
+ *
+ * Throws a Conflict if the constraints are mutually exclusive.
+ */
+Optional<ArbiterSelectedVersion> preferredCandidate (Search &search, const DependencyGraph &graph, ProjectID project, const std::vector<Constraint> &constraints) noexcept(false)
 {
-  delete resolver;
+  const ArbiterSelectedVersion *preferred = search._resolver.preferredVersion(project);
+  if (preferred && combinedRequirement(search._resolver, graph, project, constraints)->satisfiedBy(*preferred)) {
+    return makeOptional(*preferred);
+  } else {
+    return None();
+  }
 }
 
-ArbiterDependencyList ArbiterResolver::fetchDependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version) noexcept(false)
+/**
+ * Returns the versions of `project` which could be chosen given all of the
+ * constraints upon it, ordered from newest to oldest, except for `excluded`
+ * (if not nullptr).
+ *
+ * Throws a Conflict if there are none.
+ */
+CandidateList candidateVersions (Search &search, const DependencyGraph &graph, ProjectID project, const std::vector<Constraint> &constraints, const ArbiterSelectedVersion *excluded = nullptr) noexcept(false)
 {
-  ArbiterResolvedDependency resolved(project, version);
-  if (auto list = maybeAt(_cachedDependencies, resolved)) {
-    return *list;
-  }
+  ArbiterResolver &resolver = search._resolver;
+  std::shared_ptr<const ArbiterRequirement> requirement = combinedRequirement(resolver, graph, project, constraints);
 
-  char *error = nullptr;
-  std::unique_ptr<ArbiterDependencyList> dependencyList(_behaviors.createDependencyList(this, &project, &version, &error));
+  CandidateList versions;
 
-  if (dependencyList) {
-    assert(!error);
+  std::vector<ArbiterSelectedVersion> metadataVersions = resolver.versionsForMetadata(*requirement);
+  const bool needsSort = !metadataVersions.empty();
 
-    _cachedDependencies[resolved] = *dependencyList;
-    return std::move(*dependencyList);
-  } else if (error) {
-    throw Exception::UserError(copyAcquireCString(error));
-  } else {
-    throw Exception::UserError();
+  for (ArbiterSelectedVersion &version : metadataVersions) {
+    versions.append(std::move(version));
   }
-}
 
-ArbiterSelectedVersionList ArbiterResolver::fetchAvailableVersions (const ArbiterProjectIdentifier &project) noexcept(false)
-{
-  if (auto list = maybeAt(_cachedAvailableVersions, project)) {
-    return *list;
+  const std::shared_ptr<const VersionTable> table = resolver.fetchVersionTable(project);
+  const Bitset domain = candidateDomain(*table, constraints);
+  versions.append(table, domain);
+
+  if (excluded) {
+    versions.remove(*excluded);
   }
 
-  char *error = nullptr;
-  std::unique_ptr<ArbiterSelectedVersionList> versionList(_behaviors.createAvailableVersionsList(this, &project, &error));
+  if (versions.empty()) {
+    Incompatibility incompatibility;
+    blameConstraints(incompatibility, graph, project, constraints);
+    incompatibility.addVersionList(project);
+
+    throw makeConflict(Exception::UnsatisfiableConstraints("Cannot satisfy " + toString(*requirement) + " from available versions of " + toString(resolver._projects.lookup(project))), std::move(incompatibility));
+  }
+
+  // Versions found by their metadata may belong anywhere in the order.
+  if (needsSort) {
+    versions.sortNewestFirst();
+  }
+
+  return versions;
+}
+
+/**
+ * Sorts the projects to be decided upon at one level, which must be ordered
+ * by identifier to begin with, into the order that the resolver's ordering
+ * heuristic prefers.
+ *
+ * Throws a Conflict if any project has mutually exclusive constraints upon it.
+ */
+void orderDecisions (Search &search, const DependencyGraph &graph, const Level &level, std::vector<ProjectID> &decisions) noexcept(false)
+{
+  if (search._resolver._decisionOrdering != ArbiterResolverDecisionOrderingMostConstrainedFirst || decisions.size() < 2) {
+    return;
+  }
+
+  struct Ranked final
+  {
+    public:
+      size_t _candidateCount;
+      size_t _dependentCount;
+      ProjectID _project;
+  };
+
+  std::vector<Ranked> ranked;
+  ranked.reserve(decisions.size());
+
+  for (ProjectID project : decisions) {
+    const std::vector<Constraint> &constraints = level.at(project);
+
+    // A preferred version will be tried on its own first, so avoid fetching
+    // the other versions just to count them.
+    size_t candidateCount = 1;
+    if (!preferredCandidate(search, graph, project, constraints)) {
+      ArbiterResolver &resolver = search._resolver;
+
+      candidateCount = resolver.versionsForMetadata(*combinedRequirement(resolver, graph, project, constraints)).size();
+      candidateCount += candidateDomain(*resolver.fetchVersionTable(project), constraints).count();
+    }
+
+    ranked.emplace_back(Ranked{candidateCount, constraints.size(), project});
+  }
+
+  // Keep the existing order between equally constrained projects, so that
+  // resolution remains deterministic.
+  std::stable_sort(ranked.begin(), ranked.end(), [](const Ranked &lhs, const Ranked &rhs) {
+    if (lhs._candidateCount != rhs._candidateCount) {
+      return lhs._candidateCount < rhs._candidateCount;
+    } else {
+      return lhs._dependentCount > rhs._dependentCount;
+    }
+  });
+
+  for (size_t i = 0; i < ranked.size(); ++i) {
+    decisions[i] = ranked[i]._project;
+  }
+}
+
+/**
+ * Searches for a consistent dependency graph, deciding the version of one
+ * project at a time, and moving on to the transitive dependencies of each
+ * level once every project in it has been decided (for something
+ * approximating breadth-first search).
+ *
+ * The search is driven by an explicit stack of frames rather than recursion,
+ * so arbitrarily deep dependency chains can be resolved without exhausting
+ * the call stack. Frames are recycled rather than freed whenever the search
+ * backtracks, so their allocations can be reused.
+ *
+ * A conflict unwinds the stack straight back to the most recent decision
+ * which contributed to it, so only the projects actually involved are
+ * revisited. Undoing a decision is just a matter of returning to the graph
+ * saved in its frame, since every attempt is made on a persistent copy.
+ */
+class Searcher final
+{
+  public:
+    explicit Searcher (Search &search)
+      : _search(search)
+    {}
+
+    /**
+     * Resolves `level` and all of its transitive dependencies on top of
+     * `graph`.
+     */
+    DependencyGraph run (DependencyGraph graph, Level level) noexcept(false)
+    {
+      const size_t levelIndex = pushLevel(std::move(level));
+      enterLevel(levelIndex, graph);
+
+      return runFrom(std::move(graph), levelIndex, 0);
+    }
+
+    /**
+     * Resolves `level` and all of its transitive dependencies on top of
+     * `graph`, which must already contain choices for the first
+     * `firstDecision` projects in `decisions`. Those choices will not be
+     * revisited.
+     */
+    DependencyGraph run (DependencyGraph graph, Level level, std::vector<ProjectID> decisions, size_t firstDecision) noexcept(false)
+    {
+      const size_t levelIndex = pushLevel(std::move(level));
+      _levels[levelIndex]._decisions = std::move(decisions);
+
+      return runFrom(std::move(graph), levelIndex, firstDecision);
+    }
+
+  private:
+    /**
+     * One level of the dependency graph.
+     */
+    struct LevelFrame final
+    {
+      public:
+        Level _level;
+
+        /**
+         * Projects which are being chosen for the first time at this level, as
+         * opposed to those which were already chosen at a shallower level.
+         */
+        std::vector<ProjectID> _decisions;
+    };
+
+    /**
+     * The choice of a version for one project.
+     */
+    struct DecisionFrame final
+    {
+      public:
+        size_t _levelIndex = 0;
+        size_t _decisionIndex = 0;
+
+        /**
+         * The graph before this decision was made.
+         */
+        DependencyGraph _graph;
+
+        /**
+         * Candidate versions for the project, from newest to oldest, and the
+         * index of the next one to try.
+         */
+        CandidateList _versions;
+        size_t _nextVersion = 0;
+
+        /**
+         * Whether `_versions` holds only the version preferred by a previous
+         * resolution, with the rest of the available versions still to be
+         * considered.
+         */
+        bool _preferred = false;
+
+        /**
+         * Accumulates the reasons why each version tried so far failed.
+         */
+        Incompatibility _cause;
+
+        /**
+         * The error from the last version which failed, if any.
+         */
+        std::exception_ptr _lastError;
+    };
+
+    Search &_search;
+
+    std::vector<LevelFrame> _levels;
+    size_t _levelCount = 0;
+
+    std::vector<DecisionFrame> _decisions;
+    size_t _decisionCount = 0;
+
+    size_t pushLevel (Level level)
+    {
+      if (_levelCount == _levels.size()) {
+        _levels.emplace_back();
+      }
+
+      LevelFrame &frame = _levels[_levelCount];
+      frame._level = std::move(level);
+      frame._decisions.clear();
+
+      return _levelCount++;
+    }
+
+    /**
+     * Pops every level deeper than `levelIndex`.
+     */
+    void popLevelsAfter (size_t levelIndex)
+    {
+      while (_levelCount > levelIndex + 1) {
+        _levels[--_levelCount]._level.clear();
+      }
+    }
+
+    DecisionFrame &pushDecision (size_t levelIndex, size_t decisionIndex, const DependencyGraph &graph, CandidateList &versions, bool preferred)
+    {
+      if (_decisionCount == _decisions.size()) {
+        _decisions.emplace_back();
+      }
+
+      DecisionFrame &frame = _decisions[_decisionCount++];
+      frame._levelIndex = levelIndex;
+      frame._decisionIndex = decisionIndex;
+      frame._graph = graph;
+      frame._nextVersion = 0;
+      frame._preferred = preferred;
+
+      // Swap, so that the frame's previous storage is handed back to be reused
+      // for the next list of candidates.
+      std::swap(frame._versions, versions);
+      versions.clear();
+
+      frame._lastError = nullptr;
+      return frame;
+    }
+
+    void popDecision ()
+    {
+      DecisionFrame &frame = _decisions[--_decisionCount];
+
+      // Release anything that might be keeping other data alive, but keep the
+      // frame's storage around for reuse.
+      frame._graph = DependencyGraph();
+      frame._versions.clear();
+      frame._cause = Incompatibility();
+      frame._lastError = nullptr;
+    }
+
+    ProjectID project (const DecisionFrame &frame) const
+    {
+      return _levels[frame._levelIndex]._decisions[frame._decisionIndex];
+    }
+
+    const std::vector<Constraint> &constraints (const DecisionFrame &frame) const
+    {
+      return _levels[frame._levelIndex]._level.at(project(frame));
+    }
+
+    /**
+     * Adds the constraints from the given level upon projects which have
+     * already been chosen to `graph`, and determines which projects need to be
+     * decided.
+     *
+     * Throws a Conflict if any of the new constraints are inconsistent with an
+     * existing choice.
+     */
+    void enterLevel (size_t levelIndex, DependencyGraph &graph) noexcept(false)
+    {
+      LevelFrame &frame = _levels[levelIndex];
+
+      for (ProjectID project : sortedProjects(_search._resolver._projects, frame._level)) {
+        if (const ArbiterSelectedVersion *existing = graph.selectedVersion(project)) {
+          // New constraints upon an existing choice don't require any
+          // decision, but may conflict with it.
+          for (const Constraint &constraint : frame._level.at(project)) {
+            graph.addNode(_search._resolver._intersections, project, *existing, constraint._requirement, constraint._dependent);
+          }
+        } else {
+          frame._decisions.emplace_back(project);
+        }
+      }
+
+      // Start fetching the versions of every project at this level up front,
+      // since they will all be needed before the next level can begin. Those
+      // with a preferred version will probably not need them at all.
+      for (ProjectID project : frame._decisions) {
+        if (!_search._resolver.preferredVersion(project)) {
+          _search._resolver.prefetchAvailableVersions(project);
+        }
+      }
+
+      orderDecisions(_search, graph, frame._level, frame._decisions);
+    }
+
+    /**
+     * Collects the dependencies of every project decided at the given level,
+     * to form the next level.
+     */
+    Level nextLevel (size_t levelIndex, const DependencyGraph &graph) noexcept(false)
+    {
+      ArbiterResolver &resolver = _search._resolver;
+      const std::vector<ProjectID> &decisions = _levels[levelIndex]._decisions;
+
+      std::vector<ProjectVersion> chosen;
+      chosen.reserve(decisions.size());
+
+      for (ProjectID project : decisions) {
+        chosen.emplace_back(project, *graph.selectedVersion(project));
+      }
+
+      const std::vector<std::shared_ptr<const ArbiterDependencyList>> dependencyLists = resolver.fetchAllDependencies(chosen);
+
+      Level level;
+      for (size_t i = 0; i < decisions.size(); ++i) {
+        for (const ArbiterDependency &transitive : dependencyLists[i]->_dependencies) {
+          level[resolver._projects.intern(transitive._projectIdentifier)].emplace_back(makeOptional(decisions[i]), transitive.sharedRequirement());
+        }
+      }
+
+      return level;
+    }
+
+    /**
+     * Tries the remaining candidate versions in the given frame, returning the
+     * graph with the first one that fits.
+     *
+     * If every candidate fails, or a failure occurs which doesn't involve
+     * this decision, returns None and sets `conflict` to the reason.
+     */
+    Optional<DependencyGraph> tryNextVersion (DecisionFrame &frame, Optional<Conflict> &conflict) noexcept(false)
+    {
+      ArbiterResolver &resolver = _search._resolver;
+      const ProjectID project = this->project(frame);
+      const std::vector<Constraint> &constraints = this->constraints(frame);
+
+      while (frame._nextVersion < frame._versions.size() || (frame._preferred && considerAllVersions(frame))) {
+        _search.checkAbandoned();
+        _search._budget.spendCandidate(_levelCount, _decisionCount);
+
+        const ArbiterSelectedVersion version = frame._versions[frame._nextVersion++];
+
+        const auto lookup = [&](ProjectID other) -> const ArbiterSelectedVersion * {
+          if (other == project) {
+            return &version;
+          } else {
+            return frame._graph.selectedVersion(other);
+          }
+        };
+
+        // Skip any version which has already been proven impossible alongside
+        // the choices made so far.
+        if (Optional<Incompatibility> known = _search.findKnownIncompatibility(project, version, lookup)) {
+          frame._cause.merge(*known);
+          continue;
+        }
+
+        // This is cheap, since the candidate shares storage with the graph.
+        DependencyGraph candidate = frame._graph;
+
+        try {
+          for (const Constraint &constraint : constraints) {
+            candidate.addNode(resolver._intersections, project, version, constraint._requirement, constraint._dependent);
+          }
+        } catch (Conflict &ex) {
+          _search.learnIncompatibility(ex._incompatibility);
+
+          // If this choice did not contribute to the conflict, every other
+          // version of this project would fail in the same way.
+          if (!ex._incompatibility.involves(project)) {
+            conflict = std::move(ex);
+            return None();
+          }
+
+          frame._cause.merge(ex._incompatibility);
+          frame._lastError = ex._error;
+          continue;
+        }
+
+        return makeOptional(std::move(candidate));
+      }
+
+      // Every version of this project failed, so the blame lies with whatever
+      // constrained it.
+      Incompatibility cause = std::move(frame._cause);
+      cause._selections.erase(project);
+      cause.addVersionList(project);
+      blameConstraints(cause, frame._graph, project, constraints);
+
+      _search.learnIncompatibility(cause);
+
+      // Describing the project calls back into user code, so only do so if no
+      // version failed with an error of its own.
+      if (!frame._lastError) {
+        frame._lastError = std::make_exception_ptr(Exception::UnsatisfiableConstraints("No further versions of " + toString(_search._resolver._projects.lookup(project)) + " to attempt"));
+      }
+
+      conflict = Conflict(frame._lastError, std::move(cause));
+      return None();
+    }
+
+    /**
+     * Replaces the preferred version in the given frame with every other
+     * version which satisfies the constraints, now that the preferred one has
+     * failed.
+     *
+     * Returns whether there are any such versions.
+     */
+    bool considerAllVersions (DecisionFrame &frame) noexcept(false)
+    {
+      const ProjectID project = this->project(frame);
+
+      frame._preferred = false;
+      frame._nextVersion = 0;
+
+      try {
+        frame._versions = candidateVersions(_search, frame._graph, project, constraints(frame), _search._resolver.preferredVersion(project));
+      } catch (const Conflict &) {
+        // This will be blamed on the constraints once the frame is exhausted,
+        // just as if every version had been tried.
+        frame._versions.clear();
+      }
+
+      return !frame._versions.empty();
+    }
+
+    DependencyGraph runFrom (DependencyGraph graph, size_t levelIndex, size_t decisionIndex) noexcept(false)
+    {
+      ArbiterResolver &resolver = _search._resolver;
+      const size_t baseDecisionCount = _decisionCount;
+
+      Optional<Conflict> conflict;
+      CandidateList versions;
+
+      while (true) {
+        if (conflict) {
+          _search._budget.recordBacktrack();
+
+          // Jump straight back to the most recent choice which contributed to
+          // the conflict.
+          while (_decisionCount > baseDecisionCount && !conflict->_incompatibility.involves(project(_decisions[_decisionCount - 1]))) {
+            popDecision();
+          }
+
+          if (_decisionCount == baseDecisionCount) {
+            throw *conflict;
+          }
+
+          DecisionFrame &frame = _decisions[_decisionCount - 1];
+          popLevelsAfter(frame._levelIndex);
+
+          frame._cause.merge(conflict->_incompatibility);
+          frame._lastError = conflict->_error;
+          conflict = None();
+
+          Optional<DependencyGraph> next = tryNextVersion(frame, conflict);
+          if (!next) {
+            popDecision();
+            continue;
+          }
+
+          graph = std::move(*next);
+          levelIndex = frame._levelIndex;
+          decisionIndex = frame._decisionIndex + 1;
+          continue;
+        }
+
+        if (decisionIndex < _levels[levelIndex]._decisions.size()) {
+          const ProjectID project = _levels[levelIndex]._decisions[decisionIndex];
+          const std::vector<Constraint> &constraints = _levels[levelIndex]._level.at(project);
+          bool preferred = false;
+
+          try {
+            // Try any version preferred by a previous resolution on its own,
+            // without even looking at the others unless it fails.
+            if (Optional<ArbiterSelectedVersion> preferredVersion = preferredCandidate(_search, graph, project, constraints)) {
+              versions.append(std::move(*preferredVersion));
+              preferred = true;
+            } else {
+              versions = candidateVersions(_search, graph, project, constraints);
+            }
+          } catch (Conflict &ex) {
+            _search.learnIncompatibility(ex._incompatibility);
+            conflict = std::move(ex);
+            continue;
+          }
+
+          // Speculatively request the dependencies of the version most likely
+          // to be chosen, so they are ready by the time this level is
+          // complete.
+          resolver.prefetchDependencies(project, versions.front());
+
+          DecisionFrame &frame = pushDecision(levelIndex, decisionIndex, graph, versions, preferred);
+
+          Optional<DependencyGraph> next = tryNextVersion(frame, conflict);
+          if (!next) {
+            popDecision();
+            continue;
+          }
+
+          graph = std::move(*next);
+          ++decisionIndex;
+          continue;
+        }
+
+        // Every project at this level has been decided, so move on to their
+        // dependencies.
+        Level level = nextLevel(levelIndex, graph);
+        if (level.empty()) {
+          return graph;
+        }
+
+        levelIndex = pushLevel(std::move(level));
+        decisionIndex = 0;
+
+        try {
+          enterLevel(levelIndex, graph);
+        } catch (Conflict &ex) {
+          _search.learnIncompatibility(ex._incompatibility);
+          conflict = std::move(ex);
+        }
+      }
+    }
+};
+
+/**
+ * Resolves the root level of dependencies by splitting the search space into
+ * subtrees, and exploring them on a pool of `threadCount` threads.
+ *
+ * Subtrees are formed by fixing the versions of the first few root
+ * dependencies, in the same order that a sequential search would try them.
+ * The result is always that of the lowest-indexed subtree which succeeds (or
+ * fails with an error other than a conflict), so it is identical to what
+ * a sequential search would find. Any subtree with a higher index than one
+ * which has already finished is abandoned.
+ *
+ * Each subtree keeps what it learns to itself until every subtree is done,
+ * since which incompatibilities are known when decides the conflict that is
+ * reported. If every subtree fails, the search is repeated sequentially in
+ * order to report the same error as a sequential search.
+ */
+DependencyGraph resolveInParallel (ArbiterResolver &resolver, Budget &budget, const Level &level, size_t threadCount) noexcept(false)
+{
+  // Aim for more subtrees than threads, since some will finish much more
+  // quickly than others.
+  const size_t subtreesPerThread = 4;
+
+  const DependencyGraph rootGraph;
+  Search rootSearch(resolver, budget, level);
+
+  // Decide upon the root dependencies in the same order as a sequential
+  // search would.
+  std::vector<ProjectID> decisions = sortedProjects(resolver._projects, level);
+  orderDecisions(rootSearch, rootGraph, level, decisions);
+
+  // Root constraints don't depend upon any other choices, so the candidates
+  // for each root dependency can be computed up front.
+  std::vector<CandidateList> prefixVersions;
+  size_t subtreeCount = 1;
+
+  while (prefixVersions.size() < decisions.size() && subtreeCount < threadCount * subtreesPerThread) {
+    const ProjectID project = decisions[prefixVersions.size()];
+    CandidateList versions = candidateVersions(rootSearch, rootGraph, project, level.at(project));
+
+    // Explore any version preferred by a previous resolution first, so that
+    // it wins if it works.
+    if (const ArbiterSelectedVersion *preferred = resolver.preferredVersion(project)) {
+      versions.moveToFront(*preferred);
+    }
+
+    prefixVersions.emplace_back(std::move(versions));
+    subtreeCount *= prefixVersions.back().size();
+  }
+
+  std::atomic<size_t> finishedSubtree(subtreeCount);
+  std::vector<Optional<DependencyGraph>> results(subtreeCount);
+  std::vector<std::exception_ptr> errors(subtreeCount);
+  std::vector<IncompatibilityStore> learned(subtreeCount);
+
+  const auto finish = [&finishedSubtree](size_t subtree) {
+    size_t current = finishedSubtree.load();
+    while (subtree < current && !finishedSubtree.compare_exchange_weak(current, subtree));
+  };
+
+  WorkStealingPool pool(threadCount);
+  pool.run(subtreeCount, [&](size_t subtree) {
+    Search search(resolver, budget, level);
+    search._subtree = subtree;
+    search._finishedSubtree = &finishedSubtree;
+    search._learned = &learned[subtree];
+
+    try {
+      search.checkAbandoned();
+
+      // Decode the subtree index into a version for each fixed project, with
+      // the last one varying fastest.
+      DependencyGraph graph;
+      size_t remainder = subtree;
+
+      for (size_t i = prefixVersions.size(); i-- > 0; ) {
+        const CandidateList &versions = prefixVersions[i];
+        const ArbiterSelectedVersion &version = versions[remainder % versions.size()];
+        remainder /= versions.size();
+
+        for (const Constraint &constraint : level.at(decisions[i])) {
+          graph.addNode(resolver._intersections, decisions[i], version, constraint._requirement, constraint._dependent);
+        }
+      }
+
+      results[subtree] = Searcher(search).run(std::move(graph), level, decisions, prefixVersions.size());
+      finish(subtree);
+    } catch (const Abandoned &) {
+    } catch (Conflict &conflict) {
+      search.learnIncompatibility(conflict._incompatibility);
+    } catch (...) {
+      errors[subtree] = std::current_exception();
+      finish(subtree);
+    }
+  });
+
+  for (size_t subtree = 0; subtree < subtreeCount; ++subtree) {
+    if (results[subtree] || errors[subtree]) {
+      // Keep what a sequential search would have learned on the way here.
+      for (size_t explored = 0; explored <= subtree; ++explored) {
+        for (const Incompatibility &incompatibility : learned[explored].incompatibilities()) {
+          resolver.learnIncompatibility(incompatibility);
+        }
+      }
+
+      if (results[subtree]) {
+        return std::move(*results[subtree]);
+      } else {
+        std::rethrow_exception(errors[subtree]);
+      }
+    }
+  }
+
+  // Every subtree failed. Which conflict is reported depends upon what was
+  // learned along the way, so search again from the top.
+  Search search(resolver, budget, level);
+  return Searcher(search).run(DependencyGraph(), level);
+}
+
+class UnversionedRequirementVisitor final : public Requirement::Visitor
+{
+  public:
+    std::vector<Requirement::Unversioned::Metadata> _allMetadata;
+
+    void operator() (const ArbiterRequirement &requirement) override
+    {
+      if (const auto *ptr = Requirement::requirementCast<Requirement::Unversioned>(requirement)) {
+        _allMetadata.emplace_back(ptr->_metadata);
+      }
+    }
+};
+
+/**
+ * Determines whether requirements can be uniquely identified by their
+ * description, for use in an IncompatibilityArchive.
+ */
+class ArchivableRequirementVisitor final : public Requirement::Visitor
+{
+  public:
+    bool _archivable = true;
+
+    void operator() (const ArbiterRequirement &requirement) override
+    {
+      if (requirement.kind() == Requirement::Kind::Custom || requirement.kind() == Requirement::Kind::Compound) {
+        _archivable = false;
+      } else if (const auto *ptr = Requirement::requirementCast<Requirement::Unversioned>(requirement)) {
+        _archivable = _archivable && ptr->_metadata.hasDescription();
+      }
+    }
+};
+
+/**
+ * Completes `request` with the result of `create`, or rejects it with the
+ * error that `create` throws, so that every resolver waiting for the request
+ * sees the same outcome.
+ */
+template<typename T, typename Factory>
+void completeRequest (Future<T> &request, const Factory &create) noexcept(false)
+{
+  try {
+    request.fulfill(create());
+  } catch (const Exception::UserError &ex) {
+    request.reject(makeOptional(std::string(ex.what())));
+  } catch (...) {
+    // Don't leave anyone waiting forever.
+    request.reject(None());
+    throw;
+  }
+}
+
+/**
+ * Returns the description used to identify the given project in an
+ * IncompatibilityArchive, or None if it cannot be uniquely described.
+ */
+Optional<std::string> archivedDescription (const ArbiterProjectIdentifier &project)
+{
+  if (!project._value.hasDescription()) {
+    return None();
+  }
+
+  std::string description = project._value.description();
+  if (description.empty()) {
+    return None();
+  }
+
+  return makeOptional(std::move(description));
+}
+
+uint64_t fingerprintVersions (const ArbiterSelectedVersionList &versionList)
+{
+  std::vector<std::string> descriptions;
+  descriptions.reserve(versionList._versions.size());
+
+  for (const ArbiterSelectedVersion &version : versionList._versions) {
+    descriptions.emplace_back(toString(version));
+  }
+
+  // The order in which versions are returned does not matter to resolution.
+  std::sort(descriptions.begin(), descriptions.end());
+
+  std::string joined;
+  for (const std::string &description : descriptions) {
+    joined += description;
+    joined += '\n';
+  }
+
+  return IncompatibilityArchive::fingerprint(joined);
+}
+
+uint64_t fingerprintDependencies (const ArbiterDependencyList &dependencyList)
+{
+  return IncompatibilityArchive::fingerprint(toString(dependencyList));
+}
+
+} // namespace
+
+ArbiterResolver *ArbiterCreateResolver (ArbiterResolverBehaviors behaviors, const ArbiterDependencyList *dependencyList, const void *context)
+{
+  return new ArbiterResolver(std::move(behaviors), *dependencyList, context);
+}
+
+ArbiterResolver *ArbiterCreateResolverWithCache (ArbiterResolverBehaviors behaviors, const ArbiterDependencyList *dependencyList, const void *context, const ArbiterResolverCache *cache)
+{
+  return new ArbiterResolver(std::move(behaviors), *dependencyList, context, cache->_cache);
+}
+
+const void *ArbiterResolverContext (const ArbiterResolver *resolver)
+{
+  return resolver->_context;
+}
+
+ArbiterResolvedDependencyGraph *ArbiterResolverCreateResolvedDependencyGraph (ArbiterResolver *resolver, char **error)
+{
+  Optional<ArbiterResolvedDependencyGraph> dependencies;
+
+  try {
+    dependencies = resolver->resolve();
+  } catch (const std::exception &ex) {
+    if (error) {
+      *error = copyCString(ex.what()).release();
+    }
+
+    return nullptr;
+  }
+
+  return new ArbiterResolvedDependencyGraph(std::move(*dependencies));
+}
+
+size_t ArbiterResolverCreateResolvedDependencyGraphs (ArbiterResolver *resolver, const ArbiterDependencyList * const *dependencyLists, size_t count, ArbiterResolvedDependencyGraph **graphs, char **errors)
+{
+  std::vector<std::exception_ptr> failures;
+  std::vector<Optional<ArbiterResolvedDependencyGraph>> resolved = resolver->resolveAll(std::vector<const ArbiterDependencyList *>(dependencyLists, dependencyLists + count), failures);
+
+  size_t resolvedCount = 0;
+
+  for (size_t i = 0; i < count; ++i) {
+    if (errors) {
+      errors[i] = nullptr;
+    }
+
+    if (resolved[i]) {
+      graphs[i] = new ArbiterResolvedDependencyGraph(std::move(*resolved[i]));
+      ++resolvedCount;
+      continue;
+    }
+
+    graphs[i] = nullptr;
+
+    try {
+      std::rethrow_exception(failures[i]);
+    } catch (const std::exception &ex) {
+      if (errors) {
+        errors[i] = copyCString(ex.what()).release();
+      }
+    }
+  }
+
+  return resolvedCount;
+}
+
+ArbiterResolvedDependencyGraph *ArbiterResolverCreateVerifiedDependencyGraph (ArbiterResolver *resolver, const ArbiterResolvedDependencyGraph *graph, ArbiterResolverViolationList **violations, char **error)
+{
+  std::vector<ArbiterResolverViolation> found;
+  Optional<ArbiterResolvedDependencyGraph> verified;
+
+  try {
+    verified = resolver->verify(*graph, found);
+  } catch (const std::exception &ex) {
+    if (error) {
+      *error = copyCString(ex.what()).release();
+    }
+
+    return nullptr;
+  }
+
+  if (!verified) {
+    if (violations) {
+      *violations = new ArbiterResolverViolationList(std::move(found));
+    }
+
+    return nullptr;
+  }
+
+  return new ArbiterResolvedDependencyGraph(std::move(*verified));
+}
+
+size_t ArbiterResolverViolationListCount (const ArbiterResolverViolationList *violations)
+{
+  return violations->_violations.size();
+}
+
+const ArbiterResolverViolation *ArbiterResolverViolationListGet (const ArbiterResolverViolationList *violations, size_t index)
+{
+  return &violations->_violations.at(index);
+}
+
+const ArbiterResolvedDependency *ArbiterResolverViolationDependent (const ArbiterResolverViolation *violation)
+{
+  return violation->_dependent.pointer();
+}
+
+const ArbiterDependency *ArbiterResolverViolationDependency (const ArbiterResolverViolation *violation)
+{
+  return &violation->_dependency;
+}
+
+const ArbiterSelectedVersion *ArbiterResolverViolationSelectedVersion (const ArbiterResolverViolation *violation)
+{
+  return violation->_version.pointer();
+}
+
+void ArbiterResolverCompleteDependencyList (ArbiterResolverCompletion *completion, ArbiterDependencyList *dependencyList, char *error)
+{
+  std::unique_ptr<ArbiterResolverCompletion> ownedCompletion(completion);
+  std::unique_ptr<ArbiterDependencyList> ownedList(dependencyList);
+
+  Optional<std::string> message;
+  if (error) {
+    message = copyAcquireCString(error);
+  }
+
+  assert(ownedCompletion->_dependencyList);
+
+  if (ownedList) {
+    ownedCompletion->_dependencyList->fulfill(std::move(ownedList));
+  } else {
+    ownedCompletion->_dependencyList->reject(std::move(message));
+  }
+}
+
+void ArbiterResolverCompleteAvailableVersionsList (ArbiterResolverCompletion *completion, ArbiterSelectedVersionList *versionList, char *error)
+{
+  std::unique_ptr<ArbiterResolverCompletion> ownedCompletion(completion);
+  std::unique_ptr<ArbiterSelectedVersionList> ownedList(versionList);
+
+  Optional<std::string> message;
+  if (error) {
+    message = copyAcquireCString(error);
+  }
+
+  assert(ownedCompletion->_availableVersions);
+
+  if (ownedList) {
+    ownedCompletion->_availableVersions->fulfill(std::move(ownedList));
+  } else {
+    ownedCompletion->_availableVersions->reject(std::move(message));
+  }
+}
+
+bool ArbiterResolverStartResolving (ArbiterResolver *resolver, char **error)
+{
+  try {
+    resolver->startResolving();
+  } catch (const std::exception &ex) {
+    if (error) {
+      *error = copyCString(ex.what()).release();
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+int ArbiterResolverEventFileDescriptor (const ArbiterResolver *resolver)
+{
+  return resolver->eventFileDescriptor();
+}
+
+ArbiterResolvedDependencyGraph *ArbiterResolverFinishResolving (ArbiterResolver *resolver, char **error)
+{
+  Optional<ArbiterResolvedDependencyGraph> dependencies;
+
+  try {
+    dependencies = resolver->finishResolving();
+  } catch (const std::exception &ex) {
+    if (error) {
+      *error = copyCString(ex.what()).release();
+    }
+
+    return nullptr;
+  }
+
+  return new ArbiterResolvedDependencyGraph(std::move(*dependencies));
+}
+
+void ArbiterResolverSetThreadCount (ArbiterResolver *resolver, size_t threadCount)
+{
+  resolver->_threadCount = threadCount;
+}
+
+void ArbiterResolverSetFetchThreadCount (ArbiterResolver *resolver, size_t threadCount)
+{
+  resolver->_fetchThreadCount = threadCount;
+}
+
+void ArbiterResolverSetDecisionOrdering (ArbiterResolver *resolver, ArbiterResolverDecisionOrdering ordering)
+{
+  resolver->_decisionOrdering = ordering;
+}
+
+void ArbiterResolverSetTimeLimit (ArbiterResolver *resolver, double seconds)
+{
+  resolver->_timeLimit = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+void ArbiterResolverSetCandidateLimit (ArbiterResolver *resolver, size_t limit)
+{
+  resolver->_candidateLimit = limit;
+}
+
+void ArbiterResolverCancel (ArbiterResolver *resolver)
+{
+  resolver->cancel();
+}
+
+void ArbiterResolverSetProgressCallback (ArbiterResolver *resolver, void (*callback)(const ArbiterResolver *resolver, const ArbiterResolverProgress *progress), double interval)
+{
+  resolver->_progressCallback = callback;
+  resolver->_progressInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval));
+}
+
+void ArbiterResolverSetPreviousResolvedDependencyGraph (ArbiterResolver *resolver, const ArbiterResolvedDependencyGraph *graph)
+{
+  resolver->_preferredVersions.clear();
+  if (!graph) {
+    return;
+  }
+
+  for (const auto &depth : graph->_depths) {
+    for (const ArbiterResolvedDependency &dependency : depth) {
+      resolver->_preferredVersions.emplace(resolver->_projects.intern(dependency._project), dependency._version);
+    }
+  }
+}
+
+void ArbiterResolverSetPreferredVersions (ArbiterResolver *resolver, const ArbiterResolvedDependency * const *dependencies, size_t count)
+{
+  resolver->_preferredVersions.clear();
+
+  for (size_t i = 0; i < count; ++i) {
+    resolver->_preferredVersions.emplace(resolver->_projects.intern(dependencies[i]->_project), dependencies[i]->_version);
+  }
+}
+
+bool ArbiterResolverSaveIncompatibilities (const ArbiterResolver *resolver, const char *path, char **error)
+{
+  try {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file) {
+      throw Exception::PersistenceError(std::string("Could not open ") + path + " for writing");
+    }
+
+    resolver->archiveIncompatibilities().write(file);
+
+    file.flush();
+    if (!file) {
+      throw Exception::PersistenceError(std::string("Could not write to ") + path);
+    }
+  } catch (const std::exception &ex) {
+    if (error) {
+      *error = copyCString(ex.what()).release();
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+bool ArbiterResolverLoadIncompatibilities (ArbiterResolver *resolver, const char *path, char **error)
+{
+  try {
+    std::ifstream file(path);
+    if (!file) {
+      throw Exception::PersistenceError(std::string("Could not open ") + path + " for reading");
+    }
+
+    resolver->unarchiveIncompatibilities(IncompatibilityArchive::read(file));
+  } catch (const std::exception &ex) {
+    if (error) {
+      *error = copyCString(ex.what()).release();
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+bool ArbiterResolverLoadBehaviorCache (ArbiterResolver *resolver, const char *path, ArbiterUserValueDeserializer projectDeserializer, ArbiterUserValueDeserializer metadataDeserializer, char **error)
+{
+  try {
+    resolver->setBehaviorCache(std::make_unique<const BehaviorCache>(path, projectDeserializer, metadataDeserializer));
+  } catch (const std::exception &ex) {
+    if (error) {
+      *error = copyCString(ex.what()).release();
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+bool ArbiterResolverSaveBehaviorCache (const ArbiterResolver *resolver, const char *path, char **error)
+{
+  try {
+    resolver->behaviorCacheContents().write(path);
+  } catch (const std::exception &ex) {
+    if (error) {
+      *error = copyCString(ex.what()).release();
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+void ArbiterFreeResolver (ArbiterResolver *resolver)
+{
+  delete resolver;
+}
+
+ArbiterResolver::~ArbiterResolver ()
+{
+  // Nobody can collect the result any longer, so stop rather than waiting
+  // for requests which may never complete.
+  cancel();
+
+  if (_backgroundThread.joinable()) {
+    _backgroundThread.join();
+  }
+}
+
+std::shared_ptr<const ArbiterDependencyList> ArbiterResolver::fetchDependencies (ProjectID project, const ArbiterSelectedVersion &version) noexcept(false)
+{
+  std::unique_lock<std::recursive_mutex> lock(_mutex);
+
+  ProjectVersion resolved(project, version);
+  if (auto list = cachedDependencies(resolved)) {
+    return list;
+  }
+
+  if (_behaviors.requestDependencyList || _sharedCache) {
+    std::shared_ptr<Future<std::shared_ptr<const ArbiterDependencyList>>> future = requestDependencies(resolved);
+
+    // Let other threads make progress while this request is outstanding.
+    lock.unlock();
+    std::shared_ptr<const ArbiterDependencyList> dependencyList;
+
+    try {
+      dependencyList = waitFor(*future);
+    } catch (...) {
+      lock.lock();
+
+      // Failed requests are not cached, so that they can be retried.
+      if (maybeAt(_pendingDependencies, resolved) == makeOptional(future)) {
+        _pendingDependencies.erase(resolved);
+      }
+
+      if (_sharedCache) {
+        _sharedCache->forgetDependencies(_projects.lookup(project), version, future);
+      }
+
+      throw;
+    }
+
+    lock.lock();
+
+    _pendingDependencies.erase(resolved);
+    _cachedDependencies[resolved] = dependencyList;
+    return dependencyList;
+  }
+
+  std::shared_ptr<const ArbiterDependencyList> dependencyList = createDependencyList(resolved);
+  _cachedDependencies[resolved] = dependencyList;
+  return dependencyList;
+}
+
+std::vector<std::shared_ptr<const ArbiterDependencyList>> ArbiterResolver::fetchAllDependencies (const std::vector<ProjectVersion> &dependencies) noexcept(false)
+{
+  std::vector<std::shared_ptr<const ArbiterDependencyList>> dependencyLists(dependencies.size());
+
+  if (_behaviors.requestDependencyList) {
+    // Start any outstanding requests at once, rather than one at a time.
+    for (const ProjectVersion &dependency : dependencies) {
+      prefetchDependencies(dependency.first, dependency.second);
+    }
+  } else if (_fetchThreadCount > 1) {
+    std::vector<size_t> uncachedIndices;
+
+    {
+      std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+      for (size_t i = 0; i < dependencies.size(); ++i) {
+        if (auto list = cachedDependencies(dependencies[i])) {
+          dependencyLists[i] = std::move(list);
+        } else {
+          uncachedIndices.emplace_back(i);
+        }
+      }
+    }
+
+    if (uncachedIndices.size() > 1) {
+      std::vector<std::exception_ptr> errors(dependencies.size());
+
+      WorkStealingPool pool(std::min(_fetchThreadCount, uncachedIndices.size()));
+      pool.run(uncachedIndices.size(), [&](size_t task) {
+        const size_t index = uncachedIndices[task];
+
+        try {
+          dependencyLists[index] = _sharedCache ? createSharedDependencyList(dependencies[index]) : createDependencyList(dependencies[index]);
+        } catch (...) {
+          errors[index] = std::current_exception();
+        }
+      });
+
+      std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+      // Merge in order, so that the same error is reported as if the
+      // requests had been made one at a time.
+      for (size_t index : uncachedIndices) {
+        if (errors[index]) {
+          std::rethrow_exception(errors[index]);
+        }
+
+        _cachedDependencies.emplace(dependencies[index], dependencyLists[index]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < dependencies.size(); ++i) {
+    if (!dependencyLists[i]) {
+      dependencyLists[i] = fetchDependencies(dependencies[i].first, dependencies[i].second);
+    }
+  }
+
+  return dependencyLists;
+}
+
+std::shared_ptr<const ArbiterDependencyList> ArbiterResolver::createDependencyList (const ProjectVersion &resolved) noexcept(false)
+{
+  char *error = nullptr;
+  std::unique_ptr<ArbiterDependencyList> dependencyList(_behaviors.createDependencyList(this, &_projects.lookup(resolved.first), &resolved.second, &error));
+
+  if (dependencyList) {
+    assert(!error);
+    return dependencyList;
+  } else if (error) {
+    throw Exception::UserError(copyAcquireCString(error));
+  } else {
+    throw Exception::UserError();
+  }
+}
+
+std::shared_ptr<const ArbiterSelectedVersionList> ArbiterResolver::fetchAvailableVersions (ProjectID project) noexcept(false)
+{
+  std::unique_lock<std::recursive_mutex> lock(_mutex);
+
+  if (auto list = cachedAvailableVersions(project)) {
+    return list;
+  }
+
+  if (_behaviors.requestAvailableVersionsList || _sharedCache) {
+    std::shared_ptr<Future<std::shared_ptr<const ArbiterSelectedVersionList>>> future = requestAvailableVersions(project);
+
+    // Let other threads make progress while this request is outstanding.
+    lock.unlock();
+    std::shared_ptr<const ArbiterSelectedVersionList> versionList;
+
+    try {
+      versionList = waitFor(*future);
+    } catch (...) {
+      lock.lock();
+
+      // Failed requests are not cached, so that they can be retried.
+      if (maybeAt(_pendingAvailableVersions, project) == makeOptional(future)) {
+        _pendingAvailableVersions.erase(project);
+      }
+
+      if (_sharedCache) {
+        _sharedCache->forgetAvailableVersions(_projects.lookup(project), future);
+      }
+
+      throw;
+    }
+
+    lock.lock();
+
+    _pendingAvailableVersions.erase(project);
+
+    // Another thread may have cached (and activated) this list in the meantime.
+    if (auto list = maybeAt(_cachedAvailableVersions, project)) {
+      return std::move(*list);
+    }
+
+    _cachedAvailableVersions[project] = versionList;
+    activateUnarchivedIncompatibilities(project);
+
+    return versionList;
+  }
+
+  std::shared_ptr<const ArbiterSelectedVersionList> versionList = createAvailableVersionsList(project);
+  _cachedAvailableVersions[project] = versionList;
+  activateUnarchivedIncompatibilities(project);
+
+  return versionList;
+}
+
+std::shared_ptr<const ArbiterSelectedVersionList> ArbiterResolver::createAvailableVersionsList (ProjectID project) noexcept(false)
+{
+  char *error = nullptr;
+  std::unique_ptr<ArbiterSelectedVersionList> versionList(_behaviors.createAvailableVersionsList(this, &_projects.lookup(project), &error));
 
   if (versionList) {
     assert(!error);
+    return versionList;
+  } else if (error) {
+    throw Exception::UserError(copyAcquireCString(error));
+  } else {
+    throw Exception::UserError();
+  }
+}
+
+void ArbiterResolver::prefetchDependencies (ProjectID project, const ArbiterSelectedVersion &version)
+{
+  if (!_behaviors.requestDependencyList) {
+    return;
+  }
+
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+  ProjectVersion resolved(project, version);
+  if (!cachedDependencies(resolved)) {
+    requestDependencies(resolved);
+  }
+}
+
+void ArbiterResolver::prefetchAvailableVersions (ProjectID project)
+{
+  if (!_behaviors.requestAvailableVersionsList) {
+    return;
+  }
+
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+  if (!cachedAvailableVersions(project)) {
+    requestAvailableVersions(project);
+  }
+}
+
+std::shared_ptr<const ArbiterDependencyList> ArbiterResolver::cachedDependencies (const ProjectVersion &resolved)
+{
+  if (auto list = maybeAt(_cachedDependencies, resolved)) {
+    return std::move(*list);
+  }
+
+  if (!_behaviorCache) {
+    return nullptr;
+  }
+
+  std::shared_ptr<const ArbiterDependencyList> dependencyList = _behaviorCache->dependencies(_projects.lookup(resolved.first), resolved.second);
+  if (dependencyList) {
+    _cachedDependencies[resolved] = dependencyList;
+  }
+
+  return dependencyList;
+}
+
+std::shared_ptr<const ArbiterSelectedVersionList> ArbiterResolver::cachedAvailableVersions (ProjectID project)
+{
+  if (auto list = maybeAt(_cachedAvailableVersions, project)) {
+    return std::move(*list);
+  }
+
+  if (!_behaviorCache) {
+    return nullptr;
+  }
+
+  std::shared_ptr<const ArbiterSelectedVersionList> versionList = _behaviorCache->availableVersions(_projects.lookup(project));
+  if (versionList) {
+    _cachedAvailableVersions[project] = versionList;
+    activateUnarchivedIncompatibilities(project);
+  }
+
+  return versionList;
+}
+
+std::shared_ptr<Future<std::shared_ptr<const ArbiterDependencyList>>> ArbiterResolver::requestDependencies (const ProjectVersion &resolved)
+{
+  if (auto pending = maybeAt(_pendingDependencies, resolved)) {
+    return *pending;
+  }
+
+  std::shared_ptr<Future<std::shared_ptr<const ArbiterDependencyList>>> future;
+  bool created = true;
+
+  if (_sharedCache) {
+    std::tie(future, created) = _sharedCache->dependencies(_projects.lookup(resolved.first), resolved.second);
+  } else {
+    future = std::make_shared<Future<std::shared_ptr<const ArbiterDependencyList>>>();
+  }
+
+  _pendingDependencies[resolved] = future;
+
+  if (!created) {
+    // Another resolver has already made this request.
+    return future;
+  }
+
+  if (_behaviors.requestDependencyList) {
+    auto completion = std::make_unique<ArbiterResolverCompletion>();
+    completion->_dependencyList = future;
+
+    _behaviors.requestDependencyList(this, &_projects.lookup(resolved.first), &resolved.second, completion.release());
+  } else {
+    completeRequest(*future, [&] {
+      return createDependencyList(resolved);
+    });
+  }
+
+  return future;
+}
+
+std::shared_ptr<const ArbiterDependencyList> ArbiterResolver::createSharedDependencyList (const ProjectVersion &resolved) noexcept(false)
+{
+  const ArbiterProjectIdentifier &project = _projects.lookup(resolved.first);
+  const auto request = _sharedCache->dependencies(project, resolved.second);
+
+  if (request.second) {
+    completeRequest(*request.first, [&] {
+      return createDependencyList(resolved);
+    });
+  }
+
+  try {
+    return waitFor(*request.first);
+  } catch (...) {
+    _sharedCache->forgetDependencies(project, resolved.second, request.first);
+    throw;
+  }
+}
+
+std::shared_ptr<Future<std::shared_ptr<const ArbiterSelectedVersionList>>> ArbiterResolver::requestAvailableVersions (ProjectID project)
+{
+  if (auto pending = maybeAt(_pendingAvailableVersions, project)) {
+    return *pending;
+  }
+
+  std::shared_ptr<Future<std::shared_ptr<const ArbiterSelectedVersionList>>> future;
+  bool created = true;
+
+  if (_sharedCache) {
+    std::tie(future, created) = _sharedCache->availableVersions(_projects.lookup(project));
+  } else {
+    future = std::make_shared<Future<std::shared_ptr<const ArbiterSelectedVersionList>>>();
+  }
+
+  _pendingAvailableVersions[project] = future;
+
+  if (!created) {
+    // Another resolver has already made this request.
+    return future;
+  }
+
+  if (_behaviors.requestAvailableVersionsList) {
+    auto completion = std::make_unique<ArbiterResolverCompletion>();
+    completion->_availableVersions = future;
+
+    _behaviors.requestAvailableVersionsList(this, &_projects.lookup(project), completion.release());
+  } else {
+    completeRequest(*future, [&] {
+      return createAvailableVersionsList(project);
+    });
+  }
+
+  return future;
+}
+
+Optional<ArbiterSelectedVersion> ArbiterResolver::fetchSelectedVersionForMetadata (const Arbiter::SharedUserValue<ArbiterSelectedVersion> &metadata)
+{
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+  const auto behavior = _behaviors.createSelectedVersionForMetadata;
+  if (!behavior) {
+    return None();
+  }
+
+  std::unique_ptr<ArbiterSelectedVersion> version(behavior(this, metadata.data()));
+  if (version) {
+    return makeOptional(std::move(*version));
+  } else {
+    return None();
+  }
+}
+
+void ArbiterResolver::learnIncompatibility (const Incompatibility &incompatibility)
+{
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+  _incompatibilities.add(incompatibility);
+}
+
+ArbiterResolvedDependencyGraph ArbiterResolver::resolve () noexcept(false)
+{
+  return resolve(_dependencyList, _threadCount);
+}
+
+ArbiterResolvedDependencyGraph ArbiterResolver::resolve (const ArbiterDependencyList &dependencyList) noexcept(false)
+{
+  return resolve(dependencyList, _threadCount);
+}
+
+ArbiterResolvedDependencyGraph ArbiterResolver::resolve (const ArbiterDependencyList &dependencyList, size_t threadCount) noexcept(false)
+{
+  Level level;
+  for (const ArbiterDependency &dependency : dependencyList._dependencies) {
+    level[_projects.intern(dependency._projectIdentifier)].emplace_back(None(), dependency.sharedRequirement());
+  }
+
+  Budget budget(*this);
+
+  try {
+    if (threadCount > 1 && !level.empty()) {
+      return resolveInParallel(*this, budget, level, threadCount).resolvedGraph(_projects);
+    }
+
+    Search search(*this, budget, level);
+    DependencyGraph graph = Searcher(search).run(DependencyGraph(), level);
+    return graph.resolvedGraph(_projects);
+  } catch (Conflict &conflict) {
+    std::rethrow_exception(conflict._error);
+  }
+}
+
+std::vector<Optional<ArbiterResolvedDependencyGraph>> ArbiterResolver::resolveAll (const std::vector<const ArbiterDependencyList *> &dependencyLists, std::vector<std::exception_ptr> &errors)
+{
+  std::vector<Optional<ArbiterResolvedDependencyGraph>> graphs(dependencyLists.size());
+  errors.assign(dependencyLists.size(), nullptr);
+
+  // Spread the threads across the dependency lists rather than within each
+  // one, since separate searches never need to wait for each other.
+  const size_t poolSize = std::max<size_t>(1, std::min(_threadCount, dependencyLists.size()));
+  const size_t threadsPerList = (dependencyLists.size() > 1 ? 1 : _threadCount);
+
+  WorkStealingPool pool(poolSize);
+  pool.run(dependencyLists.size(), [&](size_t index) {
+    try {
+      graphs[index] = resolve(*dependencyLists[index], threadsPerList);
+    } catch (...) {
+      errors[index] = std::current_exception();
+    }
+  });
+
+  return graphs;
+}
+
+void ArbiterResolver::startResolving () noexcept(false)
+{
+  if (_notifier) {
+    throw std::logic_error("Resolution has already been started");
+  }
 
-    _cachedAvailableVersions[project] = *versionList;
-    return std::move(*versionList);
-  } else if (error) {
-    throw Exception::UserError(copyAcquireCString(error));
-  } else {
-    throw Exception::UserError();
+  _notifier = std::make_unique<EventNotifier>();
+  _backgroundThread = std::thread([this] {
+    try {
+      _backgroundResult = resolve();
+    } catch (...) {
+      _backgroundError = std::current_exception();
+    }
+
+    _notifier->signal();
+  });
+}
+
+int ArbiterResolver::eventFileDescriptor () const noexcept
+{
+  return _notifier ? _notifier->fileDescriptor() : -1;
+}
+
+ArbiterResolvedDependencyGraph ArbiterResolver::finishResolving () noexcept(false)
+{
+  if (!_notifier) {
+    throw std::logic_error("Resolution has not been started");
   }
+
+  if (_backgroundThread.joinable()) {
+    _backgroundThread.join();
+  }
+
+  if (_backgroundError) {
+    std::rethrow_exception(_backgroundError);
+  }
+
+  return *_backgroundResult;
 }
 
-Optional<ArbiterSelectedVersion> ArbiterResolver::fetchSelectedVersionForMetadata (const Arbiter::SharedUserValue<ArbiterSelectedVersion> &metadata)
+IncompatibilityArchive ArbiterResolver::archiveIncompatibilities () const
 {
-  const auto behavior = _behaviors.createSelectedVersionForMetadata;
-  if (!behavior) {
-    return None();
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+  IncompatibilityArchive archive;
+
+  const auto indexOfProject = [&](ProjectID project) -> Optional<size_t> {
+    Optional<std::string> description = archivedDescription(_projects.lookup(project));
+    if (!description) {
+      return None();
+    }
+
+    // Projects which were only mentioned in the root dependency list may not
+    // have had their versions fetched, but their fingerprint won't be checked.
+    uint64_t versionsFingerprint = 0;
+
+    const auto it = _cachedAvailableVersions.find(project);
+    if (it != _cachedAvailableVersions.end()) {
+      versionsFingerprint = fingerprintVersions(*it->second);
+    }
+
+    return makeOptional(archive.indexOfProject(*description, versionsFingerprint));
+  };
+
+  for (const Incompatibility &incompatibility : _incompatibilities.incompatibilities()) {
+    IncompatibilityArchive::Entry entry;
+    bool archivable = true;
+
+    for (const auto &pair : incompatibility._selections) {
+      const ProjectID project = pair.first;
+      const ArbiterSelectedVersion &version = pair.second;
+
+      Optional<size_t> projectIndex = indexOfProject(project);
+      if (!projectIndex || !version._metadata.hasDescription()) {
+        archivable = false;
+        break;
+      }
+
+      Optional<uint64_t> dependenciesFingerprint;
+
+      const auto it = _cachedDependencies.find(ProjectVersion(project, version));
+      if (it != _cachedDependencies.end()) {
+        dependenciesFingerprint = fingerprintDependencies(*it->second);
+      }
+
+      entry._selections.emplace_back(IncompatibilityArchive::Selection{*projectIndex, toString(version), dependenciesFingerprint});
+    }
+
+    for (const auto &pair : incompatibility._rootRequirements) {
+      if (!archivable) {
+        break;
+      }
+
+      Optional<size_t> projectIndex = indexOfProject(pair.first);
+      if (!projectIndex) {
+        archivable = false;
+        break;
+      }
+
+      for (const auto &requirement : pair.second) {
+        ArchivableRequirementVisitor visitor;
+        requirement->visit(visitor);
+
+        if (!visitor._archivable) {
+          archivable = false;
+          break;
+        }
+
+        entry._rootRequirements.emplace_back(IncompatibilityArchive::RootRequirement{*projectIndex, toString(*requirement)});
+      }
+    }
+
+    for (ProjectID project : incompatibility._versionLists) {
+      if (!archivable) {
+        break;
+      }
+
+      Optional<size_t> projectIndex = indexOfProject(project);
+      if (!projectIndex) {
+        archivable = false;
+        break;
+      }
+
+      entry._versionLists.emplace_back(*projectIndex);
+    }
+
+    if (archivable) {
+      archive._entries.emplace_back(std::move(entry));
+    }
   }
 
-  std::unique_ptr<ArbiterSelectedVersion> version(behavior(this, metadata.data()));
-  if (version) {
-    return makeOptional(std::move(*version));
+  // Preserve anything that was unarchived but never verified, since it may
+  // still be useful to a later resolver.
+  for (size_t i = 0; i < _unarchived._entries.size(); ++i) {
+    if (_unarchivedStates[i] != ArchivedState::Pending && _unarchivedStates[i] != ArchivedState::Inapplicable) {
+      continue;
+    }
+
+    const auto remap = [&](size_t index) {
+      const IncompatibilityArchive::Project &project = _unarchived._projects[index];
+      return archive.indexOfProject(project._description, project._versionsFingerprint);
+    };
+
+    IncompatibilityArchive::Entry entry = _unarchived._entries[i];
+
+    for (auto &selection : entry._selections) {
+      selection._projectIndex = remap(selection._projectIndex);
+    }
+
+    for (auto &root : entry._rootRequirements) {
+      root._projectIndex = remap(root._projectIndex);
+    }
+
+    for (size_t &projectIndex : entry._versionLists) {
+      projectIndex = remap(projectIndex);
+    }
+
+    archive._entries.emplace_back(std::move(entry));
+  }
+
+  return archive;
+}
+
+void ArbiterResolver::unarchiveIncompatibilities (const IncompatibilityArchive &archive) noexcept(false)
+{
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+  // Root requirements only hold if they also appear in this resolver's
+  // dependency list.
+  std::unordered_set<std::string> rootRequirements;
+  for (const ArbiterDependency &dependency : _dependencyList._dependencies) {
+    if (Optional<std::string> description = archivedDescription(dependency._projectIdentifier)) {
+      rootRequirements.insert(*description + '\n' + toString(dependency.requirement()));
+    }
+  }
+
+  for (const IncompatibilityArchive::Entry &archivedEntry : archive._entries) {
+    const auto remap = [&](size_t index) {
+      const IncompatibilityArchive::Project &project = archive._projects.at(index);
+      return _unarchived.indexOfProject(project._description, project._versionsFingerprint);
+    };
+
+    IncompatibilityArchive::Entry entry = archivedEntry;
+    ArchivedState state = (entry._selections.empty() ? ArchivedState::Inapplicable : ArchivedState::Pending);
+
+    for (auto &selection : entry._selections) {
+      selection._projectIndex = remap(selection._projectIndex);
+    }
+
+    for (auto &root : entry._rootRequirements) {
+      const std::string &description = archive._projects.at(root._projectIndex)._description;
+      if (rootRequirements.find(description + '\n' + root._requirement) == rootRequirements.end()) {
+        state = ArchivedState::Inapplicable;
+      }
+
+      root._projectIndex = remap(root._projectIndex);
+    }
+
+    for (size_t &projectIndex : entry._versionLists) {
+      projectIndex = remap(projectIndex);
+    }
+
+    const size_t index = _unarchived._entries.size();
+
+    if (state == ArchivedState::Pending) {
+      for (const auto &selection : entry._selections) {
+        _unarchivedEntriesByProject[_unarchived._projects[selection._projectIndex]._description].emplace_back(index);
+      }
+    }
+
+    _unarchived._entries.emplace_back(std::move(entry));
+    _unarchivedStates.emplace_back(state);
+  }
+
+  // Projects which have already been fetched won't be activated again
+  // otherwise.
+  std::vector<ProjectID> fetchedProjects;
+  for (const auto &pair : _cachedAvailableVersions) {
+    fetchedProjects.emplace_back(pair.first);
+  }
+
+  for (ProjectID project : fetchedProjects) {
+    activateUnarchivedIncompatibilities(project);
+  }
+}
+
+size_t ArbiterResolver::staleIncompatibilityCount () const noexcept
+{
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+  return std::count(_unarchivedStates.begin(), _unarchivedStates.end(), ArchivedState::Stale);
+}
+
+void ArbiterResolver::setBehaviorCache (std::unique_ptr<const BehaviorCache> cache)
+{
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+  _behaviorCache = std::move(cache);
+}
+
+BehaviorCache::Builder ArbiterResolver::behaviorCacheContents () const
+{
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+  BehaviorCache::Builder builder;
+
+  for (const auto &pair : _cachedAvailableVersions) {
+    builder.addAvailableVersions(_projects.lookup(pair.first), *pair.second);
+  }
+
+  for (const auto &pair : _cachedDependencies) {
+    builder.addDependencies(_projects.lookup(pair.first.first), pair.first.second, *pair.second);
+  }
+
+  // Keep results for projects this resolution didn't need.
+  if (_behaviorCache) {
+    builder.addRecords(*_behaviorCache);
+  }
+
+  return builder;
+}
+
+void ArbiterResolver::activateUnarchivedIncompatibilities (ProjectID project)
+{
+  if (_unarchivedEntriesByProject.empty()) {
+    return;
+  }
+
+  Optional<std::string> description = archivedDescription(_projects.lookup(project));
+  if (!description) {
+    return;
+  }
+
+  const auto it = _unarchivedEntriesByProject.find(*description);
+  if (it == _unarchivedEntriesByProject.end()) {
+    return;
+  }
+
+  _projectsByDescription.emplace(*description, project);
+
+  for (size_t index : it->second) {
+    if (_unarchivedStates[index] == ArchivedState::Pending) {
+      // Verification may fetch more data, which could otherwise reenter here.
+      _unarchivedStates[index] = ArchivedState::Verifying;
+      _unarchivedStates[index] = activateUnarchivedIncompatibility(index);
+    }
+  }
+}
+
+ArbiterResolver::ArchivedState ArbiterResolver::activateUnarchivedIncompatibility (size_t index)
+{
+  const IncompatibilityArchive::Entry &entry = _unarchived._entries[index];
+
+  // Every selected project must have been encountered before this can be
+  // verified.
+  for (const auto &selection : entry._selections) {
+    if (_projectsByDescription.find(_unarchived._projects[selection._projectIndex]._description) == _projectsByDescription.end()) {
+      return ArchivedState::Pending;
+    }
+  }
+
+  // Projects mentioned by the dependency lists of the selections, in case
+  // their version lists need to be verified as well.
+  std::unordered_map<std::string, ProjectID> mentionedProjects;
+
+  for (const ArbiterDependency &dependency : _dependencyList._dependencies) {
+    if (Optional<std::string> description = archivedDescription(dependency._projectIdentifier)) {
+      mentionedProjects.emplace(std::move(*description), _projects.intern(dependency._projectIdentifier));
+    }
+  }
+
+  Incompatibility incompatibility;
+
+  try {
+    for (const auto &selection : entry._selections) {
+      const IncompatibilityArchive::Project &archivedProject = _unarchived._projects[selection._projectIndex];
+      const ProjectID project = _projectsByDescription.at(archivedProject._description);
+      const ArbiterSelectedVersionList &versionList = *_cachedAvailableVersions.at(project);
+
+      if (fingerprintVersions(versionList) != archivedProject._versionsFingerprint) {
+        return ArchivedState::Stale;
+      }
+
+      const auto versionIt = std::find_if(versionList._versions.begin(), versionList._versions.end(), [&selection](const ArbiterSelectedVersion &version) {
+        return toString(version) == selection._version;
+      });
+
+      if (versionIt == versionList._versions.end()) {
+        return ArchivedState::Stale;
+      }
+
+      if (selection._dependenciesFingerprint) {
+        std::shared_ptr<const ArbiterDependencyList> dependencyList = fetchDependencies(project, *versionIt);
+        if (fingerprintDependencies(*dependencyList) != *selection._dependenciesFingerprint) {
+          return ArchivedState::Stale;
+        }
+
+        for (const ArbiterDependency &dependency : dependencyList->_dependencies) {
+          if (Optional<std::string> description = archivedDescription(dependency._projectIdentifier)) {
+            mentionedProjects.emplace(std::move(*description), _projects.intern(dependency._projectIdentifier));
+          }
+        }
+      }
+
+      incompatibility.addSelection(project, *versionIt);
+    }
+
+    for (size_t projectIndex : entry._versionLists) {
+      const IncompatibilityArchive::Project &archivedProject = _unarchived._projects[projectIndex];
+
+      Optional<ProjectID> project = maybeAt(_projectsByDescription, archivedProject._description);
+      if (!project) {
+        project = maybeAt(mentionedProjects, archivedProject._description);
+      }
+
+      if (!project) {
+        return ArchivedState::Stale;
+      }
+
+      if (fingerprintVersions(*fetchAvailableVersions(*project)) != archivedProject._versionsFingerprint) {
+        return ArchivedState::Stale;
+      }
+
+      incompatibility.addVersionList(*project);
+    }
+  } catch (const Exception::UserError &) {
+    return ArchivedState::Stale;
+  }
+
+  for (const auto &root : entry._rootRequirements) {
+    const std::string &description = _unarchived._projects[root._projectIndex]._description;
+
+    for (const ArbiterDependency &dependency : _dependencyList._dependencies) {
+      if (archivedDescription(dependency._projectIdentifier) == makeOptional(description) && toString(dependency.requirement()) == root._requirement) {
+        incompatibility.addRootRequirement(_projects.intern(dependency._projectIdentifier), dependency.requirement());
+        break;
+      }
+    }
+  }
+
+  _incompatibilities.add(std::move(incompatibility));
+  return ArchivedState::Activated;
+}
+
+std::unique_ptr<Arbiter::Base> ArbiterResolverViolation::clone () const
+{
+  return std::make_unique<ArbiterResolverViolation>(*this);
+}
+
+std::ostream &ArbiterResolverViolation::describe (std::ostream &os) const
+{
+  if (_dependent) {
+    os << *_dependent;
   } else {
-    return None();
+    os << "Root";
+  }
+
+  os << " requires " << _dependency << ", but ";
+
+  if (_version) {
+    return os << "found " << *_version;
+  } else {
+    return os << "it is missing";
   }
 }
 
-ArbiterResolvedDependencyGraph ArbiterResolver::resolve () noexcept(false)
+bool ArbiterResolverViolation::operator== (const Arbiter::Base &other) const
+{
+  auto ptr = dynamic_cast<const ArbiterResolverViolation *>(&other);
+  if (!ptr) {
+    return false;
+  }
+
+  return _dependent == ptr->_dependent && _dependency == ptr->_dependency && _version == ptr->_version;
+}
+
+std::unique_ptr<Arbiter::Base> ArbiterResolverViolationList::clone () const
+{
+  return std::make_unique<ArbiterResolverViolationList>(*this);
+}
+
+std::ostream &ArbiterResolverViolationList::describe (std::ostream &os) const
 {
-  std::set<ArbiterDependency> dependencySet(_dependencyList._dependencies.begin(), _dependencyList._dependencies.end());
+  os << "Violations:";
 
-  DependencyGraph graph = resolveDependencies(*this, DependencyGraph(), std::move(dependencySet), std::unordered_map<ArbiterProjectIdentifier, ArbiterProjectIdentifier>());
-  return graph.resolvedGraph();
+  for (const ArbiterResolverViolation &violation : _violations) {
+    os << "\n\t" << violation;
+  }
+
+  return os;
+}
+
+bool ArbiterResolverViolationList::operator== (const Arbiter::Base &other) const
+{
+  auto ptr = dynamic_cast<const ArbiterResolverViolationList *>(&other);
+  if (!ptr) {
+    return false;
+  }
+
+  return _violations == ptr->_violations;
 }
 
 std::unique_ptr<Arbiter::Base> ArbiterResolver::clone () const
 {
-  return std::make_unique<ArbiterResolver>(_behaviors, _dependencyList, _context);
+  return std::make_unique<ArbiterResolver>(_behaviors, _dependencyList, _context, _sharedCache);
 }
 
 std::ostream &ArbiterResolver::describe (std::ostream &os) const
@@ -430,7 +2765,126 @@ bool ArbiterResolver::operator== (const Arbiter::Base &other) const
   return this == &other;
 }
 
-std::vector<ArbiterSelectedVersion> ArbiterResolver::availableVersionsSatisfying (const ArbiterProjectIdentifier &project, const ArbiterRequirement &requirement) noexcept(false)
+Optional<ArbiterResolvedDependencyGraph> ArbiterResolver::verify (const ArbiterResolvedDependencyGraph &proposed, std::vector<ArbiterResolverViolation> &violations) noexcept(false)
+{
+  std::unordered_map<ProjectID, const ArbiterSelectedVersion *> proposedVersions;
+  for (const auto &depth : proposed._depths) {
+    for (const ArbiterResolvedDependency &dependency : depth) {
+      proposedVersions.emplace(_projects.intern(dependency._project), &dependency._version);
+    }
+  }
+
+  DependencyGraph graph;
+  const size_t initialViolationCount = violations.size();
+
+  // Projects which have been added to the graph, but whose dependencies have
+  // not been checked yet.
+  std::vector<ProjectVersion> unchecked;
+
+  const auto check = [&](const Optional<ProjectVersion> &dependent, const ArbiterDependency &dependency) {
+    const auto violate = [&](Optional<ArbiterSelectedVersion> version) {
+      Optional<ArbiterResolvedDependency> resolvedDependent;
+      if (dependent) {
+        resolvedDependent = ArbiterResolvedDependency(_projects.lookup(dependent->first), dependent->second);
+      }
+
+      violations.emplace_back(std::move(resolvedDependent), dependency, std::move(version));
+    };
+
+    const ProjectID project = _projects.intern(dependency._projectIdentifier);
+
+    const auto it = proposedVersions.find(project);
+    if (it == proposedVersions.end()) {
+      violate(None());
+      return;
+    }
+
+    const ArbiterSelectedVersion &version = *it->second;
+    if (!dependency.requirement().satisfiedBy(version)) {
+      violate(makeOptional(version));
+      return;
+    }
+
+    const bool added = !graph.selectedVersion(project);
+
+    try {
+      Optional<ProjectID> dependentProject;
+      if (dependent) {
+        dependentProject = dependent->first;
+      }
+
+      graph.addNode(_intersections, project, version, dependency.sharedRequirement(), dependentProject);
+    } catch (const Conflict &) {
+      // The requirement is satisfied on its own, but cannot be combined with
+      // the others upon the same project.
+      violate(makeOptional(version));
+      return;
+    }
+
+    if (added) {
+      unchecked.emplace_back(project, version);
+    }
+  };
+
+  for (const ArbiterDependency &dependency : _dependencyList._dependencies) {
+    check(None(), dependency);
+  }
+
+  // Check a level of the graph at a time, so that the dependency lists for
+  // each level can be fetched together.
+  while (!unchecked.empty()) {
+    const std::vector<ProjectVersion> level = std::move(unchecked);
+    unchecked.clear();
+
+    const std::vector<std::shared_ptr<const ArbiterDependencyList>> dependencyLists = fetchAllDependencies(level);
+
+    for (size_t i = 0; i < level.size(); ++i) {
+      const Optional<ProjectVersion> dependent(level[i]);
+
+      for (const ArbiterDependency &dependency : dependencyLists[i]->_dependencies) {
+        check(dependent, dependency);
+      }
+    }
+  }
+
+  if (violations.size() > initialViolationCount) {
+    return None();
+  } else {
+    return makeOptional(graph.resolvedGraph(_projects));
+  }
+}
+
+const ArbiterSelectedVersion *ArbiterResolver::preferredVersion (ProjectID project) const
+{
+  const auto it = _preferredVersions.find(project);
+  if (it == _preferredVersions.end()) {
+    return nullptr;
+  } else {
+    return &it->second;
+  }
+}
+
+std::shared_ptr<const Resolver::VersionTable> ArbiterResolver::fetchVersionTable (ProjectID project) noexcept(false)
+{
+  {
+    std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+    if (auto table = maybeAt(_versionTables, project)) {
+      return std::move(*table);
+    }
+  }
+
+  // Fetching may wait for a pending request, which must not happen with the
+  // (recursive) mutex held, or other threads would be stalled meanwhile.
+  auto table = std::make_shared<const Resolver::VersionTable>(fetchAvailableVersions(project)->_versions);
+
+  std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+  // Another thread may have built the same table in the meantime.
+  return _versionTables.emplace(project, std::move(table)).first->second;
+}
+
+std::vector<ArbiterSelectedVersion> ArbiterResolver::versionsForMetadata (const ArbiterRequirement &requirement) noexcept(false)
 {
   std::vector<ArbiterSelectedVersion> versions;
 
@@ -440,19 +2894,11 @@ std::vector<ArbiterSelectedVersion> ArbiterResolver::availableVersionsSatisfying
 
     for (const auto &metadata : visitor._allMetadata) {
       Optional<ArbiterSelectedVersion> version = fetchSelectedVersionForMetadata(metadata);
-      if (version) {
+      if (version && requirement.satisfiedBy(*version)) {
         versions.emplace_back(std::move(*version));
       }
     }
   }
 
-  std::vector<ArbiterSelectedVersion> fetchedVersions = fetchAvailableVersions(project)._versions;
-  versions.insert(versions.end(), std::make_move_iterator(fetchedVersions.begin()), std::make_move_iterator(fetchedVersions.end()));
-
-  auto removeStart = std::remove_if(versions.begin(), versions.end(), [&requirement](const ArbiterSelectedVersion &version) {
-    return !requirement.satisfiedBy(version);
-  });
-
-  versions.erase(removeStart, versions.end());
   return versions;
 }
@@ -6,43 +6,211 @@
 
 #include <arbiter/Resolver.h>
 
+#include "BehaviorCache.h"
 #include "Dependency.h"
+#include "EventNotifier.h"
+#include "Future.h"
+#include "Incompatibility.h"
+#include "IntersectionCache.h"
+#include "ProjectTable.h"
+#include "ResolverCache.h"
 #include "Types.h"
 #include "Version.h"
+#include "VersionTable.h"
 
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+/**
+ * An asynchronous request made to the resolver behaviors, which will be
+ * completed with one of the two kinds of result.
+ */
+struct ArbiterResolverCompletion final
+{
+  public:
+    std::shared_ptr<Arbiter::Future<std::shared_ptr<const ArbiterDependencyList>>> _dependencyList;
+    std::shared_ptr<Arbiter::Future<std::shared_ptr<const ArbiterSelectedVersionList>>> _availableVersions;
+};
+
+struct ArbiterResolverViolation final : public Arbiter::Base
+{
+  public:
+    /**
+     * The choice which introduced the violated requirement, or None if it
+     * came from the root dependency list.
+     */
+    Arbiter::Optional<ArbiterResolvedDependency> _dependent;
+
+    ArbiterDependency _dependency;
+
+    /**
+     * The version proposed for the required project, or None if the project
+     * was missing.
+     */
+    Arbiter::Optional<ArbiterSelectedVersion> _version;
+
+    ArbiterResolverViolation (Arbiter::Optional<ArbiterResolvedDependency> dependent, ArbiterDependency dependency, Arbiter::Optional<ArbiterSelectedVersion> version)
+      : _dependent(std::move(dependent))
+      , _dependency(std::move(dependency))
+      , _version(std::move(version))
+    {}
+
+    std::unique_ptr<Arbiter::Base> clone () const override;
+    std::ostream &describe (std::ostream &os) const override;
+    bool operator== (const Arbiter::Base &other) const override;
+};
+
+struct ArbiterResolverViolationList final : public Arbiter::Base
+{
+  public:
+    std::vector<ArbiterResolverViolation> _violations;
+
+    explicit ArbiterResolverViolationList (std::vector<ArbiterResolverViolation> violations)
+      : _violations(std::move(violations))
+    {}
+
+    std::unique_ptr<Arbiter::Base> clone () const override;
+    std::ostream &describe (std::ostream &os) const override;
+    bool operator== (const Arbiter::Base &other) const override;
+};
+
 struct ArbiterResolver final : public Arbiter::Base
 {
   public:
     const void *_context;
 
-    ArbiterResolver (ArbiterResolverBehaviors behaviors, ArbiterDependencyList dependencyList, const void *context)
+    /**
+     * Incompatibilities learned while resolving dependencies, which are used to
+     * avoid retrying combinations of versions that are known to fail.
+     */
+    Arbiter::Resolver::IncompatibilityStore _incompatibilities;
+
+    /**
+     * Every project encountered so far, so that they can be referred to by ID
+     * internally.
+     */
+    Arbiter::Resolver::ProjectTable _projects;
+
+    /**
+     * The intersections of requirements computed during resolution, which
+     * recur across many candidate graphs.
+     */
+    Arbiter::Resolver::IntersectionCache _intersections;
+
+    /**
+     * The number of threads to explore the search space with. A value of zero
+     * or one resolves sequentially on the calling thread.
+     */
+    size_t _threadCount = 1;
+
+    /**
+     * The maximum number of synchronous dependency list requests to make
+     * concurrently, when fetching the dependencies of a whole level at once.
+     */
+    size_t _fetchThreadCount = 1;
+
+    /**
+     * Versions from a previous resolution, which are chosen in preference to
+     * any others as long as they satisfy every requirement upon them.
+     */
+    std::unordered_map<Arbiter::Resolver::ProjectID, ArbiterSelectedVersion> _preferredVersions;
+
+    /**
+     * The order in which to decide upon the projects at each level.
+     */
+    ArbiterResolverDecisionOrdering _decisionOrdering = ArbiterResolverDecisionOrderingMostConstrainedFirst;
+
+    /**
+     * The maximum wall-clock time to spend on each resolution, or zero for no
+     * limit.
+     */
+    std::chrono::steady_clock::duration _timeLimit = std::chrono::steady_clock::duration::zero();
+
+    /**
+     * The maximum number of candidate versions to try in each resolution, or
+     * zero for no limit.
+     */
+    size_t _candidateLimit = 0;
+
+    /**
+     * A callback to report progress to, at most once per `_progressInterval`.
+     */
+    void (*_progressCallback)(const ArbiterResolver *, const ArbiterResolverProgress *) = nullptr;
+    std::chrono::steady_clock::duration _progressInterval = std::chrono::steady_clock::duration::zero();
+
+    /**
+     * Serializes calls to `_progressCallback`, which may be made by several
+     * resolutions at once.
+     */
+    mutable std::mutex _progressMutex;
+
+    ArbiterResolver (ArbiterResolverBehaviors behaviors, ArbiterDependencyList dependencyList, const void *context, std::shared_ptr<Arbiter::Resolver::SharedCache> sharedCache = nullptr)
       : _context(context)
       , _behaviors(std::move(behaviors))
       , _dependencyList(std::move(dependencyList))
+      , _sharedCache(std::move(sharedCache))
     {
-      assert(_behaviors.createDependencyList);
-      assert(_behaviors.createAvailableVersionsList);
+      assert(_behaviors.createDependencyList || _behaviors.requestDependencyList);
+      assert(_behaviors.createAvailableVersionsList || _behaviors.requestAvailableVersionsList);
     }
 
     ArbiterResolver (const ArbiterResolver &) = delete;
     ArbiterResolver &operator= (const ArbiterResolver &) = delete;
 
+    /**
+     * Waits for any resolution started with startResolving() to finish.
+     */
+    ~ArbiterResolver () override;
+
     /**
      * Fetches the list of dependencies for the given project and version.
      *
-     * Returns the dependency list or throws an exception.
+     * Returns the dependency list or throws an exception. Lists are shared
+     * with the cache, so fetching one which was already cached does not copy
+     * it.
+     */
+    std::shared_ptr<const ArbiterDependencyList> fetchDependencies (Arbiter::Resolver::ProjectID project, const ArbiterSelectedVersion &version) noexcept(false);
+
+    /**
+     * Fetches the lists of dependencies for all of the given projects and
+     * versions, making requests concurrently where possible.
+     *
+     * Returns the dependency lists in the same order as the input, or throws
+     * the exception that the earliest failing request would have.
      */
-    ArbiterDependencyList fetchDependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version) noexcept(false);
+    std::vector<std::shared_ptr<const ArbiterDependencyList>> fetchAllDependencies (const std::vector<Arbiter::Resolver::ProjectVersion> &dependencies) noexcept(false);
 
     /**
      * Fetches the list of available versions for the given project.
      *
-     * Returns the version list or throws an exception.
+     * Returns the version list or throws an exception. Like dependency lists,
+     * version lists are shared with the cache.
+     */
+    std::shared_ptr<const ArbiterSelectedVersionList> fetchAvailableVersions (Arbiter::Resolver::ProjectID project) noexcept(false);
+
+    /**
+     * If the behaviors support asynchronous requests, begins fetching the list
+     * of dependencies for the given project and version, so that a later call
+     * to fetchDependencies() is less likely to block. Otherwise, does nothing.
+     */
+    void prefetchDependencies (Arbiter::Resolver::ProjectID project, const ArbiterSelectedVersion &version);
+
+    /**
+     * If the behaviors support asynchronous requests, begins fetching the list
+     * of available versions for the given project, so that a later call to
+     * fetchAvailableVersions() is less likely to block. Otherwise, does
+     * nothing.
      */
-    ArbiterSelectedVersionList fetchAvailableVersions (const ArbiterProjectIdentifier &project) noexcept(false);
+    void prefetchAvailableVersions (Arbiter::Resolver::ProjectID project);
 
     /**
      * Fetches a selected version for the given metadata string.
@@ -52,24 +220,326 @@ struct ArbiterResolver final : public Arbiter::Base
     Arbiter::Optional<ArbiterSelectedVersion> fetchSelectedVersionForMetadata (const Arbiter::SharedUserValue<ArbiterSelectedVersion> &metadata);
 
     /**
-     * Computes a list of available versions for the specified project which
-     * satisfy the given requirement.
+     * Returns the version of the given project which was chosen by a previous
+     * resolution, or nullptr if there is none.
+     */
+    const ArbiterSelectedVersion *preferredVersion (Arbiter::Resolver::ProjectID project) const;
+
+    /**
+     * Returns the available versions of the given project, sorted by
+     * precedence.
+     */
+    std::shared_ptr<const Arbiter::Resolver::VersionTable> fetchVersionTable (Arbiter::Resolver::ProjectID project) noexcept(false);
+
+    /**
+     * Fetches the versions named by any unversioned requirements within
+     * `requirement`, and returns those which satisfy it.
+     */
+    std::vector<ArbiterSelectedVersion> versionsForMetadata (const ArbiterRequirement &requirement) noexcept(false);
+
+    /**
+     * Records an incompatibility learned during resolution.
+     *
+     * This method is safe to call from multiple threads.
+     */
+    void learnIncompatibility (const Arbiter::Resolver::Incompatibility &incompatibility);
+
+    /**
+     * Looks for a learned incompatibility which involves the choice of
+     * `version` for `project`, and whose other selections are all satisfied
+     * according to `lookup`, and whose root requirements are all present
+     * according to `hasRootRequirement`. See
+     * IncompatibilityStore::findSatisfied().
+     *
+     * This method is safe to call from multiple threads.
+     */
+    template<typename Lookup, typename RootLookup>
+    Arbiter::Optional<Arbiter::Resolver::Incompatibility> findKnownIncompatibility (Arbiter::Resolver::ProjectID project, const ArbiterSelectedVersion &version, const Lookup &lookup, const RootLookup &hasRootRequirement) const
+    {
+      std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+      if (const Arbiter::Resolver::Incompatibility *incompatibility = _incompatibilities.findSatisfied(project, version, lookup, hasRootRequirement)) {
+        return Arbiter::makeOptional(*incompatibility);
+      } else {
+        return Arbiter::None();
+      }
+    }
+
+    /**
+     * Cancels any ongoing and future resolution.
+     *
+     * This method is safe to call from multiple threads.
+     */
+    void cancel () noexcept
+    {
+      _cancelled = true;
+
+      std::lock_guard<std::mutex> guard(_waitsMutex);
+      for (const auto &interrupt : _waits) {
+        interrupt();
+      }
+    }
+
+    /**
+     * Returns whether cancel() has been called.
+     *
+     * This method is safe to call from multiple threads.
      */
-    std::vector<ArbiterSelectedVersion> availableVersionsSatisfying (const ArbiterProjectIdentifier &project, const ArbiterRequirement &requirement) noexcept(false);
+    bool cancelled () const noexcept
+    {
+      return _cancelled;
+    }
 
     /**
      * Attempts to resolve all dependencies.
      */
     ArbiterResolvedDependencyGraph resolve () noexcept(false);
 
+    /**
+     * Attempts to resolve the dependencies of `dependencyList` in place of
+     * this resolver's own dependency list.
+     */
+    ArbiterResolvedDependencyGraph resolve (const ArbiterDependencyList &dependencyList) noexcept(false);
+
+    /**
+     * Attempts to resolve the dependencies of each of `dependencyLists`, in
+     * place of this resolver's own dependency list, sharing fetched lists,
+     * requirement intersections, and learned incompatibilities between them.
+     *
+     * If the thread count is greater than one, several dependency lists are
+     * resolved at once, each on a single thread.
+     *
+     * Returns a graph for each dependency list which was resolved, in the same
+     * order, or else None after storing the error at the same index of
+     * `errors`.
+     */
+    std::vector<Arbiter::Optional<ArbiterResolvedDependencyGraph>> resolveAll (const std::vector<const ArbiterDependencyList *> &dependencyLists, std::vector<std::exception_ptr> &errors);
+
+    /**
+     * Checks that `proposed` satisfies the root dependency list and the
+     * dependencies of every version reachable from it, without searching for
+     * alternatives.
+     *
+     * Returns the graph of reachable dependencies, or else None after adding
+     * every violated requirement to `violations`.
+     */
+    Arbiter::Optional<ArbiterResolvedDependencyGraph> verify (const ArbiterResolvedDependencyGraph &proposed, std::vector<ArbiterResolverViolation> &violations) noexcept(false);
+
+    /**
+     * Begins resolving all dependencies on a background thread.
+     *
+     * Throws std::logic_error if resolution was already started.
+     */
+    void startResolving () noexcept(false);
+
+    /**
+     * Returns a file descriptor which becomes readable once resolution started
+     * with startResolving() has finished, or -1 if it has not been started.
+     */
+    int eventFileDescriptor () const noexcept;
+
+    /**
+     * Waits for resolution started with startResolving() to finish, and
+     * returns its result or rethrows its error.
+     *
+     * Throws std::logic_error if resolution was not started.
+     */
+    ArbiterResolvedDependencyGraph finishResolving () noexcept(false);
+
+    /**
+     * Archives every incompatibility learned so far which can be identified by
+     * description, along with any unarchived ones which have not been used
+     * yet.
+     */
+    Arbiter::Resolver::IncompatibilityArchive archiveIncompatibilities () const;
+
+    /**
+     * Adds previously archived incompatibilities to this resolver.
+     *
+     * Each incompatibility only takes effect after verifying that the versions
+     * and dependencies it was derived from are still the same. Any which are
+     * found to be stale are discarded.
+     */
+    void unarchiveIncompatibilities (const Arbiter::Resolver::IncompatibilityArchive &archive) noexcept(false);
+
+    /**
+     * Returns the number of unarchived incompatibilities which were discarded
+     * because the data they were derived from has changed.
+     */
+    size_t staleIncompatibilityCount () const noexcept;
+
+    /**
+     * Consults `cache` for version and dependency lists before requesting
+     * them from the behaviors, replacing any cache set previously.
+     */
+    void setBehaviorCache (std::unique_ptr<const Arbiter::Resolver::BehaviorCache> cache);
+
+    /**
+     * Collects every version and dependency list fetched so far which can be
+     * serialized, along with the intact records of any behavior cache which
+     * were not fetched again.
+     */
+    Arbiter::Resolver::BehaviorCache::Builder behaviorCacheContents () const;
+
     std::unique_ptr<Arbiter::Base> clone () const override;
     std::ostream &describe (std::ostream &os) const override;
     bool operator== (const Arbiter::Base &other) const override;
 
   private:
+    /**
+     * The verification state of an unarchived incompatibility.
+     */
+    enum class ArchivedState
+    {
+      Pending,
+      Verifying,
+      Inapplicable,
+      Activated,
+      Stale,
+    };
+
     const ArbiterResolverBehaviors _behaviors;
     const ArbiterDependencyList _dependencyList;
 
-    std::unordered_map<ArbiterResolvedDependency, ArbiterDependencyList> _cachedDependencies;
-    std::unordered_map<ArbiterProjectIdentifier, ArbiterSelectedVersionList> _cachedAvailableVersions;
+    /**
+     * The cache shared with other resolvers, if any. Requests made through it
+     * are also recorded in the pending requests below.
+     */
+    const std::shared_ptr<Arbiter::Resolver::SharedCache> _sharedCache;
+
+    std::atomic<bool> _cancelled{false};
+
+    /**
+     * Wakes each thread waiting upon an outstanding request, so that cancel()
+     * can interrupt it. Kept apart from `_mutex`, which is not held while
+     * waiting.
+     */
+    std::mutex _waitsMutex;
+    std::list<std::function<void()>> _waits;
+
+    /**
+     * Guards the caches and learned incompatibilities below, and serializes
+     * calls to the behaviors, when resolving with multiple threads.
+     */
+    mutable std::recursive_mutex _mutex;
+
+    std::unordered_map<Arbiter::Resolver::ProjectVersion, std::shared_ptr<const ArbiterDependencyList>, Arbiter::Resolver::ProjectVersionHash> _cachedDependencies;
+    std::unordered_map<Arbiter::Resolver::ProjectID, std::shared_ptr<const ArbiterSelectedVersionList>> _cachedAvailableVersions;
+    std::unordered_map<Arbiter::Resolver::ProjectID, std::shared_ptr<const Arbiter::Resolver::VersionTable>> _versionTables;
+    std::unique_ptr<const Arbiter::Resolver::BehaviorCache> _behaviorCache;
+
+    std::unordered_map<Arbiter::Resolver::ProjectVersion, std::shared_ptr<Arbiter::Future<std::shared_ptr<const ArbiterDependencyList>>>, Arbiter::Resolver::ProjectVersionHash> _pendingDependencies;
+    std::unordered_map<Arbiter::Resolver::ProjectID, std::shared_ptr<Arbiter::Future<std::shared_ptr<const ArbiterSelectedVersionList>>>> _pendingAvailableVersions;
+
+    std::unique_ptr<Arbiter::EventNotifier> _notifier;
+    std::thread _backgroundThread;
+    Arbiter::Optional<ArbiterResolvedDependencyGraph> _backgroundResult;
+    std::exception_ptr _backgroundError;
+
+    Arbiter::Resolver::IncompatibilityArchive _unarchived;
+    std::vector<ArchivedState> _unarchivedStates;
+    std::unordered_map<std::string, std::vector<size_t>> _unarchivedEntriesByProject;
+    std::unordered_map<std::string, Arbiter::Resolver::ProjectID> _projectsByDescription;
+
+    /**
+     * Returns the dependency list for the given project and version if it has
+     * already been fetched or is in the behavior cache, or else nullptr. Must
+     * be called with `_mutex` held.
+     */
+    std::shared_ptr<const ArbiterDependencyList> cachedDependencies (const Arbiter::Resolver::ProjectVersion &resolved);
+
+    /**
+     * Returns the list of available versions for the given project if it has
+     * already been fetched or is in the behavior cache, or else nullptr. Must
+     * be called with `_mutex` held.
+     */
+    std::shared_ptr<const ArbiterSelectedVersionList> cachedAvailableVersions (Arbiter::Resolver::ProjectID project);
+
+    /**
+     * Invokes the synchronous `createDependencyList` behavior, without
+     * consulting or updating the cache.
+     */
+    std::shared_ptr<const ArbiterDependencyList> createDependencyList (const Arbiter::Resolver::ProjectVersion &resolved) noexcept(false);
+
+    /**
+     * Invokes the synchronous `createAvailableVersionsList` behavior, without
+     * consulting or updating the cache.
+     */
+    std::shared_ptr<const ArbiterSelectedVersionList> createAvailableVersionsList (Arbiter::Resolver::ProjectID project) noexcept(false);
+
+    /**
+     * Fetches a dependency list through the shared cache, invoking the
+     * synchronous `createDependencyList` behavior only if no other resolver
+     * has requested the list already. May be called without `_mutex` held.
+     */
+    std::shared_ptr<const ArbiterDependencyList> createSharedDependencyList (const Arbiter::Resolver::ProjectVersion &resolved) noexcept(false);
+
+    /**
+     * Returns the pending request for the given dependency list, making one
+     * if necessary. Must be called with `_mutex` held.
+     *
+     * Requests are asynchronous unless they are made through a shared cache,
+     * in which case synchronous behaviors are invoked (and the request
+     * completed) before returning, so that other threads of this resolver
+     * never wait for a request while holding `_mutex`.
+     */
+    std::shared_ptr<Arbiter::Future<std::shared_ptr<const ArbiterDependencyList>>> requestDependencies (const Arbiter::Resolver::ProjectVersion &resolved);
+
+    /**
+     * Returns the pending request for the given version list, making one if
+     * necessary, in the same way as requestDependencies(). Must be called with
+     * `_mutex` held.
+     */
+    std::shared_ptr<Arbiter::Future<std::shared_ptr<const ArbiterSelectedVersionList>>> requestAvailableVersions (Arbiter::Resolver::ProjectID project);
+
+    /**
+     * Blocks until the given request has completed, then returns its value.
+     * Must be called without `_mutex` held.
+     *
+     * Throws Exception::Cancelled if cancel() is called first.
+     */
+    template<typename T>
+    T waitFor (const Arbiter::Future<T> &future) noexcept(false)
+    {
+      std::list<std::function<void()>>::iterator wait;
+
+      {
+        std::lock_guard<std::mutex> guard(_waitsMutex);
+        wait = _waits.emplace(_waits.end(), [&future] {
+          future.interrupt();
+        });
+      }
+
+      const auto forget = [&] {
+        std::lock_guard<std::mutex> guard(_waitsMutex);
+        _waits.erase(wait);
+      };
+
+      try {
+        T value = future.wait(_cancelled);
+        forget();
+        return value;
+      } catch (...) {
+        forget();
+        throw;
+      }
+    }
+
+    /**
+     * Attempts to verify and activate any unarchived incompatibilities which
+     * involve the given project, now that its available versions are known.
+     */
+    void activateUnarchivedIncompatibilities (Arbiter::Resolver::ProjectID project);
+
+    /**
+     * Attempts to verify and activate the unarchived incompatibility at the
+     * given index, returning its new state.
+     */
+    ArchivedState activateUnarchivedIncompatibility (size_t index);
+
+    /**
+     * Resolves the dependencies of `dependencyList`, exploring the search
+     * space with up to `threadCount` threads.
+     */
+    ArbiterResolvedDependencyGraph resolve (const ArbiterDependencyList &dependencyList, size_t threadCount) noexcept(false);
 };
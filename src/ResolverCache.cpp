@@ -0,0 +1,59 @@
+#include "ResolverCache.h"
+
+#include "Hash.h"
+
+using namespace Arbiter;
+using namespace Resolver;
+
+ArbiterResolverCache *ArbiterCreateResolverCache (void)
+{
+  return new ArbiterResolverCache;
+}
+
+std::unique_ptr<Base> ArbiterResolverCache::clone () const
+{
+  return std::make_unique<ArbiterResolverCache>(*this);
+}
+
+std::ostream &ArbiterResolverCache::describe (std::ostream &os) const
+{
+  return os << "ArbiterResolverCache (" << _cache->size() << " lists)";
+}
+
+bool ArbiterResolverCache::operator== (const Base &other) const
+{
+  if (auto ptr = dynamic_cast<const ArbiterResolverCache *>(&other)) {
+    return _cache == ptr->_cache;
+  } else {
+    return false;
+  }
+}
+
+size_t SharedCache::ProjectVersionHash::operator() (const ProjectVersion &projectVersion) const
+{
+  return hashOf(projectVersion.first) ^ hashOf(projectVersion.second);
+}
+
+std::pair<std::shared_ptr<SharedCache::VersionListRequest>, bool> SharedCache::availableVersions (const ArbiterProjectIdentifier &project)
+{
+  return _availableVersions.findOrInsert(project, [] {
+    return std::make_shared<VersionListRequest>();
+  });
+}
+
+std::pair<std::shared_ptr<SharedCache::DependencyListRequest>, bool> SharedCache::dependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version)
+{
+  return _dependencies.findOrInsert(ProjectVersion(project, version), [] {
+    return std::make_shared<DependencyListRequest>();
+  });
+}
+
+void SharedCache::forgetAvailableVersions (const ArbiterProjectIdentifier &project, const std::shared_ptr<VersionListRequest> &request)
+{
+  _availableVersions.eraseIf(project, request);
+}
+
+void SharedCache::forgetDependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version, const std::shared_ptr<DependencyListRequest> &request)
+{
+  _dependencies.eraseIf(ProjectVersion(project, version), request);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include <arbiter/Resolver.h>
+
+#include "Dependency.h"
+#include "Future.h"
+#include "ShardedMap.h"
+#include "Types.h"
+#include "Version.h"
+
+#include <memory>
+#include <ostream>
+#include <utility>
+
+namespace Arbiter {
+namespace Resolver {
+
+/**
+ * Lists of available versions and of dependencies shared by every resolver
+ * created with the same ArbiterResolverCache.
+ *
+ * Each list is stored as the Future for the one request made for it, so
+ * resolvers which need a list while it is still being requested wait for
+ * that request rather than making their own.
+ */
+class SharedCache final
+{
+  public:
+    using VersionListRequest = Future<std::shared_ptr<const ArbiterSelectedVersionList>>;
+    using DependencyListRequest = Future<std::shared_ptr<const ArbiterDependencyList>>;
+
+    SharedCache () = default;
+
+    SharedCache (const SharedCache &) = delete;
+    SharedCache &operator= (const SharedCache &) = delete;
+
+    /**
+     * Returns the request for the available versions of `project`, along with
+     * whether it was just created, in which case the caller must complete it.
+     */
+    std::pair<std::shared_ptr<VersionListRequest>, bool> availableVersions (const ArbiterProjectIdentifier &project);
+
+    /**
+     * Returns the request for the dependencies of `version` of `project`,
+     * along with whether it was just created, in which case the caller must
+     * complete it.
+     */
+    std::pair<std::shared_ptr<DependencyListRequest>, bool> dependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version);
+
+    /**
+     * Removes a failed request for the available versions of `project`, if it
+     * has not been replaced already, so that it can be made again.
+     */
+    void forgetAvailableVersions (const ArbiterProjectIdentifier &project, const std::shared_ptr<VersionListRequest> &request);
+
+    /**
+     * Removes a failed request for the dependencies of `version` of
+     * `project`, if it has not been replaced already, so that it can be made
+     * again.
+     */
+    void forgetDependencies (const ArbiterProjectIdentifier &project, const ArbiterSelectedVersion &version, const std::shared_ptr<DependencyListRequest> &request);
+
+    /**
+     * Returns the number of lists which have been requested, whether or not
+     * those requests have completed.
+     */
+    size_t size () const
+    {
+      return _availableVersions.size() + _dependencies.size();
+    }
+
+  private:
+    using ProjectVersion = std::pair<ArbiterProjectIdentifier, ArbiterSelectedVersion>;
+
+    struct ProjectVersionHash final
+    {
+      public:
+        size_t operator() (const ProjectVersion &projectVersion) const;
+    };
+
+    ShardedMap<ArbiterProjectIdentifier, std::shared_ptr<VersionListRequest>> _availableVersions;
+    ShardedMap<ProjectVersion, std::shared_ptr<DependencyListRequest>, ProjectVersionHash> _dependencies;
+};
+
+} // namespace Resolver
+} // namespace Arbiter
+
+/**
+ * A reference to a SharedCache. Copies refer to the same cache.
+ */
+struct ArbiterResolverCache final : public Arbiter::Base
+{
+  public:
+    std::shared_ptr<Arbiter::Resolver::SharedCache> _cache;
+
+    ArbiterResolverCache ()
+      : _cache(std::make_shared<Arbiter::Resolver::SharedCache>())
+    {}
+
+    std::unique_ptr<Arbiter::Base> clone () const override;
+    std::ostream &describe (std::ostream &os) const override;
+    bool operator== (const Arbiter::Base &other) const override;
+};
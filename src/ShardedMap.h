@@ -0,0 +1,112 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace Arbiter {
+
+/**
+ * A hash map which may be used from many threads at once.
+ *
+ * Entries are divided among a fixed number of shards by hash, each with its
+ * own lock, so that threads working with different keys rarely contend.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedMap final
+{
+  public:
+    static constexpr size_t shardCount = 16;
+
+    ShardedMap () = default;
+
+    ShardedMap (const ShardedMap &) = delete;
+    ShardedMap &operator= (const ShardedMap &) = delete;
+
+    /**
+     * Returns the value associated with `key`, first inserting the result of
+     * `create()` if there is none, along with whether it was inserted.
+     *
+     * `create` is invoked with the shard locked, so it should be quick and
+     * must not use this map.
+     */
+    template<typename Factory>
+    std::pair<Value, bool> findOrInsert (const Key &key, Factory &&create)
+    {
+      Shard &shard = shardFor(key);
+      std::lock_guard<std::mutex> guard(shard._mutex);
+
+      auto it = shard._entries.find(key);
+      if (it != shard._entries.end()) {
+        return std::make_pair(it->second, false);
+      }
+
+      it = shard._entries.emplace(key, create()).first;
+      return std::make_pair(it->second, true);
+    }
+
+    /**
+     * Removes the entry for `key` if its value is equal to `value`, and
+     * returns whether it did.
+     */
+    bool eraseIf (const Key &key, const Value &value)
+    {
+      Shard &shard = shardFor(key);
+      std::lock_guard<std::mutex> guard(shard._mutex);
+
+      const auto it = shard._entries.find(key);
+      if (it == shard._entries.end() || !(it->second == value)) {
+        return false;
+      }
+
+      shard._entries.erase(it);
+      return true;
+    }
+
+    /**
+     * Returns the number of entries in the map, which may be out of date as
+     * soon as it is returned if other threads are modifying the map.
+     */
+    size_t size () const
+    {
+      size_t size = 0;
+
+      for (const Shard &shard : _shards) {
+        std::lock_guard<std::mutex> guard(shard._mutex);
+        size += shard._entries.size();
+      }
+
+      return size;
+    }
+
+  private:
+    struct Shard final
+    {
+      public:
+        mutable std::mutex _mutex;
+        std::unordered_map<Key, Value, Hash> _entries;
+    };
+
+    std::array<Shard, shardCount> _shards;
+
+    Shard &shardFor (const Key &key)
+    {
+      size_t hash = Hash()(key);
+
+      // User-provided hashes may vary only in their high bits, which would
+      // otherwise all land in the same shard.
+      hash ^= hash >> 17;
+      hash ^= hash >> 7;
+
+      return _shards[hash % shardCount];
+    }
+};
+
+} // namespace Arbiter
@@ -6,10 +6,13 @@
 
 #include <arbiter/Value.h>
 
+#include "Optional.h"
 #include "ToString.h"
 
 #include <cassert>
+#include <cstdlib>
 #include <functional>
+#include <memory>
 #include <ostream>
 
 namespace Arbiter {
@@ -36,6 +39,7 @@ class SharedUserValue final
       , _lessThan(value.lessThan)
       , _hash(value.hash)
       , _createDescription(value.createDescription)
+      , _createSerialization(value.createSerialization)
     {
       assert(_equalTo);
       assert(_lessThan);
@@ -84,6 +88,14 @@ class SharedUserValue final
       return _data.get();
     }
 
+    /**
+     * Returns whether the user provided a way to describe this value.
+     */
+    bool hasDescription () const noexcept
+    {
+      return _createDescription != nullptr;
+    }
+
     std::string description () const
     {
       if (_createDescription) {
@@ -98,12 +110,28 @@ class SharedUserValue final
       return _hash(data());
     }
 
+    /**
+     * Returns the bytes from which this value can be recreated, or None if the
+     * user did not provide a way to serialize it.
+     */
+    Arbiter::Optional<std::string> serialization () const
+    {
+      if (!_createSerialization) {
+        return Arbiter::None();
+      }
+
+      size_t length = 0;
+      std::unique_ptr<void, void (*)(void *)> bytes(_createSerialization(data(), &length), &std::free);
+      return Arbiter::makeOptional(std::string(static_cast<const char *>(bytes.get()), length));
+    }
+
   private:
     std::shared_ptr<void> _data;
     bool (*_equalTo)(const void *first, const void *second);
     bool (*_lessThan)(const void *first, const void *second);
     size_t (*_hash)(const void *data);
     char *(*_createDescription)(const void *data);
+    void *(*_createSerialization)(const void *data, size_t *length);
 
     static void noOpDestructor (void *)
     {}
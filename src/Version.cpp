@@ -2,10 +2,12 @@
 
 #include "Hash.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <ostream>
-#include <regex>
-#include <sstream>
 #include <string>
+#include <tuple>
 
 using namespace Arbiter;
 
@@ -23,45 +25,343 @@ size_t std::hash<ArbiterSelectedVersion>::operator() (const ArbiterSelectedVersi
   return hashOf(version._semanticVersion) ^ hashOf(version._metadata);
 }
 
+namespace {
+
+bool isDigit (char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+bool isIdentifierCharacter (char c)
+{
+  return isDigit(c) || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '-';
+}
+
+/**
+ * Parses a version number without a leading zero from the front of the range
+ * `[it, end)`, advancing `it` past it.
+ *
+ * Fails if the number does not fit in an unsigned integer.
+ */
+bool parseVersionNumber (const char *&it, const char *end, unsigned &number)
+{
+  if (it == end || !isDigit(*it)) {
+    return false;
+  }
+
+  number = 0;
+
+  if (*it == '0') {
+    ++it;
+    return true;
+  }
+
+  for (; it != end && isDigit(*it); ++it) {
+    const unsigned digit = *it - '0';
+    if (number > (std::numeric_limits<unsigned>::max() - digit) / 10) {
+      return false;
+    }
+
+    number = number * 10 + digit;
+  }
+
+  return true;
+}
+
+/**
+ * Parses a non-empty, dot-separated list of identifiers from the front of the
+ * range `[it, end)`, advancing `it` past it.
+ *
+ * Identifiers consist of alphanumerics and hyphens, and cannot have a leading
+ * zero unless they are exactly "0".
+ */
+bool parseDottedIdentifier (const char *&it, const char *end)
+{
+  while (true) {
+    if (it == end || !isIdentifierCharacter(*it)) {
+      return false;
+    }
+
+    if (*it == '0') {
+      ++it;
+
+      if (it != end && isIdentifierCharacter(*it)) {
+        return false;
+      }
+    } else {
+      while (it != end && isIdentifierCharacter(*it)) {
+        ++it;
+      }
+    }
+
+    if (it == end || *it != '.') {
+      return true;
+    }
+
+    ++it;
+  }
+}
+
+/**
+ * Writes a precedence key into a fixed buffer, dropping whatever does not fit.
+ */
+class KeyWriter final
+{
+  public:
+    KeyWriter (char *bytes, size_t capacity)
+      : _bytes(bytes)
+      , _capacity(capacity)
+    {}
+
+    size_t size () const noexcept
+    {
+      return _length;
+    }
+
+    bool truncated () const noexcept
+    {
+      return _truncated;
+    }
+
+    void push_back (char c) noexcept
+    {
+      if (_length < _capacity) {
+        _bytes[_length++] = c;
+      } else {
+        _truncated = true;
+      }
+    }
+
+    void append (const char *it, const char *end) noexcept
+    {
+      for (; it != end && !_truncated; ++it) {
+        push_back(*it);
+      }
+    }
+
+  private:
+    char *_bytes;
+    size_t _capacity;
+    size_t _length = 0;
+    bool _truncated = false;
+};
+
+/**
+ * Appends the length of a number to a precedence key, such that longer
+ * numbers sort after shorter ones.
+ */
+void appendLength (KeyWriter &key, size_t length)
+{
+  const unsigned char longLength = 0xFF;
+
+  if (length < longLength) {
+    key.push_back(static_cast<char>(length));
+  } else {
+    key.push_back(static_cast<char>(longLength));
+
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      key.push_back(static_cast<char>((length >> shift) & 0xFF));
+    }
+  }
+}
+
+/**
+ * Returns whether the identifier `[it, end)` consists only of digits.
+ */
+bool isNumericIdentifier (const char *it, const char *end)
+{
+  return it != end && std::all_of(it, end, &isDigit);
+}
+
+/**
+ * Drops the leading zeroes from the numeric identifier `[it, end)`, leaving at
+ * least one digit.
+ */
+void skipLeadingZeroes (const char *&it, const char *end)
+{
+  while (it + 1 < end && *it == '0') {
+    ++it;
+  }
+}
+
+/**
+ * Compares two prerelease versions by precedence without encoding them,
+ * returning a negative number, zero, or a positive number like strcmp().
+ *
+ * This must agree with the order of the keys built by makePrereleaseKey().
+ */
+int comparePrereleaseVersions (const std::string &lhs, const std::string &rhs)
+{
+  const char *left = lhs.data();
+  const char *leftEnd = left + lhs.size();
+  const char *right = rhs.data();
+  const char *rightEnd = right + rhs.size();
+
+  while (true) {
+    const char *leftIdentifierEnd = std::find(left, leftEnd, '.');
+    const char *rightIdentifierEnd = std::find(right, rightEnd, '.');
+
+    const bool leftNumeric = isNumericIdentifier(left, leftIdentifierEnd);
+    const bool rightNumeric = isNumericIdentifier(right, rightIdentifierEnd);
+
+    int order;
+
+    if (leftNumeric != rightNumeric) {
+      order = (leftNumeric ? -1 : 1);
+    } else {
+      const char *leftStart = left;
+      const char *rightStart = right;
+
+      if (leftNumeric) {
+        skipLeadingZeroes(leftStart, leftIdentifierEnd);
+        skipLeadingZeroes(rightStart, rightIdentifierEnd);
+      }
+
+      const size_t leftLength = leftIdentifierEnd - leftStart;
+      const size_t rightLength = rightIdentifierEnd - rightStart;
+
+      // Longer numbers are greater, while alphanumerics compare byte by byte.
+      if (leftNumeric && leftLength != rightLength) {
+        order = (leftLength < rightLength ? -1 : 1);
+      } else {
+        order = std::memcmp(leftStart, rightStart, std::min(leftLength, rightLength));
+
+        if (order == 0 && leftLength != rightLength) {
+          order = (leftLength < rightLength ? -1 : 1);
+        }
+      }
+    }
+
+    if (order != 0) {
+      return order;
+    }
+
+    const bool leftDone = (leftIdentifierEnd == leftEnd);
+    const bool rightDone = (rightIdentifierEnd == rightEnd);
+
+    if (leftDone || rightDone) {
+      return (leftDone == rightDone ? 0 : (leftDone ? -1 : 1));
+    }
+
+    left = leftIdentifierEnd + 1;
+    right = rightIdentifierEnd + 1;
+  }
+}
+
+} // namespace
+
 Optional<ArbiterSemanticVersion> ArbiterSemanticVersion::fromString (const std::string &versionString)
 {
-  // Versions and identifiers cannot have a leading zero.
-  #define VERSION "(0|[1-9][0-9]*)"
-  #define IDENTIFIER "(?:0|[1-9A-Za-z-][0-9A-Za-z-]*)"
-  #define DOTTED_IDENTIFIER "(" IDENTIFIER "(?:\\." IDENTIFIER ")*)"
+  return fromString(versionString.data(), versionString.size());
+}
 
-  std::regex pattern {
-    VERSION "\\." VERSION "\\." VERSION
-    // prerelease begins with a hyphen followed by a dot separated identifier
-    "(?:"   "-" DOTTED_IDENTIFIER ")?"
-    // metadata begins with a plus sign followed by a dot separated identifier
-    "(?:" "\\+" DOTTED_IDENTIFIER ")?"
-  };
+Optional<ArbiterSemanticVersion> ArbiterSemanticVersion::fromString (const char *string, size_t length)
+{
+  const char *it = string;
+  const char *end = string + length;
 
-  #undef DOTTED_IDENTIFIER
-  #undef IDENTIFIER
-  #undef VERSION
+  unsigned major;
+  unsigned minor;
+  unsigned patch;
 
-  std::smatch match;
-  if (!std::regex_match(versionString, match, pattern)) {
-    return Optional<ArbiterSemanticVersion>();
+  if (!parseVersionNumber(it, end, major) || it == end || *it++ != '.') {
+    return None();
   }
 
-  unsigned major = std::stoul(match.str(1));
-  unsigned minor = std::stoul(match.str(2));
-  unsigned patch = std::stoul(match.str(3));
+  if (!parseVersionNumber(it, end, minor) || it == end || *it++ != '.') {
+    return None();
+  }
+
+  if (!parseVersionNumber(it, end, patch)) {
+    return None();
+  }
 
   Optional<std::string> prereleaseVersion;
   Optional<std::string> buildMetadata;
 
-  if (match.length(4) > 0) {
-    prereleaseVersion = Optional<std::string>(match.str(4));
+  // prerelease begins with a hyphen followed by a dot separated identifier
+  if (it != end && *it == '-') {
+    const char *start = ++it;
+    if (!parseDottedIdentifier(it, end)) {
+      return None();
+    }
+
+    prereleaseVersion = std::string(start, it);
+  }
+
+  // metadata begins with a plus sign followed by a dot separated identifier
+  if (it != end && *it == '+') {
+    const char *start = ++it;
+    if (!parseDottedIdentifier(it, end)) {
+      return None();
+    }
+
+    buildMetadata = std::string(start, it);
+  }
+
+  if (it != end) {
+    return None();
   }
-  if (match.length(5) > 0) {
-    buildMetadata = Optional<std::string>(match.str(5));
+
+  return ArbiterSemanticVersion(major, minor, patch, std::move(prereleaseVersion), std::move(buildMetadata));
+}
+
+uint64_t ArbiterSemanticVersion::makeVersionKey (unsigned major, unsigned minor, unsigned patch) noexcept
+{
+  const uint64_t limit = uint64_t(1) << versionKeyFieldBits;
+  if (major >= limit || minor >= limit || patch >= limit) {
+    return overflowedVersionKey;
+  }
+
+  return (uint64_t(major) << (2 * versionKeyFieldBits)) | (uint64_t(minor) << versionKeyFieldBits) | patch;
+}
+
+ArbiterSemanticVersion::PrereleaseKey ArbiterSemanticVersion::makePrereleaseKey (const Optional<std::string> &prereleaseVersion)
+{
+  PrereleaseKey result;
+  if (!prereleaseVersion) {
+    return result;
+  }
+
+  KeyWriter key(result._bytes, PrereleaseKey::capacity);
+
+  // Numeric identifiers have lower precedence than alphanumeric ones, so
+  // their tag sorts first.
+  const char numericTag = 1;
+  const char alphanumericTag = 2;
+
+  const char *it = prereleaseVersion->data();
+  const char *end = it + prereleaseVersion->size();
+
+  while (!key.truncated()) {
+    const char *identifierEnd = std::find(it, end, '.');
+
+    if (isNumericIdentifier(it, identifierEnd)) {
+      // Compare numbers by length and then digit by digit, which is the same
+      // as comparing their values once leading zeroes are dropped.
+      skipLeadingZeroes(it, identifierEnd);
+
+      key.push_back(numericTag);
+      appendLength(key, identifierEnd - it);
+      key.append(it, identifierEnd);
+    } else {
+      // Terminate the identifier so that it sorts before any longer
+      // identifier which it is a prefix of.
+      key.push_back(alphanumericTag);
+      key.append(it, identifierEnd);
+      key.push_back('\0');
+    }
+
+    if (identifierEnd == end) {
+      break;
+    }
+
+    it = identifierEnd + 1;
   }
 
-  return ArbiterSemanticVersion(major, minor, patch, prereleaseVersion, buildMetadata);
+  result._length = static_cast<unsigned char>(key.size());
+  result._truncated = key.truncated();
+  return result;
 }
 
 std::unique_ptr<Arbiter::Base> ArbiterSemanticVersion::clone () const
@@ -96,89 +396,37 @@ bool ArbiterSemanticVersion::operator== (const Arbiter::Base &other) const
 
 bool ArbiterSemanticVersion::operator< (const ArbiterSemanticVersion &other) const noexcept
 {
-  if (_major < other._major) {
-    return true;
-  } else if (_major > other._major) {
-    return false;
-  }
+  if (_versionKey == overflowedVersionKey || other._versionKey == overflowedVersionKey) {
+    const auto fields = std::tie(_major, _minor, _patch);
+    const auto otherFields = std::tie(other._major, other._minor, other._patch);
 
-  if (_minor < other._minor) {
-    return true;
-  } else if (_minor > other._minor) {
-    return false;
+    if (fields != otherFields) {
+      return fields < otherFields;
+    }
+  } else if (_versionKey != other._versionKey) {
+    return _versionKey < other._versionKey;
   }
 
-  if (_patch < other._patch) {
-    return true;
-  } else if (_patch > other._patch) {
+  // Build metadata does not participate in precedence, and a version without
+  // a prerelease version has higher precedence than one with.
+  if (!_prereleaseVersion) {
     return false;
+  } else if (!other._prereleaseVersion) {
+    return true;
   }
 
-  if (_prereleaseVersion) {
-    if (!other._prereleaseVersion) {
-      return true;
-    }
-    
-    std::istringstream left(*_prereleaseVersion);
-    std::istringstream right(*other._prereleaseVersion);
-
-    while (true) {
-      std::string leftPiece;
-      std::string rightPiece;
-
-      if (!std::getline(left, leftPiece, '.')) {
-        if (std::getline(right, rightPiece, '.')) {
-          // `left` is shorter, therefore lower precedence
-          return true;
-        } else {
-          // Equivalent prerelease versions
-          return false;
-        }
-      } else if (!std::getline(right, rightPiece, '.')) {
-        // `right` is shorter, therefore `left` is higher precedence
-        return false;
-      }
-
-      Optional<unsigned long> leftNum;
-      Optional<unsigned long> rightNum;
-
-      try {
-        leftNum = std::stoul(leftPiece);
-      } catch (std::invalid_argument &ex) {
-      }
+  const PrereleaseKey &key = _prereleaseKey;
+  const PrereleaseKey &otherKey = other._prereleaseKey;
 
-      try {
-        rightNum = std::stoul(rightPiece);
-      } catch (std::invalid_argument &ex) {
-      }
+  if (const int order = std::memcmp(key._bytes, otherKey._bytes, std::min(key._length, otherKey._length))) {
+    return order < 0;
+  }
 
-      if (leftNum) {
-        if (rightNum) {
-          if (*leftNum < *rightNum) {
-            return true;
-          } else if (*leftNum > *rightNum) {
-            return false;
-          }
-        } else {
-          // `left` has lower precedence because it is numeric
-          return true;
-        }
-      } else if (rightNum) {
-        // `left` has higher precedence because it is non-numeric
-        return false;
-      } else {
-        // Compare strings lexically
-        if (leftPiece < rightPiece) {
-          return true;
-        } else if (leftPiece > rightPiece) {
-          return false;
-        }
-      }
-    }
+  if (key._truncated || otherKey._truncated) {
+    return comparePrereleaseVersions(*_prereleaseVersion, *other._prereleaseVersion) < 0;
   }
 
-  // Build metadata does not participate in precedence.
-  return false;
+  return key._length < otherKey._length;
 }
 
 std::unique_ptr<Arbiter::Base> ArbiterSelectedVersion::clone () const
@@ -213,6 +461,8 @@ bool ArbiterSelectedVersion::operator< (const ArbiterSelectedVersion &other) con
     if (other._semanticVersion) {
       if (*_semanticVersion < *other._semanticVersion) {
         return true;
+      } else if (*other._semanticVersion < *_semanticVersion) {
+        return false;
       }
     } else {
       // Versions with a semantic version component should have higher
@@ -276,7 +526,12 @@ ArbiterSemanticVersion *ArbiterCreateSemanticVersion (unsigned major, unsigned m
 
 ArbiterSemanticVersion *ArbiterCreateSemanticVersionFromString (const char *string)
 {
-  auto version = ArbiterSemanticVersion::fromString(string);
+  return ArbiterCreateSemanticVersionFromStringWithLength(string, std::strlen(string));
+}
+
+ArbiterSemanticVersion *ArbiterCreateSemanticVersionFromStringWithLength (const char *string, size_t length)
+{
+  auto version = ArbiterSemanticVersion::fromString(string, length);
   if (version) {
     return new ArbiterSemanticVersion(std::move(version.value()));
   } else {
@@ -354,3 +609,21 @@ ArbiterSelectedVersionList *ArbiterCreateSelectedVersionList (const ArbiterSelec
 
   return new ArbiterSelectedVersionList(std::move(vec));
 }
+
+ArbiterSelectedVersionList *ArbiterCreateSelectedVersionListFromStrings (const char * const *strings, const size_t *lengths, const ArbiterUserValue *metadata, size_t count)
+{
+  std::vector<ArbiterSelectedVersion> vec;
+  vec.reserve(count);
+
+  for (size_t i = 0; i < count; i++) {
+    // Take ownership of the metadata even if it goes unused.
+    ArbiterSelectedVersion::Metadata versionMetadata(metadata[i]);
+
+    const size_t length = (lengths ? lengths[i] : std::strlen(strings[i]));
+    if (auto version = ArbiterSemanticVersion::fromString(strings[i], length)) {
+      vec.emplace_back(std::move(version), std::move(versionMetadata));
+    }
+  }
+
+  return new ArbiterSelectedVersionList(std::move(vec));
+}
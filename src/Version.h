@@ -10,6 +10,7 @@
 #include "Types.h"
 #include "Value.h"
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
@@ -28,8 +29,10 @@ struct ArbiterSemanticVersion final : public Arbiter::Base
       : _major(major)
       , _minor(minor)
       , _patch(patch)
-      , _prereleaseVersion(prereleaseVersion)
-      , _buildMetadata(buildMetadata)
+      , _prereleaseVersion(std::move(prereleaseVersion))
+      , _buildMetadata(std::move(buildMetadata))
+      , _versionKey(makeVersionKey(major, minor, patch))
+      , _prereleaseKey(makePrereleaseKey(_prereleaseVersion))
     {}
 
     /**
@@ -38,6 +41,12 @@ struct ArbiterSemanticVersion final : public Arbiter::Base
     // TODO: Add error reporting
     static Arbiter::Optional<ArbiterSemanticVersion> fromString (const std::string &versionString);
 
+    /**
+     * Attempts to parse a well-formed semantic version from the `length`
+     * characters starting at `string`, which need not be NUL-terminated.
+     */
+    static Arbiter::Optional<ArbiterSemanticVersion> fromString (const char *string, size_t length);
+
     std::unique_ptr<Arbiter::Base> clone () const override;
     std::ostream &describe (std::ostream &os) const override;
     bool operator== (const Arbiter::Base &other) const override;
@@ -58,6 +67,54 @@ struct ArbiterSemanticVersion final : public Arbiter::Base
     {
       return other >= *this;
     }
+
+  private:
+    /**
+     * The number of bits given to each of the major, minor, and patch versions
+     * in a version key.
+     */
+    static constexpr unsigned versionKeyFieldBits = 21;
+
+    /**
+     * The version key of any version whose major, minor, or patch version is
+     * too large to pack. Comparisons involving it fall back to comparing the
+     * fields one by one.
+     */
+    static constexpr uint64_t overflowedVersionKey = UINT64_MAX;
+
+    /**
+     * The prerelease version, encoded so that comparing the keys of two
+     * versions byte by byte orders them by the precedence of their prerelease
+     * versions. Empty if there is no prerelease version.
+     *
+     * Keys are stored inline, so that building and copying them never
+     * allocates. Any key which does not fit is truncated, and comparisons
+     * which its stored bytes cannot decide fall back to comparing the
+     * prerelease versions themselves.
+     */
+    struct PrereleaseKey final
+    {
+      public:
+        static constexpr size_t capacity = 22;
+
+        unsigned char _length = 0;
+        bool _truncated = false;
+        char _bytes[capacity] = {};
+    };
+
+    /**
+     * The major, minor, and patch versions packed into one integer, so that
+     * comparing the keys of two versions orders them by all three fields at
+     * once.
+     *
+     * This and the prerelease key are computed once upon construction, so the
+     * fields above must not be modified afterward.
+     */
+    uint64_t _versionKey;
+    PrereleaseKey _prereleaseKey;
+
+    static uint64_t makeVersionKey (unsigned major, unsigned minor, unsigned patch) noexcept;
+    static PrereleaseKey makePrereleaseKey (const Arbiter::Optional<std::string> &prereleaseVersion);
 };
 
 struct ArbiterSelectedVersion final : public Arbiter::Base
@@ -0,0 +1,204 @@
+#include "VersionTable.h"
+
+#include "Requirement.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+using namespace Arbiter;
+using namespace Resolver;
+
+void IntervalSet::append (size_t begin, size_t end)
+{
+  if (begin >= end) {
+    return;
+  }
+
+  assert(_intervals.empty() || begin >= _intervals.back().second);
+
+  if (!_intervals.empty() && _intervals.back().second == begin) {
+    _intervals.back().second = end;
+  } else {
+    _intervals.emplace_back(begin, end);
+  }
+}
+
+bool IntervalSet::contains (size_t index) const noexcept
+{
+  // Find the first interval which ends after `index`.
+  const auto it = std::upper_bound(_intervals.begin(), _intervals.end(), index, [](size_t value, const Interval &interval) {
+    return value < interval.second;
+  });
+
+  return it != _intervals.end() && it->first <= index;
+}
+
+size_t IntervalSet::count () const noexcept
+{
+  size_t count = 0;
+  for (const Interval &interval : _intervals) {
+    count += interval.second - interval.first;
+  }
+
+  return count;
+}
+
+IntervalSet IntervalSet::intersect (const IntervalSet &other) const
+{
+  IntervalSet result;
+
+  auto lhs = _intervals.begin();
+  auto rhs = other._intervals.begin();
+
+  while (lhs != _intervals.end() && rhs != other._intervals.end()) {
+    result.append(std::max(lhs->first, rhs->first), std::min(lhs->second, rhs->second));
+
+    // Whichever interval ends first cannot overlap anything else.
+    if (lhs->second < rhs->second) {
+      ++lhs;
+    } else {
+      ++rhs;
+    }
+  }
+
+  return result;
+}
+
+VersionTable::VersionTable (std::vector<ArbiterSelectedVersion> versions)
+  : _versions(std::move(versions))
+{
+  std::sort(_versions.begin(), _versions.end());
+
+  // Versions without a semantic version have the lowest precedence.
+  _firstSemantic = std::partition_point(_versions.begin(), _versions.end(), [](const ArbiterSelectedVersion &version) {
+    return !version._semanticVersion;
+  }) - _versions.begin();
+}
+
+template<typename Predicate>
+size_t VersionTable::partitionPoint (const Predicate &predicate) const
+{
+  return std::partition_point(_versions.begin() + _firstSemantic, _versions.end(), [&predicate](const ArbiterSelectedVersion &version) {
+    return predicate(*version._semanticVersion);
+  }) - _versions.begin();
+}
+
+Optional<IntervalSet> VersionTable::compile (const ArbiterRequirement &requirement) const
+{
+  const size_t end = _versions.size();
+
+  if (requirement.kind() == Requirement::Kind::Any) {
+    return makeOptional(IntervalSet::range(0, end));
+  } else if (const auto *atLeast = Requirement::requirementCast<Requirement::AtLeast>(requirement)) {
+    const size_t begin = partitionPoint([atLeast](const ArbiterSemanticVersion &version) {
+      return version < atLeast->_minimumVersion;
+    });
+
+    return makeOptional(IntervalSet::range(begin, end));
+  } else if (const auto *compatibleWith = Requirement::requirementCast<Requirement::CompatibleWith>(requirement)) {
+    const ArbiterSemanticVersion &base = compatibleWith->_baseVersion;
+
+    const size_t begin = partitionPoint([&base](const ArbiterSemanticVersion &version) {
+      return version < base;
+    });
+
+    // Compatible versions share the major version of the base version, and
+    // for 0.y.z releases, the minor (and possibly patch) version as well. All
+    // of those are prefixes of the precedence order, so they're contiguous.
+    const size_t compatibleEnd = partitionPoint([&base, compatibleWith](const ArbiterSemanticVersion &version) {
+      if (version._major != base._major) {
+        return version._major < base._major;
+      } else if (base._major != 0) {
+        return true;
+      } else if (version._minor != base._minor) {
+        return version._minor < base._minor;
+      } else if (compatibleWith->_strictness == ArbiterRequirementStrictnessStrict) {
+        return version._patch <= base._patch;
+      } else {
+        return true;
+      }
+    });
+
+    return makeOptional(IntervalSet::range(begin, std::max(begin, compatibleEnd)));
+  } else if (const auto *exactly = Requirement::requirementCast<Requirement::Exactly>(requirement)) {
+    const ArbiterSemanticVersion &exact = exactly->_version;
+
+    const size_t begin = partitionPoint([&exact](const ArbiterSemanticVersion &version) {
+      return version < exact;
+    });
+
+    const size_t equivalentEnd = partitionPoint([&exact](const ArbiterSemanticVersion &version) {
+      return !(exact < version);
+    });
+
+    // Build metadata doesn't affect precedence, but must still match.
+    IntervalSet set;
+    for (size_t index = begin; index < equivalentEnd; ++index) {
+      if (*_versions[index]._semanticVersion == exact) {
+        set.append(index, index + 1);
+      }
+    }
+
+    return makeOptional(std::move(set));
+  } else if (const auto *compound = Requirement::requirementCast<Requirement::Compound>(requirement)) {
+    IntervalSet set = IntervalSet::range(0, end);
+
+    for (const auto &child : compound->_requirements) {
+      Optional<IntervalSet> childSet = compile(*child);
+      if (!childSet) {
+        return None();
+      }
+
+      set = set.intersect(*childSet);
+    }
+
+    return makeOptional(std::move(set));
+  } else {
+    return None();
+  }
+}
+
+Bitset VersionTable::mask (const ArbiterRequirement &requirement) const
+{
+  Bitset mask(_versions.size());
+
+  if (Optional<IntervalSet> compiled = compile(requirement)) {
+    for (const IntervalSet::Interval &interval : compiled->intervals()) {
+      mask.setRange(interval.first, interval.second);
+    }
+  } else {
+    for (size_t index = 0; index < _versions.size(); ++index) {
+      if (requirement.satisfiedBy(_versions[index])) {
+        mask.set(index);
+      }
+    }
+  }
+
+  return mask;
+}
+
+void CandidateList::remove (const ArbiterSelectedVersion &version)
+{
+  _versions.erase(std::remove_if(_versions.begin(), _versions.end(), [&version](const ArbiterSelectedVersion *candidate) {
+    return *candidate == version;
+  }), _versions.end());
+}
+
+void CandidateList::moveToFront (const ArbiterSelectedVersion &version)
+{
+  const auto it = std::find_if(_versions.begin(), _versions.end(), [&version](const ArbiterSelectedVersion *candidate) {
+    return *candidate == version;
+  });
+
+  if (it != _versions.end()) {
+    std::rotate(_versions.begin(), it, std::next(it));
+  }
+}
+
+void CandidateList::sortNewestFirst ()
+{
+  std::stable_sort(_versions.begin(), _versions.end(), [](const ArbiterSelectedVersion *lhs, const ArbiterSelectedVersion *rhs) {
+    return *rhs < *lhs;
+  });
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include "Bitset.h"
+#include "Optional.h"
+#include "Version.h"
+
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+struct ArbiterRequirement;
+
+namespace Arbiter {
+namespace Resolver {
+
+/**
+ * A set of indices, stored as sorted, disjoint, half-open intervals.
+ */
+class IntervalSet final
+{
+  public:
+    /**
+     * A half-open range of indices, from `first` up to but not including
+     * `second`.
+     */
+    using Interval = std::pair<size_t, size_t>;
+
+    IntervalSet () = default;
+
+    /**
+     * Returns a set containing every index from `begin` up to but not
+     * including `end`.
+     */
+    static IntervalSet range (size_t begin, size_t end)
+    {
+      IntervalSet set;
+      set.append(begin, end);
+      return set;
+    }
+
+    /**
+     * Adds the indices from `begin` up to but not including `end`, which must
+     * all be greater than any index already in the set.
+     */
+    void append (size_t begin, size_t end);
+
+    /**
+     * Returns whether `index` is in the set.
+     */
+    bool contains (size_t index) const noexcept;
+
+    bool empty () const noexcept
+    {
+      return _intervals.empty();
+    }
+
+    /**
+     * Returns the number of indices in the set.
+     */
+    size_t count () const noexcept;
+
+    /**
+     * Returns the indices which are in both this set and `other`.
+     */
+    IntervalSet intersect (const IntervalSet &other) const;
+
+    const std::vector<Interval> &intervals () const noexcept
+    {
+      return _intervals;
+    }
+
+    bool operator== (const IntervalSet &other) const noexcept
+    {
+      return _intervals == other._intervals;
+    }
+
+  private:
+    std::vector<Interval> _intervals;
+};
+
+/**
+ * The available versions of one project, sorted from lowest to highest
+ * precedence, so that the versions satisfying most requirements can be found
+ * by binary search rather than by testing each one.
+ */
+class VersionTable final
+{
+  public:
+    explicit VersionTable (std::vector<ArbiterSelectedVersion> versions);
+
+    /**
+     * Returns every version in the table, from lowest to highest precedence.
+     */
+    const std::vector<ArbiterSelectedVersion> &versions () const noexcept
+    {
+      return _versions;
+    }
+
+    /**
+     * Compiles `requirement` into the set of indices of the versions in this
+     * table which satisfy it.
+     *
+     * Returns None if the requirement depends upon something other than
+     * semantic versions (like metadata or a custom predicate), in which case
+     * each version must be tested with ArbiterRequirement::satisfiedBy()
+     * instead.
+     */
+    Optional<IntervalSet> compile (const ArbiterRequirement &requirement) const;
+
+    /**
+     * Returns the set of versions in this table which satisfy `requirement`,
+     * indexed in the same way as versions().
+     */
+    Bitset mask (const ArbiterRequirement &requirement) const;
+
+  private:
+    std::vector<ArbiterSelectedVersion> _versions;
+
+    /**
+     * The index of the first version with a semantic version. Every version
+     * before this has only metadata.
+     */
+    size_t _firstSemantic;
+
+    /**
+     * Returns the index of the first version (with a semantic version) for
+     * which `predicate` returns false, assuming it returns true for every
+     * version before that and false for every version after.
+     */
+    template<typename Predicate>
+    size_t partitionPoint (const Predicate &predicate) const;
+};
+
+/**
+ * A list of versions which refers to the versions in a VersionTable, rather
+ * than copying them.
+ *
+ * Versions which don't come from the table (like those found by their
+ * metadata) are owned by the list itself. Either way, references to the
+ * versions in a list remain valid when it is moved or swapped.
+ */
+class CandidateList final
+{
+  public:
+    size_t size () const noexcept
+    {
+      return _versions.size();
+    }
+
+    bool empty () const noexcept
+    {
+      return _versions.empty();
+    }
+
+    const ArbiterSelectedVersion &operator[] (size_t index) const noexcept
+    {
+      return *_versions[index];
+    }
+
+    const ArbiterSelectedVersion &front () const noexcept
+    {
+      return *_versions.front();
+    }
+
+    /**
+     * Appends the versions in `table` whose indices are in `domain`, from
+     * newest to oldest.
+     *
+     * Every version in the list which comes from a table must come from the
+     * same one.
+     */
+    void append (std::shared_ptr<const VersionTable> table, const Bitset &domain)
+    {
+      assert(!_table || _table == table);
+      _table = std::move(table);
+
+      const std::vector<ArbiterSelectedVersion> &versions = _table->versions();
+      domain.forEachReversed([&](size_t index) {
+        _versions.emplace_back(&versions[index]);
+      });
+    }
+
+    /**
+     * Appends a version which will be owned by the list.
+     */
+    void append (ArbiterSelectedVersion version)
+    {
+      _ownedVersions.emplace_back(std::move(version));
+      _versions.emplace_back(&_ownedVersions.back());
+    }
+
+    /**
+     * Removes every version equal to `version`.
+     */
+    void remove (const ArbiterSelectedVersion &version);
+
+    /**
+     * Moves the first version equal to `version`, if there is one, to the
+     * front of the list.
+     */
+    void moveToFront (const ArbiterSelectedVersion &version);
+
+    /**
+     * Sorts the list from newest to oldest.
+     */
+    void sortNewestFirst ();
+
+    void clear () noexcept
+    {
+      _versions.clear();
+      _ownedVersions.clear();
+      _table.reset();
+    }
+
+  private:
+    std::vector<const ArbiterSelectedVersion *> _versions;
+    std::shared_ptr<const VersionTable> _table;
+    std::deque<ArbiterSelectedVersion> _ownedVersions;
+};
+
+} // namespace Resolver
+} // namespace Arbiter
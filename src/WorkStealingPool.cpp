@@ -0,0 +1,82 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <thread>
+
+using namespace Arbiter;
+
+WorkStealingPool::WorkStealingPool (size_t threadCount)
+{
+  threadCount = std::max<size_t>(threadCount, 1);
+  _queues.reserve(threadCount);
+
+  for (size_t i = 0; i < threadCount; ++i) {
+    _queues.emplace_back(std::make_unique<Queue>());
+  }
+}
+
+void WorkStealingPool::run (size_t taskCount, const Task &task)
+{
+  for (size_t index = 0; index < taskCount; ++index) {
+    Queue &queue = *_queues[index % _queues.size()];
+
+    std::lock_guard<std::mutex> guard(queue._mutex);
+    queue._indices.emplace_back(index);
+  }
+
+  const size_t workerCount = std::min(_queues.size(), std::max<size_t>(taskCount, 1));
+
+  std::vector<std::thread> threads;
+  threads.reserve(workerCount - 1);
+
+  for (size_t queueIndex = 1; queueIndex < workerCount; ++queueIndex) {
+    threads.emplace_back([this, queueIndex, &task] {
+      work(queueIndex, task);
+    });
+  }
+
+  work(0, task);
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::work (size_t queueIndex, const Task &task)
+{
+  const size_t queueCount = _queues.size();
+
+  while (true) {
+    bool found = false;
+    size_t index = 0;
+
+    {
+      Queue &own = *_queues[queueIndex];
+      std::lock_guard<std::mutex> guard(own._mutex);
+
+      if (!own._indices.empty()) {
+        index = own._indices.front();
+        own._indices.pop_front();
+        found = true;
+      }
+    }
+
+    for (size_t offset = 1; !found && offset < queueCount; ++offset) {
+      Queue &victim = *_queues[(queueIndex + offset) % queueCount];
+      std::lock_guard<std::mutex> guard(victim._mutex);
+
+      if (!victim._indices.empty()) {
+        index = victim._indices.back();
+        victim._indices.pop_back();
+        found = true;
+      }
+    }
+
+    // No tasks are added while running, so there is nothing left to do.
+    if (!found) {
+      return;
+    }
+
+    task(index);
+  }
+}
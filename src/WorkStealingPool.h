@@ -0,0 +1,68 @@
+#pragma once
+
+#ifndef __cplusplus
+#error "This file must be compiled as C++."
+#endif
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Arbiter {
+
+/**
+ * Runs a batch of indexed tasks across a fixed number of threads.
+ *
+ * Tasks are dealt out to a queue per thread in ascending order, so that lower
+ * indices are always started first. Once a thread's own queue is empty, it
+ * steals the highest-indexed task remaining in another thread's queue.
+ */
+class WorkStealingPool final
+{
+  public:
+    using Task = std::function<void (size_t)>;
+
+    /**
+     * Creates a pool which will run tasks on `threadCount` threads (including
+     * the calling thread). A count of zero is treated as one.
+     */
+    explicit WorkStealingPool (size_t threadCount);
+
+    WorkStealingPool (const WorkStealingPool &) = delete;
+    WorkStealingPool &operator= (const WorkStealingPool &) = delete;
+
+    size_t threadCount () const noexcept
+    {
+      return _queues.size();
+    }
+
+    /**
+     * Invokes `task` once for every index in [0, taskCount), returning after
+     * all invocations have finished.
+     *
+     * `task` may be invoked concurrently from multiple threads, and must not
+     * throw.
+     */
+    void run (size_t taskCount, const Task &task);
+
+  private:
+    struct Queue final
+    {
+      public:
+        std::mutex _mutex;
+        std::deque<size_t> _indices;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+
+    /**
+     * Runs tasks from the queue at `queueIndex` until it is empty, then steals
+     * from the other queues until all of them are empty.
+     */
+    void work (size_t queueIndex, const Task &task);
+};
+
+} // namespace Arbiter
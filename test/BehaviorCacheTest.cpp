@@ -0,0 +1,182 @@
+#include "BehaviorCache.h"
+#include "Exception.h"
+#include "Requirement.h"
+
+#include "TestValue.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Arbiter;
+using namespace Resolver;
+using namespace Testing;
+
+namespace {
+
+ArbiterProjectIdentifier makeProjectIdentifier (std::string name)
+{
+  return ArbiterProjectIdentifier(makeSharedUserValue<ArbiterProjectIdentifier, StringTestValue>(std::move(name)));
+}
+
+ArbiterSelectedVersion makeSelectedVersion (Optional<ArbiterSemanticVersion> version, std::string metadata)
+{
+  return ArbiterSelectedVersion(std::move(version), makeSharedUserValue<ArbiterSelectedVersion, StringTestValue>(std::move(metadata)));
+}
+
+ArbiterSelectedVersionList makeVersionList ()
+{
+  std::vector<ArbiterSelectedVersion> versions;
+  versions.emplace_back(makeSelectedVersion(ArbiterSemanticVersion(1, 0, 0), "v1.0.0"));
+  versions.emplace_back(makeSelectedVersion(ArbiterSemanticVersion(2, 0, 0, makeOptional("rc.1"), makeOptional("build")), "v2.0.0-rc.1"));
+  versions.emplace_back(makeSelectedVersion(None(), "master"));
+
+  return ArbiterSelectedVersionList(std::move(versions));
+}
+
+ArbiterDependencyList makeDependencyList ()
+{
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("any"), Requirement::Any());
+  dependencies.emplace_back(makeProjectIdentifier("exact"), Requirement::Exactly(ArbiterSemanticVersion(1, 2, 3)));
+  dependencies.emplace_back(makeProjectIdentifier("branch"), Requirement::Unversioned(makeSharedUserValue<ArbiterSelectedVersion, StringTestValue>("develop")));
+  dependencies.emplace_back(makeProjectIdentifier("compound"), Requirement::Compound({
+    std::make_shared<Requirement::AtLeast>(ArbiterSemanticVersion(0, 1, 0)),
+    std::make_shared<Requirement::CompatibleWith>(ArbiterSemanticVersion(0, 2, 0), ArbiterRequirementStrictnessAllowVersionZeroPatches)
+  }));
+
+  return ArbiterDependencyList(std::move(dependencies));
+}
+
+bool alwaysSatisfied (const ArbiterSelectedVersion *, const void *)
+{
+  return true;
+}
+
+/**
+ * Writes a cache containing the lists above to a temporary file, returning its
+ * path.
+ */
+std::string writeCache (const std::string &name)
+{
+  BehaviorCache::Builder builder;
+  EXPECT_TRUE(builder.addAvailableVersions(makeProjectIdentifier("project"), makeVersionList()));
+  EXPECT_TRUE(builder.addDependencies(makeProjectIdentifier("project"), makeSelectedVersion(ArbiterSemanticVersion(1, 0, 0), "v1.0.0"), makeDependencyList()));
+
+  const std::string path = testing::TempDir() + name;
+  builder.write(path);
+  return path;
+}
+
+} // namespace
+
+TEST(BehaviorCacheTest, RoundTripsLists) {
+  const std::string path = writeCache("arbiter_behavior_cache");
+  BehaviorCache cache(path, &TestValue::deserializeUserValue, &TestValue::deserializeUserValue);
+  EXPECT_EQ(cache.size(), 2);
+
+  auto versionList = cache.availableVersions(makeProjectIdentifier("project"));
+  ASSERT_TRUE(versionList);
+  EXPECT_EQ(versionList->_versions, makeVersionList()._versions);
+
+  auto dependencyList = cache.dependencies(makeProjectIdentifier("project"), makeSelectedVersion(ArbiterSemanticVersion(1, 0, 0), "v1.0.0"));
+  ASSERT_TRUE(dependencyList);
+  EXPECT_EQ(*dependencyList, makeDependencyList());
+
+  EXPECT_FALSE(cache.availableVersions(makeProjectIdentifier("other")));
+  EXPECT_FALSE(cache.dependencies(makeProjectIdentifier("project"), makeSelectedVersion(ArbiterSemanticVersion(2, 0, 0), "v2.0.0")));
+
+  std::remove(path.c_str());
+}
+
+TEST(BehaviorCacheTest, SkipsCustomRequirements) {
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("custom"), Requirement::Custom(&alwaysSatisfied, nullptr));
+
+  BehaviorCache::Builder builder;
+  EXPECT_FALSE(builder.addDependencies(makeProjectIdentifier("project"), makeSelectedVersion(None(), "master"), ArbiterDependencyList(std::move(dependencies))));
+  EXPECT_EQ(builder.size(), 0);
+}
+
+TEST(BehaviorCacheTest, CarriesOverRecords) {
+  const std::string path = writeCache("arbiter_behavior_cache_original");
+  BehaviorCache original(path, &TestValue::deserializeUserValue, &TestValue::deserializeUserValue);
+
+  BehaviorCache::Builder builder;
+  builder.addAvailableVersions(makeProjectIdentifier("project"), ArbiterSelectedVersionList());
+  builder.addRecords(original);
+  EXPECT_EQ(builder.size(), 2);
+
+  // Replace the file which is still mapped.
+  builder.write(path);
+
+  BehaviorCache cache(path, &TestValue::deserializeUserValue, &TestValue::deserializeUserValue);
+  EXPECT_TRUE(cache.availableVersions(makeProjectIdentifier("project"))->_versions.empty());
+  EXPECT_TRUE(cache.dependencies(makeProjectIdentifier("project"), makeSelectedVersion(ArbiterSemanticVersion(1, 0, 0), "v1.0.0")));
+  EXPECT_EQ(original.availableVersions(makeProjectIdentifier("project"))->_versions, makeVersionList()._versions);
+
+  std::remove(path.c_str());
+}
+
+TEST(BehaviorCacheTest, ReplacesFilesConcurrently) {
+  const std::string path = testing::TempDir() + "arbiter_behavior_cache_concurrent";
+
+  // Each writer uses its own temporary file, so the result is always one
+  // complete cache.
+  std::vector<std::thread> writers;
+  for (unsigned i = 0; i < 4; ++i) {
+    writers.emplace_back([] {
+      writeCache("arbiter_behavior_cache_concurrent");
+    });
+  }
+
+  for (std::thread &writer : writers) {
+    writer.join();
+  }
+
+  BehaviorCache cache(path, &TestValue::deserializeUserValue, &TestValue::deserializeUserValue);
+  EXPECT_EQ(cache.availableVersions(makeProjectIdentifier("project"))->_versions, makeVersionList()._versions);
+
+  std::remove(path.c_str());
+
+  EXPECT_THROW(BehaviorCache::Builder().write(testing::TempDir() + "arbiter_missing_directory/cache"), Exception::PersistenceError);
+}
+
+TEST(BehaviorCacheTest, IgnoresDamagedRecords) {
+  const std::string path = writeCache("arbiter_behavior_cache_damaged");
+
+  std::string contents;
+  {
+    std::ifstream file(path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  // Records follow the index in the order of their keys, so the last byte
+  // belongs to the dependency list.
+  std::string damaged = contents;
+  damaged.back() ^= 0x20;
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << damaged;
+
+  {
+    BehaviorCache cache(path, &TestValue::deserializeUserValue, &TestValue::deserializeUserValue);
+    EXPECT_TRUE(cache.availableVersions(makeProjectIdentifier("project")));
+    EXPECT_FALSE(cache.dependencies(makeProjectIdentifier("project"), makeSelectedVersion(ArbiterSemanticVersion(1, 0, 0), "v1.0.0")));
+  }
+
+  // Damage to the index makes the whole file unusable.
+  damaged = contents;
+  damaged[40] ^= 0x20;
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << damaged;
+
+  EXPECT_THROW(BehaviorCache(path, &TestValue::deserializeUserValue, &TestValue::deserializeUserValue), Exception::PersistenceError);
+
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << "arbiter";
+  EXPECT_THROW(BehaviorCache(path, &TestValue::deserializeUserValue, &TestValue::deserializeUserValue), Exception::PersistenceError);
+
+  std::remove(path.c_str());
+  EXPECT_THROW(BehaviorCache(path, &TestValue::deserializeUserValue, &TestValue::deserializeUserValue), Exception::PersistenceError);
+}
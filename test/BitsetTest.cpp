@@ -0,0 +1,60 @@
+#include "Bitset.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using namespace Arbiter;
+
+TEST(BitsetTest, SetsRangesAcrossWords) {
+  Bitset bitset(300);
+  EXPECT_TRUE(bitset.none());
+
+  bitset.setRange(60, 200);
+  EXPECT_FALSE(bitset.none());
+  EXPECT_EQ(bitset.count(), 140);
+
+  EXPECT_FALSE(bitset.test(59));
+  EXPECT_TRUE(bitset.test(60));
+  EXPECT_TRUE(bitset.test(128));
+  EXPECT_TRUE(bitset.test(199));
+  EXPECT_FALSE(bitset.test(200));
+
+  bitset.setRange(5, 5);
+  EXPECT_EQ(bitset.count(), 140);
+}
+
+TEST(BitsetTest, Intersects) {
+  Bitset lhs(600);
+  lhs.setRange(0, 400);
+
+  Bitset rhs(600);
+  rhs.setRange(300, 600);
+  rhs.set(2);
+
+  lhs.intersect(rhs);
+
+  Bitset expected(600);
+  expected.set(2);
+  expected.setRange(300, 400);
+
+  EXPECT_EQ(lhs, expected);
+  EXPECT_EQ(lhs.count(), 101);
+
+  lhs.intersect(Bitset(600));
+  EXPECT_TRUE(lhs.none());
+}
+
+TEST(BitsetTest, VisitsSetBitsInDescendingOrder) {
+  Bitset bitset(130);
+  for (size_t index : { 0, 63, 64, 100, 129 }) {
+    bitset.set(index);
+  }
+
+  std::vector<size_t> visited;
+  bitset.forEachReversed([&](size_t index) {
+    visited.emplace_back(index);
+  });
+
+  EXPECT_EQ(visited, std::vector<size_t>({ 129, 100, 64, 63, 0 }));
+}
@@ -0,0 +1,40 @@
+#include "IntersectionCache.h"
+#include "Requirement.h"
+
+#include "gtest/gtest.h"
+
+using namespace Arbiter;
+using namespace Requirement;
+using namespace Resolver;
+
+TEST(IntersectionCacheTest, SharesIntersections) {
+  IntersectionCache cache;
+
+  auto intersection = cache.intersect(AtLeast(ArbiterSemanticVersion(1, 0, 0)), CompatibleWith(ArbiterSemanticVersion(1, 2, 0), ArbiterRequirementStrictnessStrict));
+  ASSERT_TRUE(intersection);
+  EXPECT_EQ(*intersection, CompatibleWith(ArbiterSemanticVersion(1, 2, 0), ArbiterRequirementStrictnessStrict));
+
+  auto again = cache.intersect(AtLeast(ArbiterSemanticVersion(1, 0, 0)), CompatibleWith(ArbiterSemanticVersion(1, 2, 0), ArbiterRequirementStrictnessStrict));
+  EXPECT_EQ(again, intersection);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(IntersectionCacheTest, CachesMutualExclusion) {
+  IntersectionCache cache;
+
+  EXPECT_FALSE(cache.intersect(Exactly(ArbiterSemanticVersion(1, 0, 0)), Exactly(ArbiterSemanticVersion(2, 0, 0))));
+  EXPECT_FALSE(cache.intersect(Exactly(ArbiterSemanticVersion(1, 0, 0)), Exactly(ArbiterSemanticVersion(2, 0, 0))));
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(IntersectionCacheTest, DistinguishesStrictness) {
+  IntersectionCache cache;
+
+  const CompatibleWith strict(ArbiterSemanticVersion(0, 1, 0), ArbiterRequirementStrictnessStrict);
+  const CompatibleWith loose(ArbiterSemanticVersion(0, 1, 0), ArbiterRequirementStrictnessAllowVersionZeroPatches);
+  const Any any;
+
+  EXPECT_EQ(*cache.intersect(any, strict), strict);
+  EXPECT_EQ(*cache.intersect(any, loose), loose);
+  EXPECT_EQ(cache.size(), 2);
+}
@@ -0,0 +1,71 @@
+#include "PersistentMap.h"
+
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace Arbiter;
+
+TEST(PersistentMapTest, Initializes) {
+  PersistentMap<int, std::string> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_EQ(map.find(0), nullptr);
+  EXPECT_THROW(map.at(0), std::out_of_range);
+}
+
+TEST(PersistentMapTest, InsertsAndReplaces) {
+  PersistentMap<int, std::string> map;
+  EXPECT_TRUE(map.insert(1, "one"));
+  EXPECT_TRUE(map.insert(2, "two"));
+  EXPECT_FALSE(map.insert(1, "uno"));
+
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.at(1), "uno");
+  EXPECT_EQ(map.at(2), "two");
+  EXPECT_EQ(map.find(3), nullptr);
+}
+
+TEST(PersistentMapTest, VisitsEntriesInOrder) {
+  PersistentMap<int, int> map;
+
+  // Insert in an order that exercises every kind of rotation.
+  for (int key : {50, 20, 80, 10, 30, 25, 90, 85, 5, 1, 70, 75, 60, 40, 35}) {
+    map.insert(key, key * 2);
+  }
+
+  std::vector<int> keys;
+  map.forEach([&keys](int key, int value) {
+    EXPECT_EQ(value, key * 2);
+    keys.emplace_back(key);
+  });
+
+  EXPECT_EQ(keys, (std::vector<int>{1, 5, 10, 20, 25, 30, 35, 40, 50, 60, 70, 75, 80, 85, 90}));
+}
+
+TEST(PersistentMapTest, CopiesAreIndependent) {
+  PersistentMap<int, std::string> original;
+  for (int i = 0; i < 100; ++i) {
+    original.insert(i, std::to_string(i));
+  }
+
+  const std::string *shared = original.find(42);
+
+  PersistentMap<int, std::string> copy = original;
+  copy.insert(42, "changed");
+  copy.insert(100, "100");
+
+  EXPECT_EQ(original.size(), 100);
+  EXPECT_EQ(original.at(42), "42");
+  EXPECT_EQ(original.find(100), nullptr);
+  EXPECT_EQ(original.find(42), shared);
+
+  EXPECT_EQ(copy.size(), 101);
+  EXPECT_EQ(copy.at(42), "changed");
+  EXPECT_EQ(copy.at(100), "100");
+
+  // Untouched entries are shared between both maps.
+  EXPECT_EQ(copy.find(7), original.find(7));
+}
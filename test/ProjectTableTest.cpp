@@ -0,0 +1,55 @@
+#include "ProjectTable.h"
+#include "Requirement.h"
+
+#include "TestValue.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+using namespace Arbiter;
+using namespace Resolver;
+using namespace Testing;
+
+namespace {
+
+ArbiterProjectIdentifier makeProjectIdentifier (std::string name)
+{
+  return ArbiterProjectIdentifier(makeSharedUserValue<ArbiterProjectIdentifier, StringTestValue>(std::move(name)));
+}
+
+} // namespace
+
+TEST(ProjectTableTest, InternsEachProjectOnce) {
+  ProjectTable table;
+  EXPECT_EQ(table.size(), 0);
+
+  const ProjectID b = table.intern(makeProjectIdentifier("B"));
+  const ProjectID a = table.intern(makeProjectIdentifier("A"));
+
+  EXPECT_NE(a, b);
+  EXPECT_EQ(table.intern(makeProjectIdentifier("B")), b);
+  EXPECT_EQ(table.size(), 2);
+
+  EXPECT_EQ(table.lookup(a), makeProjectIdentifier("A"));
+  EXPECT_EQ(table.lookup(b), makeProjectIdentifier("B"));
+}
+
+TEST(ProjectTableTest, FindsOnlyInternedProjects) {
+  ProjectTable table;
+  const ProjectID a = table.intern(makeProjectIdentifier("A"));
+
+  EXPECT_EQ(table.find(makeProjectIdentifier("A")), makeOptional(a));
+  EXPECT_FALSE(table.find(makeProjectIdentifier("B")));
+  EXPECT_EQ(table.size(), 1);
+}
+
+TEST(ProjectTableTest, OrdersByIdentifier) {
+  ProjectTable table;
+  const ProjectID b = table.intern(makeProjectIdentifier("B"));
+  const ProjectID a = table.intern(makeProjectIdentifier("A"));
+
+  EXPECT_TRUE(table.lessThan(a, b));
+  EXPECT_FALSE(table.lessThan(b, a));
+  EXPECT_FALSE(table.lessThan(a, a));
+}
@@ -4,6 +4,9 @@
 
 #include "gtest/gtest.h"
 
+#include <thread>
+#include <vector>
+
 using namespace Arbiter;
 using namespace Requirement;
 using namespace Testing;
@@ -53,6 +56,7 @@ TEST(RequirementTest, CompatibleWithRequirement) {
   EXPECT_EQ(req, CompatibleWith(ArbiterSemanticVersion(1, 2, 3), ArbiterRequirementStrictnessStrict));
   EXPECT_NE(req, CompatibleWith(ArbiterSemanticVersion(1, 2, 4), ArbiterRequirementStrictnessStrict));
   EXPECT_NE(req, CompatibleWith(ArbiterSemanticVersion(1, 2, 3, makeOptional("alpha.1")), ArbiterRequirementStrictnessStrict));
+  EXPECT_NE(req, CompatibleWith(ArbiterSemanticVersion(1, 2, 3), ArbiterRequirementStrictnessAllowVersionZeroPatches));
   EXPECT_NE(req, AtLeast(ArbiterSemanticVersion(1, 2, 3)));
   EXPECT_NE(req, Any());
 
@@ -236,3 +240,62 @@ TEST(RequirementTest, ExactlyIntersects) {
     EXPECT_EQ(rhs.intersect(lhs), nullptr);
   }
 }
+
+TEST(RequirementTest, InternsEqualRequirements) {
+  auto strict = CompatibleWith(ArbiterSemanticVersion(1, 2, 0), ArbiterRequirementStrictnessStrict).intern();
+  EXPECT_EQ(strict, CompatibleWith(ArbiterSemanticVersion(1, 2, 0), ArbiterRequirementStrictnessStrict).intern());
+  EXPECT_NE(strict, CompatibleWith(ArbiterSemanticVersion(1, 2, 0), ArbiterRequirementStrictnessAllowVersionZeroPatches).intern());
+  EXPECT_NE(strict, CompatibleWith(ArbiterSemanticVersion(1, 3, 0), ArbiterRequirementStrictnessStrict).intern());
+
+  auto compound = Compound({ strict, Exactly(ArbiterSemanticVersion(1, 2, 3)).intern() }).intern();
+  EXPECT_EQ(compound, Compound({ std::make_shared<CompatibleWith>(ArbiterSemanticVersion(1, 2, 0), ArbiterRequirementStrictnessStrict), std::make_shared<Exactly>(ArbiterSemanticVersion(1, 2, 3)) }).intern());
+
+  // Once released, an equal requirement can be interned again.
+  strict.reset();
+  compound.reset();
+  EXPECT_EQ(*CompatibleWith(ArbiterSemanticVersion(1, 2, 0), ArbiterRequirementStrictnessStrict).intern(), CompatibleWith(ArbiterSemanticVersion(1, 2, 0), ArbiterRequirementStrictnessStrict));
+}
+
+TEST(RequirementTest, InternsConcurrently) {
+  std::vector<std::thread> threads;
+  std::vector<std::shared_ptr<const ArbiterRequirement>> interned(8);
+
+  for (size_t i = 0; i < interned.size(); ++i) {
+    threads.emplace_back([&interned, i] {
+      for (unsigned minor = 0; minor < 200; ++minor) {
+        // Repeatedly create and release requirements, so that interning
+        // races with destruction.
+        AtLeast(ArbiterSemanticVersion(1, minor, 0)).intern();
+      }
+
+      interned[i] = AtLeast(ArbiterSemanticVersion(2, 0, 0)).intern();
+    });
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  for (const auto &requirement : interned) {
+    EXPECT_EQ(requirement, interned.front());
+  }
+}
+
+TEST(RequirementTest, DispatchesOnKind) {
+  const AtLeast atLeast(ArbiterSemanticVersion(1, 0, 0));
+  const Exactly exactly(ArbiterSemanticVersion(1, 0, 0));
+  const ArbiterRequirement &requirement = atLeast;
+
+  EXPECT_EQ(requirement.kind(), Kind::AtLeast);
+  EXPECT_EQ(requirementCast<AtLeast>(requirement), &atLeast);
+  EXPECT_EQ(requirementCast<Exactly>(requirement), nullptr);
+
+  EXPECT_NE(requirement, exactly);
+  EXPECT_NE(requirement, Any());
+  EXPECT_EQ(requirement, AtLeast(ArbiterSemanticVersion(1, 0, 0)));
+
+  // Comparing against other kinds of objects still works.
+  const Arbiter::Base &version = ArbiterSemanticVersion(1, 0, 0);
+  EXPECT_FALSE(requirement == version);
+  EXPECT_EQ(static_cast<const Arbiter::Base &>(requirement), static_cast<const Arbiter::Base &>(atLeast));
+}
@@ -1,4 +1,5 @@
 #include "Dependency.h"
+#include "Exception.h"
 #include "Hash.h"
 #include "Requirement.h"
 #include "Resolver.h"
@@ -10,7 +11,18 @@
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include <poll.h>
 
 using namespace Arbiter;
 using namespace Testing;
@@ -84,6 +96,360 @@ ArbiterDependencyList *createTransitiveDependencyList (const ArbiterResolver *,
   return new ArbiterDependencyList(std::move(dependencies));
 }
 
+ArbiterDependencyList *createConflictingDependencyList (const ArbiterResolver *, const ArbiterProjectIdentifier *project, const ArbiterSelectedVersion *selectedVersion, char **)
+{
+  std::vector<ArbiterDependency> dependencies;
+
+  // The newest version of "A" depends upon a version of "leaf" that does not
+  // exist, which can only be discovered one level deeper in the graph.
+  if (*project == makeProjectIdentifier("A")) {
+    unsigned major = selectedVersion->_semanticVersion->_major;
+    unsigned leafMajor = (major == 3 ? 5 : major);
+
+    dependencies.emplace_back(makeProjectIdentifier("leaf"), Requirement::Exactly(ArbiterSemanticVersion(leafMajor, 0, 0)));
+  }
+
+  return new ArbiterDependencyList(std::move(dependencies));
+}
+
+ArbiterSelectedVersionList *createMajorVersionsListWithNewLeaf (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, char **error)
+{
+  ArbiterSelectedVersionList *versionList = createMajorVersionsList(resolver, project, error);
+
+  if (*project == makeProjectIdentifier("leaf")) {
+    versionList->_versions.emplace_back(ArbiterSemanticVersion(5, 0, 0), makeSharedUserValue<ArbiterSelectedVersion, EmptyTestValue>());
+  }
+
+  return versionList;
+}
+
+ArbiterSelectedVersionList *createTenVersionsList (const ArbiterResolver *, const ArbiterProjectIdentifier *, char **)
+{
+  std::vector<ArbiterSelectedVersion> versions;
+
+  for (unsigned major = 1; major <= 10; ++major) {
+    versions.emplace_back(ArbiterSemanticVersion(major, 0, 0), makeSharedUserValue<ArbiterSelectedVersion, EmptyTestValue>());
+  }
+
+  return new ArbiterSelectedVersionList(std::move(versions));
+}
+
+ArbiterDependencyList *createOldestFirstDependencyList (const ArbiterResolver *, const ArbiterProjectIdentifier *project, const ArbiterSelectedVersion *, char **)
+{
+  std::vector<ArbiterDependency> dependencies;
+
+  // Every version of "Z" requires the oldest version of "P00".
+  if (*project == makeProjectIdentifier("Z")) {
+    dependencies.emplace_back(makeProjectIdentifier("P00"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 0)));
+  }
+
+  return new ArbiterDependencyList(std::move(dependencies));
+}
+
+ArbiterSelectedVersionList *createTenVersionsListWithMajorVersionsX (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, char **error)
+{
+  if (*project == makeProjectIdentifier("X")) {
+    return createMajorVersionsList(resolver, project, error);
+  }
+
+  return createTenVersionsList(resolver, project, error);
+}
+
+ArbiterDependencyList *createWideDependencyList (const ArbiterResolver *, const ArbiterProjectIdentifier *project, const ArbiterSelectedVersion *selectedVersion, char **)
+{
+  std::vector<ArbiterDependency> dependencies;
+
+  // Every version of "A" depends upon many unconstrained projects, and upon
+  // a version of "X" at least as new as itself, which only exists for the
+  // oldest versions of "A".
+  if (*project == makeProjectIdentifier("A")) {
+    for (unsigned i = 0; i < 30; ++i) {
+      std::string name = (i < 10 ? "P0" : "P") + std::to_string(i);
+      dependencies.emplace_back(makeProjectIdentifier(std::move(name)), Requirement::Any());
+    }
+
+    dependencies.emplace_back(makeProjectIdentifier("X"), Requirement::AtLeast(ArbiterSemanticVersion(selectedVersion->_semanticVersion->_major, 0, 0)));
+  }
+
+  return new ArbiterDependencyList(std::move(dependencies));
+}
+
+std::atomic<unsigned> outstandingDependencyLists(0);
+std::atomic<unsigned> maximumOutstandingDependencyLists(0);
+
+ArbiterDependencyList *createSlowTransitiveDependencyList (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, const ArbiterSelectedVersion *selectedVersion, char **error)
+{
+  unsigned outstanding = ++outstandingDependencyLists;
+
+  unsigned maximum = maximumOutstandingDependencyLists.load();
+  while (outstanding > maximum && !maximumOutstandingDependencyLists.compare_exchange_weak(maximum, outstanding));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  --outstandingDependencyLists;
+  return createTransitiveDependencyList(resolver, project, selectedVersion, error);
+}
+
+const unsigned deepChainLength = 5000;
+
+ArbiterProjectIdentifier makeChainProjectIdentifier (unsigned index)
+{
+  return makeProjectIdentifier("chain" + std::to_string(index));
+}
+
+ArbiterDependencyList *createDeepChainDependencyList (const ArbiterResolver *, const ArbiterProjectIdentifier *project, const ArbiterSelectedVersion *, char **)
+{
+  std::vector<ArbiterDependency> dependencies;
+
+  // Each link in the chain depends upon the next, so resolution needs one
+  // level per link.
+  const std::string name = toString(*project);
+  const unsigned index = static_cast<unsigned>(std::stoul(name.substr(name.find_first_of("0123456789"))));
+
+  if (index + 1 < deepChainLength) {
+    dependencies.emplace_back(makeChainProjectIdentifier(index + 1), Requirement::CompatibleWith(ArbiterSemanticVersion(2, 0, 0), ArbiterRequirementStrictnessStrict));
+  }
+
+  return new ArbiterDependencyList(std::move(dependencies));
+}
+
+std::atomic<unsigned> availableVersionsListCount(0);
+
+ArbiterSelectedVersionList *createCountedMajorVersionsList (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, char **error)
+{
+  ++availableVersionsListCount;
+  return createMajorVersionsList(resolver, project, error);
+}
+
+std::atomic<unsigned> projectDescriptionCount(0);
+
+char *createCountedDescription (const void *data)
+{
+  ++projectDescriptionCount;
+  return copyCString(toString(*static_cast<const TestValue *>(data))).release();
+}
+
+/**
+ * Makes a project identifier which counts how many times it is described.
+ */
+ArbiterProjectIdentifier makeCountedProjectIdentifier (std::string name)
+{
+  ArbiterUserValue value = TestValue::convertToUserValue(std::make_unique<StringTestValue>(std::move(name)));
+  value.createDescription = &createCountedDescription;
+
+  return ArbiterProjectIdentifier(SharedUserValue<ArbiterProjectIdentifier>(value));
+}
+
+std::mutex sharedVersionsListMutex;
+std::unordered_map<ArbiterProjectIdentifier, unsigned> sharedVersionsListCounts;
+
+ArbiterSelectedVersionList *createSlowCountedVersionsList (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, char **error)
+{
+  {
+    std::lock_guard<std::mutex> guard(sharedVersionsListMutex);
+    ++sharedVersionsListCounts[*project];
+  }
+
+  // Give other resolvers a chance to ask for the same list in the meantime.
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  return createVariedVersionsList(resolver, project, error);
+}
+
+std::atomic<bool> versionsListShouldFail(false);
+
+ArbiterSelectedVersionList *createSometimesFailingVersionsList (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, char **error)
+{
+  ++availableVersionsListCount;
+
+  if (versionsListShouldFail) {
+    *error = copyCString("version list failure").release();
+    return nullptr;
+  }
+
+  return createMajorVersionsList(resolver, project, error);
+}
+
+ArbiterResolvedDependency makeResolvedDependency (std::string name, unsigned major)
+{
+  return ArbiterResolvedDependency(makeProjectIdentifier(std::move(name)), ArbiterSelectedVersion(ArbiterSemanticVersion(major, 0, 0), makeSharedUserValue<ArbiterSelectedVersion, EmptyTestValue>()));
+}
+
+ArbiterDependencyList *createCancellingDependencyList (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, const ArbiterSelectedVersion *selectedVersion, char **error)
+{
+  ArbiterResolverCancel(const_cast<ArbiterResolver *>(resolver));
+  return createTransitiveDependencyList(resolver, project, selectedVersion, error);
+}
+
+std::vector<ArbiterResolverProgress> reportedProgress;
+
+void recordProgress (const ArbiterResolver *, const ArbiterResolverProgress *progress)
+{
+  reportedProgress.emplace_back(*progress);
+}
+
+ArbiterDependencyList *createCyclicDependencyList (const ArbiterResolver *, const ArbiterProjectIdentifier *project, const ArbiterSelectedVersion *, char **)
+{
+  std::vector<ArbiterDependency> dependencies;
+
+  // "A" -> "B" -> "C" -> "A", with "D" depending upon the cycle.
+  if (*project == makeProjectIdentifier("A")) {
+    dependencies.emplace_back(makeProjectIdentifier("B"), Requirement::Any());
+  } else if (*project == makeProjectIdentifier("B")) {
+    dependencies.emplace_back(makeProjectIdentifier("C"), Requirement::Any());
+  } else if (*project == makeProjectIdentifier("C")) {
+    dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+  } else if (*project == makeProjectIdentifier("D")) {
+    dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+  }
+
+  return new ArbiterDependencyList(std::move(dependencies));
+}
+
+ArbiterDependencyList createConflictingManifest ()
+{
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+  dependencies.emplace_back(makeProjectIdentifier("Z"), Requirement::Any());
+
+  return ArbiterDependencyList(std::move(dependencies));
+}
+
+ArbiterDependencyList *createPinningDependencyList (const ArbiterResolver *, const ArbiterProjectIdentifier *project, const ArbiterSelectedVersion *selectedVersion, char **)
+{
+  std::vector<ArbiterDependency> dependencies;
+
+  // The newest version of "A" only works with the oldest version of "Y".
+  if (*project == makeProjectIdentifier("A") && selectedVersion->_semanticVersion->_major == 3) {
+    dependencies.emplace_back(makeProjectIdentifier("Y"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 0)));
+  }
+
+  return new ArbiterDependencyList(std::move(dependencies));
+}
+
+/**
+ * Returns a manifest depending upon "A" and "Y", with a second requirement
+ * upon "Y" if `excludeOldest` is true.
+ */
+ArbiterDependencyList createPinnedManifest (bool excludeOldest)
+{
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::AtLeast(ArbiterSemanticVersion(1, 0, 0)));
+  dependencies.emplace_back(makeProjectIdentifier("Y"), Requirement::AtLeast(ArbiterSemanticVersion(1, 0, 0)));
+
+  if (excludeOldest) {
+    dependencies.emplace_back(makeProjectIdentifier("Y"), Requirement::AtLeast(ArbiterSemanticVersion(2, 0, 0)));
+  }
+
+  return ArbiterDependencyList(std::move(dependencies));
+}
+
+ArbiterDependencyList *createFailingDependencyList (const ArbiterResolver *, const ArbiterProjectIdentifier *, const ArbiterSelectedVersion *, char **error)
+{
+  *error = copyCString("dependency list failure").release();
+  return nullptr;
+}
+
+ArbiterSelectedVersionList *createFailingAvailableVersionsList (const ArbiterResolver *, const ArbiterProjectIdentifier *, char **error)
+{
+  *error = copyCString("version list failure").release();
+  return nullptr;
+}
+
+/**
+ * Queues up asynchronous requests from a resolver, so that they can be
+ * completed later by the test.
+ */
+struct AsyncRequests final
+{
+  public:
+    struct Request final
+    {
+      public:
+        ArbiterResolverCompletion *_completion;
+        ArbiterProjectIdentifier _project;
+        Optional<ArbiterSelectedVersion> _version;
+    };
+
+    std::mutex _mutex;
+    std::deque<Request> _requests;
+    size_t _maximumOutstanding = 0;
+
+    void add (Request request)
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      _requests.emplace_back(std::move(request));
+      _maximumOutstanding = std::max(_maximumOutstanding, _requests.size());
+    }
+
+    /**
+     * Completes every queued request using the given synchronous behaviors.
+     */
+    void completeAll (const ArbiterResolverBehaviors &behaviors)
+    {
+      std::deque<Request> requests;
+
+      {
+        std::lock_guard<std::mutex> guard(_mutex);
+        std::swap(requests, _requests);
+      }
+
+      for (Request &request : requests) {
+        char *error = nullptr;
+
+        if (request._version) {
+          ArbiterDependencyList *dependencyList = behaviors.createDependencyList(nullptr, &request._project, request._version.pointer(), &error);
+          ArbiterResolverCompleteDependencyList(request._completion, dependencyList, error);
+        } else {
+          ArbiterSelectedVersionList *versionList = behaviors.createAvailableVersionsList(nullptr, &request._project, &error);
+          ArbiterResolverCompleteAvailableVersionsList(request._completion, versionList, error);
+        }
+      }
+    }
+};
+
+void requestDependencyListLater (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, const ArbiterSelectedVersion *selectedVersion, ArbiterResolverCompletion *completion)
+{
+  auto requests = static_cast<AsyncRequests *>(const_cast<void *>(ArbiterResolverContext(resolver)));
+  requests->add(AsyncRequests::Request{completion, *project, makeOptional(*selectedVersion)});
+}
+
+void requestAvailableVersionsListLater (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, ArbiterResolverCompletion *completion)
+{
+  auto requests = static_cast<AsyncRequests *>(const_cast<void *>(ArbiterResolverContext(resolver)));
+  requests->add(AsyncRequests::Request{completion, *project, None()});
+}
+
+void requestEmptyDependencyListImmediately (const ArbiterResolver *, const ArbiterProjectIdentifier *, const ArbiterSelectedVersion *, ArbiterResolverCompletion *completion)
+{
+  ArbiterResolverCompleteDependencyList(completion, new ArbiterDependencyList(), nullptr);
+}
+
+void requestMajorVersionsListImmediately (const ArbiterResolver *resolver, const ArbiterProjectIdentifier *project, ArbiterResolverCompletion *completion)
+{
+  ArbiterResolverCompleteAvailableVersionsList(completion, createMajorVersionsList(resolver, project, nullptr), nullptr);
+}
+
+/**
+ * Drives a resolver started with ArbiterResolverStartResolving() by
+ * completing its requests whenever it is waiting for them, until it has
+ * finished.
+ */
+ArbiterResolvedDependencyGraph *runAsyncResolver (ArbiterResolver *resolver, AsyncRequests &requests, const ArbiterResolverBehaviors &syncBehaviors, char **error)
+{
+  if (!ArbiterResolverStartResolving(resolver, error)) {
+    return nullptr;
+  }
+
+  pollfd descriptor{ArbiterResolverEventFileDescriptor(resolver), POLLIN, 0};
+
+  while (poll(&descriptor, 1, 10) == 0) {
+    requests.completeAll(syncBehaviors);
+  }
+
+  return ArbiterResolverFinishResolving(resolver, error);
+}
+
 const ArbiterResolvedDependency &findResolved (const ArbiterResolvedDependencyGraph &graph, size_t depthIndex, const std::string &name)
 {
   ArbiterProjectIdentifier identifier = makeProjectIdentifier(name);
@@ -103,7 +469,7 @@ const ArbiterResolvedDependency &findResolved (const ArbiterResolvedDependencyGr
 } // namespace
 
 TEST(ResolverTest, ResolvesEmptyDependencies) {
-  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createEmptyAvailableVersionsList, nullptr};
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createEmptyAvailableVersionsList, nullptr, nullptr, nullptr};
 
   ArbiterResolver resolver(behaviors, ArbiterDependencyList(), nullptr);
 
@@ -114,7 +480,7 @@ TEST(ResolverTest, ResolvesEmptyDependencies) {
 }
 
 TEST(ResolverTest, ResolvesOneDependency) {
-  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createMajorVersionsList, nullptr};
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
 
   std::vector<ArbiterDependency> dependencies;
   dependencies.emplace_back(emptyProjectIdentifier(), Requirement::AtLeast(ArbiterSemanticVersion(2, 0, 0)));
@@ -130,7 +496,7 @@ TEST(ResolverTest, ResolvesOneDependency) {
 
 TEST(ResolverTest, ResolvesMultipleDependencies)
 {
-  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createMajorVersionsList, nullptr};
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
 
   std::vector<ArbiterDependency> dependencies;
   dependencies.emplace_back(makeProjectIdentifier("B"), Requirement::CompatibleWith(ArbiterSemanticVersion(2, 0, 0), ArbiterRequirementStrictnessStrict));
@@ -149,7 +515,7 @@ TEST(ResolverTest, ResolvesMultipleDependencies)
 
 TEST(ResolverTest, ResolvesTransitiveDependencies)
 {
-  ArbiterResolverBehaviors behaviors{&createTransitiveDependencyList, &createVariedVersionsList, nullptr};
+  ArbiterResolverBehaviors behaviors{&createTransitiveDependencyList, &createVariedVersionsList, nullptr, nullptr, nullptr};
 
   std::vector<ArbiterDependency> dependencies;
   dependencies.emplace_back(makeProjectIdentifier("ancestor"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 1, makeOptional("alpha"))));
@@ -168,19 +534,1042 @@ TEST(ResolverTest, ResolvesTransitiveDependencies)
   EXPECT_EQ(findResolved(resolved, 0, "leaf_dailybuild")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 1, 0, None(), makeOptional("dailybuild"))));
 }
 
-#if 0
-TEST(ResolverTest, FailsWhenNoAvailableVersions)
-{}
+TEST(ResolverTest, LearnsIncompatibilitiesFromConflicts)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
 
-TEST(ResolverTest, FailsWhenNoSatisfyingVersions)
-{}
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+  dependencies.emplace_back(makeProjectIdentifier("Z"), Requirement::Any());
 
-TEST(ResolverTest, FailsWithMutuallyExclusiveRequirements)
-{}
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
 
-TEST(ResolverTest, RethrowsUserDependencyListErrors)
-{}
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  ASSERT_EQ(resolved.depth(), 2);
+  EXPECT_EQ(resolved.count(), 3);
+  EXPECT_EQ(findResolved(resolved, 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "Z")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "leaf")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
 
-TEST(ResolverTest, RethrowsUserVersionListErrors)
-{}
-#endif
+  // Only A @ 3.0.0 was to blame, regardless of the version chosen for Z.
+  EXPECT_EQ(resolver._incompatibilities.count(), 1);
+}
+
+TEST(ResolverTest, BlamesEveryRootRequirementUponAProject)
+{
+  ArbiterResolverBehaviors behaviors{&createPinningDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  ArbiterResolver resolver(behaviors, createPinnedManifest(true), nullptr);
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  EXPECT_EQ(findResolved(resolved, 0, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "Y")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+
+  const Resolver::ProjectID a = resolver._projects.intern(makeProjectIdentifier("A"));
+  const Resolver::ProjectID y = resolver._projects.intern(makeProjectIdentifier("Y"));
+
+  const auto &incompatibilities = resolver._incompatibilities.incompatibilities();
+  const auto it = std::find_if(incompatibilities.begin(), incompatibilities.end(), [&](const Resolver::Incompatibility &incompatibility) {
+    return incompatibility.involves(a);
+  });
+
+  // A @ 3.0.0 only conflicts with both of the root requirements upon Y.
+  ASSERT_NE(it, incompatibilities.end());
+  ASSERT_EQ(it->_rootRequirements.count(y), 1);
+  EXPECT_EQ(it->_rootRequirements.at(y).size(), 2);
+
+  // They are shared with the dependencies which introduced them.
+  for (const auto &requirement : it->_rootRequirements.at(y)) {
+    EXPECT_EQ(requirement, requirement->intern());
+  }
+}
+
+TEST(ResolverTest, KeepsPreviouslyResolvedVersions)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createCountedMajorVersionsList, nullptr, nullptr, nullptr};
+
+  ArbiterResolvedDependencyGraph previous;
+  previous._depths.emplace_back();
+  previous._depths[0].emplace(makeResolvedDependency("A", 2));
+  previous._depths[0].emplace(makeResolvedDependency("B", 1));
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+  dependencies.emplace_back(makeProjectIdentifier("B"), Requirement::AtLeast(ArbiterSemanticVersion(1, 0, 0)));
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  ArbiterResolverSetPreviousResolvedDependencyGraph(&resolver, &previous);
+
+  availableVersionsListCount = 0;
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  EXPECT_EQ(resolved, previous);
+  EXPECT_EQ(availableVersionsListCount, 0);
+}
+
+TEST(ResolverTest, ReopensOnlyProjectsWithChangedRequirements)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createCountedMajorVersionsList, nullptr, nullptr, nullptr};
+
+  ArbiterResolvedDependencyGraph previous;
+  previous._depths.emplace_back();
+  previous._depths[0].emplace(makeResolvedDependency("A", 2));
+  previous._depths[0].emplace(makeResolvedDependency("B", 1));
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::AtLeast(ArbiterSemanticVersion(3, 0, 0)));
+  dependencies.emplace_back(makeProjectIdentifier("B"), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  ArbiterResolverSetPreviousResolvedDependencyGraph(&resolver, &previous);
+
+  availableVersionsListCount = 0;
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  EXPECT_EQ(findResolved(resolved, 0, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "B")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(1, 0, 0)));
+  EXPECT_EQ(availableVersionsListCount, 1);
+}
+
+TEST(ResolverTest, ReconsidersPreferredVersionsWhichConflict)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  // A @ 3.0.0 depends upon a version of "leaf" which does not exist, and
+  // the preferred version of "leaf" does not satisfy it either.
+  const ArbiterResolvedDependency a = makeResolvedDependency("A", 3);
+  const ArbiterResolvedDependency z = makeResolvedDependency("Z", 1);
+  const ArbiterResolvedDependency leaf = makeResolvedDependency("leaf", 3);
+  const ArbiterResolvedDependency *preferred[] = {&a, &z, &leaf};
+
+  ArbiterResolver resolver(behaviors, createConflictingManifest(), nullptr);
+  ArbiterResolverSetPreferredVersions(&resolver, preferred, 3);
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  EXPECT_EQ(findResolved(resolved, 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "Z")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(1, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "leaf")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+}
+
+TEST(ResolverTest, VerifiesSatisfiedGraphs)
+{
+  ArbiterResolverBehaviors behaviors{&createTransitiveDependencyList, &createVariedVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("ancestor"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 1, makeOptional("alpha"))));
+  dependencies.emplace_back(makeProjectIdentifier("parent"), Requirement::CompatibleWith(ArbiterSemanticVersion(1, 2, 3), ArbiterRequirementStrictnessStrict));
+
+  ArbiterResolver original(behaviors, ArbiterDependencyList(dependencies), nullptr);
+  ArbiterResolvedDependencyGraph resolved = original.resolve();
+
+  // Projects which nothing depends upon should be dropped.
+  ArbiterResolvedDependencyGraph proposed = resolved;
+  proposed._depths[0].emplace(makeResolvedDependency("unused", 1));
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+
+  ArbiterResolverViolationList *violations = nullptr;
+  char *error = nullptr;
+
+  std::unique_ptr<ArbiterResolvedDependencyGraph> verified(ArbiterResolverCreateVerifiedDependencyGraph(&resolver, &proposed, &violations, &error));
+  ASSERT_NE(verified, nullptr);
+  EXPECT_EQ(*verified, resolved);
+  EXPECT_EQ(violations, nullptr);
+  EXPECT_EQ(error, nullptr);
+}
+
+TEST(ResolverTest, ReportsViolatedRequirements)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  // A @ 2.0.0 requires leaf @ 2.0.0, and Z is missing entirely.
+  ArbiterResolvedDependencyGraph proposed;
+  proposed._depths.emplace_back();
+  proposed._depths[0].emplace(makeResolvedDependency("leaf", 1));
+  proposed._depths.emplace_back();
+  proposed._depths[1].emplace(makeResolvedDependency("A", 2));
+
+  ArbiterResolver resolver(behaviors, createConflictingManifest(), nullptr);
+
+  ArbiterResolverViolationList *violations = nullptr;
+  char *error = nullptr;
+
+  EXPECT_EQ(ArbiterResolverCreateVerifiedDependencyGraph(&resolver, &proposed, &violations, &error), nullptr);
+  EXPECT_EQ(error, nullptr);
+  ASSERT_NE(violations, nullptr);
+  ASSERT_EQ(ArbiterResolverViolationListCount(violations), 2);
+
+  const ArbiterResolverViolation *missing = ArbiterResolverViolationListGet(violations, 0);
+  EXPECT_EQ(ArbiterResolverViolationDependent(missing), nullptr);
+  EXPECT_EQ(ArbiterResolverViolationDependency(missing)->_projectIdentifier, makeProjectIdentifier("Z"));
+  EXPECT_EQ(ArbiterResolverViolationSelectedVersion(missing), nullptr);
+
+  const ArbiterResolverViolation *unsatisfied = ArbiterResolverViolationListGet(violations, 1);
+  ASSERT_NE(ArbiterResolverViolationDependent(unsatisfied), nullptr);
+  EXPECT_EQ(*ArbiterResolverViolationDependent(unsatisfied), makeResolvedDependency("A", 2));
+  EXPECT_EQ(ArbiterResolverViolationDependency(unsatisfied)->_projectIdentifier, makeProjectIdentifier("leaf"));
+  ASSERT_NE(ArbiterResolverViolationSelectedVersion(unsatisfied), nullptr);
+  EXPECT_EQ(ArbiterResolverViolationSelectedVersion(unsatisfied)->_semanticVersion, makeOptional(ArbiterSemanticVersion(1, 0, 0)));
+
+  ArbiterFree(violations);
+}
+
+TEST(ResolverTest, ReusesArchivedIncompatibilities)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  ArbiterResolver original(behaviors, createConflictingManifest(), nullptr);
+  original.resolve();
+
+  std::stringstream stream;
+  original.archiveIncompatibilities().write(stream);
+
+  Resolver::IncompatibilityArchive archive = Resolver::IncompatibilityArchive::read(stream);
+  ASSERT_EQ(archive._entries.size(), 1);
+
+  ArbiterResolver resolver(behaviors, createConflictingManifest(), nullptr);
+  resolver.unarchiveIncompatibilities(archive);
+
+  // Nothing can be verified until the relevant projects have been fetched.
+  EXPECT_EQ(resolver._incompatibilities.count(), 0);
+  EXPECT_EQ(resolver.archiveIncompatibilities()._entries.size(), 1);
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  EXPECT_EQ(findResolved(resolved, 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "Z")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "leaf")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+
+  EXPECT_EQ(resolver._incompatibilities.count(), 1);
+  EXPECT_EQ(resolver.staleIncompatibilityCount(), 0);
+  EXPECT_EQ(resolver.archiveIncompatibilities()._entries.size(), 1);
+}
+
+TEST(ResolverTest, DiscardsStaleArchivedIncompatibilities)
+{
+  ArbiterResolverBehaviors originalBehaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  ArbiterResolver original(originalBehaviors, createConflictingManifest(), nullptr);
+  original.resolve();
+
+  // A version of "leaf" which satisfies A @ 3.0.0 has since been published.
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsListWithNewLeaf, nullptr, nullptr, nullptr};
+
+  ArbiterResolver resolver(behaviors, createConflictingManifest(), nullptr);
+  resolver.unarchiveIncompatibilities(original.archiveIncompatibilities());
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  EXPECT_EQ(findResolved(resolved, 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "leaf")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(5, 0, 0)));
+
+  EXPECT_EQ(resolver._incompatibilities.count(), 0);
+  EXPECT_EQ(resolver.staleIncompatibilityCount(), 1);
+}
+
+TEST(ResolverTest, SavesEveryRootRequirementUponAProject)
+{
+  ArbiterResolverBehaviors behaviors{&createPinningDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+  const std::string path = testing::TempDir() + "arbiter_root_incompatibilities";
+
+  ArbiterResolver original(behaviors, createPinnedManifest(true), nullptr);
+  original.resolve();
+
+  const Resolver::IncompatibilityArchive archive = original.archiveIncompatibilities();
+  ASSERT_EQ(archive._entries.size(), 1);
+  EXPECT_EQ(archive._entries[0]._rootRequirements.size(), 2);
+
+  char *error = nullptr;
+  ASSERT_TRUE(ArbiterResolverSaveIncompatibilities(&original, path.c_str(), &error));
+  EXPECT_EQ(error, nullptr);
+
+  // Without the second requirement upon Y, A @ 3.0.0 works after all.
+  ArbiterResolver unpinned(behaviors, createPinnedManifest(false), nullptr);
+  ASSERT_TRUE(ArbiterResolverLoadIncompatibilities(&unpinned, path.c_str(), &error));
+  EXPECT_EQ(error, nullptr);
+
+  ArbiterResolvedDependencyGraph resolved = unpinned.resolve();
+  EXPECT_EQ(resolved, ArbiterResolver(behaviors, createPinnedManifest(false), nullptr).resolve());
+  EXPECT_EQ(findResolved(resolved, 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "Y")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(1, 0, 0)));
+
+  ArbiterResolver pinned(behaviors, createPinnedManifest(true), nullptr);
+  ASSERT_TRUE(ArbiterResolverLoadIncompatibilities(&pinned, path.c_str(), &error));
+  EXPECT_EQ(error, nullptr);
+
+  EXPECT_EQ(pinned.resolve(), original.resolve());
+  EXPECT_EQ(pinned.staleIncompatibilityCount(), 0);
+
+  std::remove(path.c_str());
+}
+
+TEST(ResolverTest, IgnoresArchivedIncompatibilitiesFromOtherManifests)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  ArbiterResolver original(behaviors, createConflictingManifest(), nullptr);
+  original.resolve();
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::AtLeast(ArbiterSemanticVersion(1, 0, 0)));
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  resolver.unarchiveIncompatibilities(original.archiveIncompatibilities());
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  EXPECT_EQ(findResolved(resolved, 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+  EXPECT_EQ(resolver.staleIncompatibilityCount(), 0);
+}
+
+TEST(ResolverTest, SavesAndLoadsIncompatibilities)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+  const std::string path = testing::TempDir() + "arbiter_incompatibilities";
+
+  ArbiterResolver original(behaviors, createConflictingManifest(), nullptr);
+  original.resolve();
+
+  char *error = nullptr;
+  ASSERT_TRUE(ArbiterResolverSaveIncompatibilities(&original, path.c_str(), &error));
+  EXPECT_EQ(error, nullptr);
+
+  ArbiterResolver resolver(behaviors, createConflictingManifest(), nullptr);
+  ASSERT_TRUE(ArbiterResolverLoadIncompatibilities(&resolver, path.c_str(), &error));
+  EXPECT_EQ(error, nullptr);
+
+  resolver.resolve();
+  EXPECT_EQ(resolver._incompatibilities.count(), 1);
+  EXPECT_EQ(resolver.staleIncompatibilityCount(), 0);
+
+  std::remove(path.c_str());
+}
+
+TEST(ResolverTest, ResolvesFromBehaviorCache)
+{
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("ancestor"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 1, makeOptional("alpha"))));
+  dependencies.emplace_back(makeProjectIdentifier("parent"), Requirement::CompatibleWith(ArbiterSemanticVersion(1, 2, 3), ArbiterRequirementStrictnessStrict));
+
+  const ArbiterDependencyList dependencyList(std::move(dependencies));
+  const std::string path = testing::TempDir() + "arbiter_resolver_behavior_cache";
+
+  ArbiterResolverBehaviors behaviors{&createTransitiveDependencyList, &createVariedVersionsList, nullptr, nullptr, nullptr};
+  ArbiterResolver original(behaviors, dependencyList, nullptr);
+  ArbiterResolvedDependencyGraph expected = original.resolve();
+
+  char *error = nullptr;
+  ASSERT_TRUE(ArbiterResolverSaveBehaviorCache(&original, path.c_str(), &error));
+  EXPECT_EQ(error, nullptr);
+
+  // Every list must come from the cache, since the behaviors always fail.
+  ArbiterResolverBehaviors failingBehaviors{&createFailingDependencyList, &createFailingAvailableVersionsList, nullptr, nullptr, nullptr};
+  ArbiterResolver resolver(failingBehaviors, dependencyList, nullptr);
+
+  ASSERT_TRUE(ArbiterResolverLoadBehaviorCache(&resolver, path.c_str(), &TestValue::deserializeUserValue, &TestValue::deserializeUserValue, &error));
+  EXPECT_EQ(error, nullptr);
+  EXPECT_EQ(resolver.resolve(), expected);
+
+  std::remove(path.c_str());
+}
+
+TEST(ResolverTest, FailsToLoadMissingIncompatibilities)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createEmptyAvailableVersionsList, nullptr, nullptr, nullptr};
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(), nullptr);
+
+  const std::string path = testing::TempDir() + "arbiter_nonexistent_incompatibilities";
+
+  char *error = nullptr;
+  EXPECT_FALSE(ArbiterResolverLoadIncompatibilities(&resolver, path.c_str(), &error));
+  EXPECT_NE(error, nullptr);
+
+  delete[] error;
+}
+
+TEST(ResolverTest, RejectsMalformedIncompatibilityArchives)
+{
+  std::istringstream truncated("arbiter-incompatibilities 1\nprojects 2\nproject 0000000000000000 A\n");
+  EXPECT_THROW(Resolver::IncompatibilityArchive::read(truncated), Exception::PersistenceError);
+
+  std::istringstream wrongVersion("arbiter-incompatibilities 999\nprojects 0\nentries 0\n");
+  EXPECT_THROW(Resolver::IncompatibilityArchive::read(wrongVersion), Exception::PersistenceError);
+
+  std::istringstream badIndex("arbiter-incompatibilities 1\nprojects 0\nentries 1\nentry 1 0 0\nselection 3 - 1.0.0\n");
+  EXPECT_THROW(Resolver::IncompatibilityArchive::read(badIndex), Exception::PersistenceError);
+}
+
+TEST(ResolverTest, RevisitsOnlyConflictingDecisions)
+{
+  ArbiterResolverBehaviors behaviors{&createOldestFirstDependencyList, &createTenVersionsList, nullptr, nullptr, nullptr};
+
+  // Trying every combination of these projects would take 10^30 attempts.
+  std::vector<ArbiterDependency> dependencies;
+  for (unsigned i = 0; i < 30; ++i) {
+    std::string name = (i < 10 ? "P0" : "P") + std::to_string(i);
+    dependencies.emplace_back(makeProjectIdentifier(std::move(name)), Requirement::Any());
+  }
+
+  dependencies.emplace_back(makeProjectIdentifier("Z"), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  ASSERT_EQ(resolved.depth(), 2);
+  EXPECT_EQ(resolved.count(), 31);
+  EXPECT_EQ(findResolved(resolved, 0, "P00")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(1, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "P29")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(10, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 1, "Z")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(10, 0, 0)));
+}
+
+TEST(ResolverTest, ResolvesDeepDependencyChains)
+{
+  ArbiterResolverBehaviors behaviors{&createDeepChainDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeChainProjectIdentifier(0), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  ASSERT_EQ(resolved.depth(), deepChainLength);
+  EXPECT_EQ(findResolved(resolved, deepChainLength - 1, "chain0")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "chain" + std::to_string(deepChainLength - 1))._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+}
+
+TEST(ResolverTest, StopsAfterCandidateLimit)
+{
+  ArbiterResolverBehaviors behaviors{&createOldestFirstDependencyList, &createTenVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("P00"), Requirement::Any());
+  dependencies.emplace_back(makeProjectIdentifier("Z"), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  ArbiterResolverSetCandidateLimit(&resolver, 5);
+
+  EXPECT_THROW(resolver.resolve(), Exception::LimitExceeded);
+
+  char *error = nullptr;
+  EXPECT_EQ(ArbiterResolverCreateResolvedDependencyGraph(&resolver, &error), nullptr);
+  ASSERT_NE(error, nullptr);
+  EXPECT_NE(std::strstr(error, "limit"), nullptr);
+
+  delete[] error;
+}
+
+TEST(ResolverTest, StopsAfterTimeLimit)
+{
+  ArbiterResolverBehaviors behaviors{&createSlowTransitiveDependencyList, &createVariedVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("ancestor"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 1, makeOptional("alpha"))));
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  ArbiterResolverSetTimeLimit(&resolver, 0.001);
+
+  EXPECT_THROW(resolver.resolve(), Exception::LimitExceeded);
+}
+
+TEST(ResolverTest, StopsWhenCancelled)
+{
+  ArbiterResolverBehaviors behaviors{&createCancellingDependencyList, &createVariedVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("ancestor"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 1, makeOptional("alpha"))));
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  EXPECT_THROW(resolver.resolve(), Exception::Cancelled);
+
+  // Cancellation also applies to any later resolution.
+  EXPECT_TRUE(resolver.cancelled());
+  EXPECT_THROW(resolver.resolve(), Exception::Cancelled);
+}
+
+TEST(ResolverTest, ReportsProgress)
+{
+  ArbiterResolverBehaviors behaviors{&createOldestFirstDependencyList, &createTenVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("P00"), Requirement::Any());
+  dependencies.emplace_back(makeProjectIdentifier("Z"), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  ArbiterResolverSetProgressCallback(&resolver, &recordProgress, 0);
+
+  reportedProgress.clear();
+  resolver.resolve();
+
+  // Every candidate should be reported, since the interval is zero.
+  ASSERT_FALSE(reportedProgress.empty());
+  for (size_t i = 0; i < reportedProgress.size(); ++i) {
+    EXPECT_EQ(reportedProgress[i].candidates, i + 1);
+    EXPECT_GE(reportedProgress[i].depth, 1);
+    EXPECT_GE(reportedProgress[i].decisions, 1);
+  }
+
+  // P00 has to be walked back from its newest version to its oldest.
+  EXPECT_GE(reportedProgress.back().backtracks, 9);
+}
+
+TEST(ResolverTest, DecidesMostConstrainedProjectsFirst)
+{
+  ArbiterResolverBehaviors behaviors{&createWideDependencyList, &createTenVersionsListWithMajorVersionsX, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(dependencies), nullptr);
+  ArbiterResolverSetProgressCallback(&resolver, &recordProgress, 0);
+
+  reportedProgress.clear();
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  EXPECT_EQ(findResolved(resolved, 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "X")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+
+  // Deciding "X" first means that each bad version of "A" is rejected
+  // without deciding any of its other dependencies.
+  const size_t constrainedCandidates = reportedProgress.size();
+  EXPECT_LT(constrainedCandidates, 50);
+
+  ArbiterResolver unordered(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  ArbiterResolverSetDecisionOrdering(&unordered, ArbiterResolverDecisionOrderingByIdentifier);
+  ArbiterResolverSetProgressCallback(&unordered, &recordProgress, 0);
+
+  reportedProgress.clear();
+  EXPECT_EQ(unordered.resolve(), resolved);
+  EXPECT_GT(reportedProgress.size(), constrainedCandidates * 4);
+}
+
+TEST(ResolverTest, ReportsDependencyCycles)
+{
+  ArbiterResolverBehaviors behaviors{&createCyclicDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("D"), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+
+  char *error = nullptr;
+  EXPECT_EQ(ArbiterResolverCreateResolvedDependencyGraph(&resolver, &error), nullptr);
+  ASSERT_NE(error, nullptr);
+
+  // Only the projects actually in the cycle should be named.
+  const std::string message(error);
+  EXPECT_NE(message.find("cycle"), std::string::npos);
+  EXPECT_NE(message.find("(A) @ 3.0.0"), std::string::npos);
+  EXPECT_NE(message.find("(B) @ 3.0.0"), std::string::npos);
+  EXPECT_NE(message.find("(C) @ 3.0.0"), std::string::npos);
+  EXPECT_EQ(message.find("(D)"), std::string::npos);
+
+  delete[] error;
+}
+
+TEST(ResolverTest, ResolvesInParallelDeterministically)
+{
+  ArbiterResolverBehaviors behaviors{&createOldestFirstDependencyList, &createTenVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  for (unsigned i = 0; i < 10; ++i) {
+    dependencies.emplace_back(makeProjectIdentifier("P0" + std::to_string(i)), Requirement::AtLeast(ArbiterSemanticVersion(i % 3 + 1, 0, 0)));
+  }
+
+  dependencies.emplace_back(makeProjectIdentifier("Z"), Requirement::Any());
+
+  const ArbiterDependencyList dependencyList(std::move(dependencies));
+
+  ArbiterResolver sequential(behaviors, dependencyList, nullptr);
+  ArbiterResolvedDependencyGraph expected = sequential.resolve();
+
+  for (size_t threadCount : {2, 3, 8}) {
+    ArbiterResolver resolver(behaviors, dependencyList, nullptr);
+    ArbiterResolverSetThreadCount(&resolver, threadCount);
+
+    EXPECT_EQ(resolver.resolve(), expected);
+  }
+}
+
+TEST(ResolverTest, ResolvesTransitiveDependenciesInParallel)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  ArbiterResolver resolver(behaviors, createConflictingManifest(), nullptr);
+  ArbiterResolverSetThreadCount(&resolver, 4);
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  ASSERT_EQ(resolved.depth(), 2);
+  EXPECT_EQ(findResolved(resolved, 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "Z")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(findResolved(resolved, 0, "leaf")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+}
+
+TEST(ResolverTest, FailsInParallel)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+  dependencies.emplace_back(makeProjectIdentifier("leaf"), Requirement::Exactly(ArbiterSemanticVersion(5, 0, 0)));
+  const ArbiterDependencyList dependencyList(std::move(dependencies));
+
+  const auto resolveError = [&](size_t threadCount) -> std::string {
+    ArbiterResolver resolver(behaviors, dependencyList, nullptr);
+    ArbiterResolverSetThreadCount(&resolver, threadCount);
+
+    try {
+      resolver.resolve();
+    } catch (const Exception::UnsatisfiableConstraints &ex) {
+      return ex.what();
+    }
+
+    ADD_FAILURE() << "Expected resolution to fail";
+    return "";
+  };
+
+  const std::string sequentialError = resolveError(1);
+  EXPECT_FALSE(sequentialError.empty());
+
+  // The error must not depend upon how the subtrees happened to be scheduled.
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(sequentialError, resolveError(4));
+  }
+}
+
+TEST(ResolverTest, ResolvesManyDependencyListsTogether)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createCountedMajorVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependencyList> roots;
+  roots.emplace_back(createConflictingManifest());
+
+  {
+    std::vector<ArbiterDependency> dependencies;
+    dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+    dependencies.emplace_back(makeProjectIdentifier("leaf"), Requirement::Exactly(ArbiterSemanticVersion(5, 0, 0)));
+    roots.emplace_back(std::move(dependencies));
+  }
+
+  {
+    std::vector<ArbiterDependency> dependencies;
+    dependencies.emplace_back(makeProjectIdentifier("leaf"), Requirement::AtLeast(ArbiterSemanticVersion(1, 0, 0)));
+    roots.emplace_back(std::move(dependencies));
+  }
+
+  std::vector<const ArbiterDependencyList *> rootPointers;
+  for (const ArbiterDependencyList &root : roots) {
+    rootPointers.emplace_back(&root);
+  }
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(), nullptr);
+  ArbiterResolverSetThreadCount(&resolver, 4);
+
+  availableVersionsListCount = 0;
+
+  std::vector<ArbiterResolvedDependencyGraph *> graphs(roots.size());
+  std::vector<char *> errors(roots.size());
+  EXPECT_EQ(ArbiterResolverCreateResolvedDependencyGraphs(&resolver, rootPointers.data(), roots.size(), graphs.data(), errors.data()), 2);
+
+  // Each project's versions were only fetched once between all of the roots.
+  EXPECT_EQ(availableVersionsListCount, 3);
+
+  for (size_t i = 0; i < roots.size(); ++i) {
+    ArbiterResolver solo(behaviors, roots[i], nullptr);
+
+    if (i == 1) {
+      EXPECT_EQ(graphs[i], nullptr);
+      ASSERT_NE(errors[i], nullptr);
+      EXPECT_THROW(solo.resolve(), Exception::UnsatisfiableConstraints);
+    } else {
+      ASSERT_NE(graphs[i], nullptr);
+      EXPECT_EQ(errors[i], nullptr);
+      EXPECT_EQ(*graphs[i], solo.resolve());
+    }
+
+    ArbiterFree(graphs[i]);
+    delete[] errors[i];
+  }
+}
+
+TEST(ResolverTest, ReusesIncompatibilitiesOnlyWithTheSameRoots)
+{
+  ArbiterResolverBehaviors behaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  // Every version of "A" but the oldest conflicts with this root requirement
+  // upon "leaf", which must not be held against the next root.
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+  dependencies.emplace_back(makeProjectIdentifier("leaf"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 0)));
+  const ArbiterDependencyList pinned(std::move(dependencies));
+
+  const ArbiterDependencyList unpinned = createConflictingManifest();
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(), nullptr);
+
+  std::vector<std::exception_ptr> errors;
+  std::vector<Optional<ArbiterResolvedDependencyGraph>> resolved = resolver.resolveAll({ &pinned, &unpinned }, errors);
+  ASSERT_EQ(resolved.size(), 2);
+  EXPECT_EQ(errors[0], nullptr);
+  EXPECT_EQ(errors[1], nullptr);
+
+  ASSERT_TRUE(resolved[0]);
+  EXPECT_EQ(findResolved(*resolved[0], 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(1, 0, 0)));
+
+  ASSERT_TRUE(resolved[1]);
+  EXPECT_EQ(*resolved[1], ArbiterResolver(behaviors, unpinned, nullptr).resolve());
+  EXPECT_EQ(findResolved(*resolved[1], 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+}
+
+TEST(ResolverTest, ResolvesEachDependencyListAsIfAlone)
+{
+  ArbiterResolverBehaviors behaviors{&createPinningDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  const ArbiterDependencyList pinned = createPinnedManifest(true);
+  const ArbiterDependencyList unpinned = createPinnedManifest(false);
+
+  for (size_t threadCount : { 1, 4 }) {
+    ArbiterResolver resolver(behaviors, ArbiterDependencyList(), nullptr);
+    ArbiterResolverSetThreadCount(&resolver, threadCount);
+
+    // Resolving the same lists again should not be affected by anything
+    // learned the first time around.
+    std::vector<std::exception_ptr> errors;
+    std::vector<Optional<ArbiterResolvedDependencyGraph>> resolved = resolver.resolveAll({ &pinned, &unpinned, &pinned, &unpinned }, errors);
+    ASSERT_EQ(resolved.size(), 4);
+
+    for (size_t i = 0; i < resolved.size(); ++i) {
+      ASSERT_TRUE(resolved[i]) << "Failed to resolve list " << i;
+      EXPECT_EQ(errors[i], nullptr);
+      EXPECT_EQ(*resolved[i], ArbiterResolver(behaviors, (i % 2 ? unpinned : pinned), nullptr).resolve()) << "Unexpected result for list " << i;
+    }
+
+    EXPECT_EQ(findResolved(*resolved[1], 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+    EXPECT_EQ(findResolved(*resolved[1], 0, "Y")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(1, 0, 0)));
+  }
+}
+
+TEST(ResolverTest, FetchesDependencyListsConcurrently)
+{
+  ArbiterResolverBehaviors behaviors{&createSlowTransitiveDependencyList, &createVariedVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("ancestor"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 1, makeOptional("alpha"))));
+  dependencies.emplace_back(makeProjectIdentifier("parent"), Requirement::CompatibleWith(ArbiterSemanticVersion(1, 2, 3), ArbiterRequirementStrictnessStrict));
+
+  const ArbiterDependencyList dependencyList(std::move(dependencies));
+
+  ArbiterResolver sequential(behaviors, dependencyList, nullptr);
+  ArbiterResolvedDependencyGraph expected = sequential.resolve();
+  EXPECT_EQ(maximumOutstandingDependencyLists.load(), 1);
+
+  ArbiterResolver resolver(behaviors, dependencyList, nullptr);
+  ArbiterResolverSetFetchThreadCount(&resolver, 4);
+
+  EXPECT_EQ(resolver.resolve(), expected);
+  EXPECT_GE(maximumOutstandingDependencyLists.load(), 2);
+}
+
+TEST(ResolverTest, SharesCachedLists)
+{
+  ArbiterResolverBehaviors behaviors{&createTransitiveDependencyList, &createCountedMajorVersionsList, nullptr, nullptr, nullptr};
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(), nullptr);
+
+  const Resolver::ProjectID project = resolver._projects.intern(makeProjectIdentifier("parent"));
+  const ArbiterSelectedVersion version(ArbiterSemanticVersion(1, 0, 0), makeSharedUserValue<ArbiterSelectedVersion, EmptyTestValue>());
+
+  availableVersionsListCount = 0;
+
+  std::shared_ptr<const ArbiterSelectedVersionList> versions = resolver.fetchAvailableVersions(project);
+  EXPECT_EQ(resolver.fetchAvailableVersions(project), versions);
+  EXPECT_EQ(availableVersionsListCount, 1);
+
+  std::shared_ptr<const ArbiterDependencyList> dependencies = resolver.fetchDependencies(project, version);
+  EXPECT_EQ(resolver.fetchDependencies(project, version), dependencies);
+  EXPECT_EQ(resolver.fetchAllDependencies({ Resolver::ProjectVersion(project, version) }).front(), dependencies);
+}
+
+TEST(ResolverTest, SharesCacheBetweenConcurrentResolvers)
+{
+  ArbiterResolverBehaviors behaviors{&createTransitiveDependencyList, &createSlowCountedVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("ancestor"), Requirement::Exactly(ArbiterSemanticVersion(1, 0, 1, makeOptional("alpha"))));
+  dependencies.emplace_back(makeProjectIdentifier("parent"), Requirement::CompatibleWith(ArbiterSemanticVersion(1, 2, 3), ArbiterRequirementStrictnessStrict));
+  ArbiterDependencyList dependencyList(std::move(dependencies));
+
+  const ArbiterResolvedDependencyGraph expected = ArbiterResolver(behaviors, dependencyList, nullptr).resolve();
+  sharedVersionsListCounts.clear();
+
+  std::unique_ptr<ArbiterResolverCache> cache(ArbiterCreateResolverCache());
+
+  std::vector<std::unique_ptr<ArbiterResolver>> resolvers;
+  for (unsigned i = 0; i < 8; ++i) {
+    resolvers.emplace_back(ArbiterCreateResolverWithCache(behaviors, &dependencyList, nullptr, cache.get()));
+  }
+
+  // Resolvers keep the cache alive on their own.
+  cache.reset();
+
+  std::vector<ArbiterResolvedDependencyGraph> resolved(resolvers.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < resolvers.size(); ++i) {
+    threads.emplace_back([&, i] {
+      resolved[i] = resolvers[i]->resolve();
+    });
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  for (const ArbiterResolvedDependencyGraph &graph : resolved) {
+    EXPECT_EQ(graph, expected);
+  }
+
+  ASSERT_EQ(sharedVersionsListCounts.size(), 6);
+  for (const auto &pair : sharedVersionsListCounts) {
+    EXPECT_EQ(pair.second, 1) << pair.first;
+  }
+}
+
+TEST(ResolverTest, DoesNotShareFailedRequests)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createSometimesFailingVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeProjectIdentifier("A"), Requirement::Any());
+  ArbiterDependencyList dependencyList(std::move(dependencies));
+
+  std::unique_ptr<ArbiterResolverCache> cache(ArbiterCreateResolverCache());
+  std::unique_ptr<ArbiterResolver> failing(ArbiterCreateResolverWithCache(behaviors, &dependencyList, nullptr, cache.get()));
+  std::unique_ptr<ArbiterResolver> succeeding(ArbiterCreateResolverWithCache(behaviors, &dependencyList, nullptr, cache.get()));
+
+  availableVersionsListCount = 0;
+  versionsListShouldFail = true;
+  EXPECT_THROW(failing->resolve(), Exception::UserError);
+  EXPECT_EQ(cache->_cache->size(), 0);
+
+  versionsListShouldFail = false;
+  ArbiterResolvedDependencyGraph resolved = succeeding->resolve();
+  EXPECT_EQ(findResolved(resolved, 0, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(availableVersionsListCount, 2);
+
+  // Now that the list has been fetched, the other resolver reuses it.
+  EXPECT_EQ(failing->resolve(), resolved);
+  EXPECT_EQ(availableVersionsListCount, 2);
+}
+
+TEST(ResolverTest, ResolvesWithAsynchronousBehaviors)
+{
+  ArbiterResolverBehaviors syncBehaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+  ArbiterResolverBehaviors behaviors{nullptr, nullptr, nullptr, &requestDependencyListLater, &requestAvailableVersionsListLater};
+
+  AsyncRequests requests;
+  ArbiterResolver resolver(behaviors, createConflictingManifest(), &requests);
+
+  char *error = nullptr;
+  std::unique_ptr<ArbiterResolvedDependencyGraph> resolved(runAsyncResolver(&resolver, requests, syncBehaviors, &error));
+  ASSERT_NE(resolved, nullptr);
+  EXPECT_EQ(error, nullptr);
+
+  ASSERT_EQ(resolved->depth(), 2);
+  EXPECT_EQ(findResolved(*resolved, 1, "A")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+  EXPECT_EQ(findResolved(*resolved, 0, "Z")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+  EXPECT_EQ(findResolved(*resolved, 0, "leaf")._version._semanticVersion, makeOptional(ArbiterSemanticVersion(2, 0, 0)));
+
+  // The versions of both root dependencies should have been requested at
+  // once.
+  EXPECT_GE(requests._maximumOutstanding, 2);
+}
+
+TEST(ResolverTest, ReportsAsynchronousErrors)
+{
+  ArbiterResolverBehaviors syncBehaviors{&createFailingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+  ArbiterResolverBehaviors behaviors{nullptr, nullptr, nullptr, &requestDependencyListLater, &requestAvailableVersionsListLater};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(emptyProjectIdentifier(), Requirement::Any());
+
+  AsyncRequests requests;
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), &requests);
+
+  char *error = nullptr;
+  EXPECT_EQ(runAsyncResolver(&resolver, requests, syncBehaviors, &error), nullptr);
+  ASSERT_NE(error, nullptr);
+  EXPECT_EQ(std::strcmp(error, "dependency list failure"), 0);
+
+  delete[] error;
+}
+
+TEST(ResolverTest, StopsWhenFreedWhileResolving)
+{
+  ArbiterResolverBehaviors syncBehaviors{&createConflictingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+  ArbiterResolverBehaviors behaviors{nullptr, nullptr, nullptr, &requestDependencyListLater, &requestAvailableVersionsListLater};
+
+  AsyncRequests requests;
+  ArbiterResolver *resolver = new ArbiterResolver(behaviors, createConflictingManifest(), &requests);
+
+  char *error = nullptr;
+  ASSERT_TRUE(ArbiterResolverStartResolving(resolver, &error));
+
+  for (unsigned i = 0; i < 500; ++i) {
+    {
+      std::lock_guard<std::mutex> guard(requests._mutex);
+      if (!requests._requests.empty()) {
+        break;
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // The resolver is waiting for a request which has not been completed, so
+  // freeing it must stop resolution rather than waiting forever.
+  ArbiterFree(resolver);
+
+  // Completing requests afterward should be harmless.
+  requests.completeAll(syncBehaviors);
+}
+
+TEST(ResolverTest, DoesNotBlockOtherThreadsWhileFetchingVersionTables)
+{
+  ArbiterResolverBehaviors syncBehaviors{&createEmptyDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+  ArbiterResolverBehaviors behaviors{nullptr, nullptr, nullptr, &requestDependencyListLater, &requestAvailableVersionsListLater};
+
+  AsyncRequests requests;
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(), &requests);
+
+  const Resolver::ProjectID first = resolver._projects.intern(makeProjectIdentifier("A"));
+  const Resolver::ProjectID second = resolver._projects.intern(makeProjectIdentifier("B"));
+
+  const auto outstanding = [&requests] {
+    std::lock_guard<std::mutex> guard(requests._mutex);
+    return requests._requests.size();
+  };
+
+  const auto waitForOutstanding = [&outstanding](size_t count) {
+    for (unsigned i = 0; i < 500 && outstanding() < count; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  };
+
+  std::shared_ptr<const Resolver::VersionTable> table;
+  std::thread fetching([&] {
+    table = resolver.fetchVersionTable(first);
+  });
+
+  waitForOutstanding(1);
+
+  // The first thread is waiting for its request, which should not stop this
+  // one from making another.
+  std::thread prefetching([&] {
+    resolver.prefetchAvailableVersions(second);
+  });
+
+  waitForOutstanding(2);
+  EXPECT_EQ(outstanding(), 2);
+
+  requests.completeAll(syncBehaviors);
+  fetching.join();
+  prefetching.join();
+  requests.completeAll(syncBehaviors);
+
+  ASSERT_NE(table, nullptr);
+  EXPECT_EQ(table->versions().size(), 3);
+  EXPECT_EQ(resolver.fetchVersionTable(first), table);
+}
+
+TEST(ResolverTest, ResolvesSynchronouslyWithAsynchronousBehaviors)
+{
+  ArbiterResolverBehaviors behaviors{nullptr, nullptr, nullptr, &requestEmptyDependencyListImmediately, &requestMajorVersionsListImmediately};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(emptyProjectIdentifier(), Requirement::AtLeast(ArbiterSemanticVersion(2, 0, 0)));
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+
+  ArbiterResolvedDependencyGraph resolved = resolver.resolve();
+  ASSERT_EQ(resolved.depth(), 1);
+  EXPECT_EQ(resolved._depths.front().begin()->_version._semanticVersion, makeOptional(ArbiterSemanticVersion(3, 0, 0)));
+}
+
+TEST(ResolverTest, CannotFinishResolvingWithoutStarting)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createEmptyAvailableVersionsList, nullptr, nullptr, nullptr};
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(), nullptr);
+
+  EXPECT_EQ(ArbiterResolverEventFileDescriptor(&resolver), -1);
+
+  char *error = nullptr;
+  EXPECT_EQ(ArbiterResolverFinishResolving(&resolver, &error), nullptr);
+  EXPECT_NE(error, nullptr);
+
+  delete[] error;
+}
+
+TEST(ResolverTest, FailsWhenNoAvailableVersions)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createEmptyAvailableVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(emptyProjectIdentifier(), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  EXPECT_THROW(resolver.resolve(), Exception::UnsatisfiableConstraints);
+}
+
+TEST(ResolverTest, FailsWhenNoSatisfyingVersions)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(emptyProjectIdentifier(), Requirement::AtLeast(ArbiterSemanticVersion(4, 0, 0)));
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  EXPECT_THROW(resolver.resolve(), Exception::UnsatisfiableConstraints);
+}
+
+TEST(ResolverTest, DescribesProjectsOnlyToReportErrors)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(makeCountedProjectIdentifier("A"), Requirement::AtLeast(ArbiterSemanticVersion(2, 0, 0)));
+  dependencies.emplace_back(makeCountedProjectIdentifier("B"), Requirement::Any());
+
+  projectDescriptionCount = 0;
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  EXPECT_EQ(resolver.resolve().count(), 2);
+  EXPECT_EQ(projectDescriptionCount, 0);
+}
+
+TEST(ResolverTest, FailsWithMutuallyExclusiveRequirements)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(emptyProjectIdentifier(), Requirement::Exactly(ArbiterSemanticVersion(2, 0, 0)));
+  dependencies.emplace_back(emptyProjectIdentifier(), Requirement::Exactly(ArbiterSemanticVersion(3, 0, 0)));
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  EXPECT_THROW(resolver.resolve(), Exception::MutuallyExclusiveConstraints);
+}
+
+TEST(ResolverTest, RethrowsUserDependencyListErrors)
+{
+  ArbiterResolverBehaviors behaviors{&createFailingDependencyList, &createMajorVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(emptyProjectIdentifier(), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  EXPECT_THROW(resolver.resolve(), Exception::UserError);
+}
+
+TEST(ResolverTest, RethrowsUserVersionListErrors)
+{
+  ArbiterResolverBehaviors behaviors{&createEmptyDependencyList, &createFailingAvailableVersionsList, nullptr, nullptr, nullptr};
+
+  std::vector<ArbiterDependency> dependencies;
+  dependencies.emplace_back(emptyProjectIdentifier(), Requirement::Any());
+
+  ArbiterResolver resolver(behaviors, ArbiterDependencyList(std::move(dependencies)), nullptr);
+  EXPECT_THROW(resolver.resolve(), Exception::UserError);
+}
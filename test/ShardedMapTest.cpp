@@ -0,0 +1,66 @@
+#include "ShardedMap.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Arbiter;
+
+TEST(ShardedMapTest, FindsOrInserts) {
+  ShardedMap<int, std::string> map;
+  EXPECT_EQ(map.size(), 0);
+
+  unsigned created = 0;
+  auto create = [&] {
+    ++created;
+    return std::string("value") + std::to_string(created);
+  };
+
+  EXPECT_EQ(map.findOrInsert(1, create), std::make_pair(std::string("value1"), true));
+  EXPECT_EQ(map.findOrInsert(1, create), std::make_pair(std::string("value1"), false));
+  EXPECT_EQ(map.findOrInsert(2, create), std::make_pair(std::string("value2"), true));
+  EXPECT_EQ(created, 2);
+  EXPECT_EQ(map.size(), 2);
+}
+
+TEST(ShardedMapTest, ErasesOnlyMatchingValues) {
+  ShardedMap<int, std::string> map;
+  map.findOrInsert(1, [] { return std::string("first"); });
+
+  EXPECT_FALSE(map.eraseIf(1, "second"));
+  EXPECT_FALSE(map.eraseIf(2, "first"));
+  EXPECT_EQ(map.size(), 1);
+
+  EXPECT_TRUE(map.eraseIf(1, "first"));
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_EQ(map.findOrInsert(1, [] { return std::string("second"); }), std::make_pair(std::string("second"), true));
+}
+
+TEST(ShardedMapTest, InsertsOnceFromConcurrentThreads) {
+  ShardedMap<int, int> map;
+  std::atomic<unsigned> created(0);
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      for (int key = 0; key < 1000; ++key) {
+        const auto result = map.findOrInsert(key, [&] {
+          ++created;
+          return key * 2;
+        });
+
+        EXPECT_EQ(result.first, key * 2);
+      }
+    });
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(created, 1000);
+  EXPECT_EQ(map.size(), 1000);
+}
@@ -2,6 +2,10 @@
 
 #include "Hash.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 namespace Arbiter {
 namespace Testing {
 
@@ -43,6 +47,23 @@ static char *createDescription (const void *data)
   return copyCString(toString(*static_cast<const TestValue *>(data))).release();
 }
 
+static void *createSerialization (const void *data, size_t *length)
+{
+  const TestValue &value = *static_cast<const TestValue *>(data);
+
+  // Empty values are serialized as nothing at all, and strings as themselves.
+  std::string bytes;
+  if (!dynamic_cast<const EmptyTestValue *>(&value)) {
+    bytes = toString(value);
+  }
+
+  // The caller frees the result with free(), so it must come from malloc().
+  *length = bytes.size();
+  void *serialization = std::malloc(std::max<size_t>(bytes.size(), 1));
+  std::memcpy(serialization, bytes.data(), bytes.size());
+  return serialization;
+}
+
 } // namespace
 
 ArbiterUserValue TestValue::convertToUserValue (std::unique_ptr<TestValue> testValue)
@@ -54,9 +75,21 @@ ArbiterUserValue TestValue::convertToUserValue (std::unique_ptr<TestValue> testV
   userValue.hash = &::hash;
   userValue.destructor = &::destructor;
   userValue.createDescription = &::createDescription;
+  userValue.createSerialization = &::createSerialization;
   return userValue;
 }
 
+bool TestValue::deserializeUserValue (const void *bytes, size_t length, ArbiterUserValue *value)
+{
+  if (length == 0) {
+    *value = convertToUserValue(std::make_unique<EmptyTestValue>());
+  } else {
+    *value = convertToUserValue(std::make_unique<StringTestValue>(std::string(static_cast<const char *>(bytes), length)));
+  }
+
+  return true;
+}
+
 bool EmptyTestValue::operator== (const TestValue &other) const
 {
   return dynamic_cast<const EmptyTestValue *>(&other);
@@ -27,6 +27,12 @@ class TestValue
     virtual size_t hash () const = 0;
 
     static ArbiterUserValue convertToUserValue (std::unique_ptr<TestValue> testValue);
+
+    /**
+     * An ArbiterUserValueDeserializer for values created with
+     * convertToUserValue().
+     */
+    static bool deserializeUserValue (const void *bytes, size_t length, ArbiterUserValue *value);
 };
 
 std::ostream &operator<< (std::ostream &os, const TestValue &value);
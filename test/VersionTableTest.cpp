@@ -0,0 +1,189 @@
+#include "Requirement.h"
+#include "VersionTable.h"
+
+#include "TestValue.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Arbiter;
+using namespace Resolver;
+using namespace Testing;
+
+namespace {
+
+ArbiterSelectedVersion makeSelectedVersion (ArbiterSemanticVersion version, std::string metadata)
+{
+  return ArbiterSelectedVersion(std::move(version), makeSharedUserValue<ArbiterSelectedVersion, StringTestValue>(std::move(metadata)));
+}
+
+ArbiterSelectedVersion makeSelectedVersion (const char *version)
+{
+  return makeSelectedVersion(ArbiterSemanticVersion::fromString(version).value(), version);
+}
+
+VersionTable makeVersionTable ()
+{
+  std::vector<ArbiterSelectedVersion> versions;
+
+  for (const char *version : { "2.0.0", "0.1.1", "1.2.3", "1.0.0-beta", "0.2.0", "1.2.3+dailybuild", "0.1.0", "1.10.0", "3.0.0-alpha.1", "1.0.0", "0.1.2" }) {
+    versions.emplace_back(makeSelectedVersion(version));
+  }
+
+  versions.emplace_back(None(), makeSharedUserValue<ArbiterSelectedVersion, StringTestValue>("master"));
+  return VersionTable(std::move(versions));
+}
+
+/**
+ * Verifies that the compiled form of `requirement` matches exactly the versions
+ * which satisfy it.
+ */
+void expectCompiledCorrectly (const VersionTable &table, const ArbiterRequirement &requirement)
+{
+  Optional<IntervalSet> compiled = table.compile(requirement);
+  ASSERT_TRUE(compiled) << requirement;
+
+  size_t satisfiedCount = 0;
+
+  for (size_t index = 0; index < table.versions().size(); ++index) {
+    const ArbiterSelectedVersion &version = table.versions()[index];
+    const bool satisfied = requirement.satisfiedBy(version);
+
+    EXPECT_EQ(compiled->contains(index), satisfied) << requirement << " with " << version;
+    satisfiedCount += satisfied;
+  }
+
+  EXPECT_EQ(compiled->count(), satisfiedCount) << requirement;
+  EXPECT_EQ(table.mask(requirement).count(), satisfiedCount) << requirement;
+}
+
+bool alwaysSatisfied (const ArbiterSelectedVersion *, const void *)
+{
+  return true;
+}
+
+} // namespace
+
+TEST(VersionTableTest, IntersectsIntervalSets) {
+  IntervalSet lhs;
+  lhs.append(0, 3);
+  lhs.append(5, 8);
+  lhs.append(8, 10);
+
+  EXPECT_EQ(lhs.intervals().size(), 2);
+  EXPECT_EQ(lhs.count(), 8);
+  EXPECT_TRUE(lhs.contains(2));
+  EXPECT_FALSE(lhs.contains(3));
+  EXPECT_TRUE(lhs.contains(9));
+  EXPECT_FALSE(lhs.contains(10));
+
+  IntervalSet rhs;
+  rhs.append(2, 6);
+  rhs.append(9, 12);
+
+  IntervalSet expected;
+  expected.append(2, 3);
+  expected.append(5, 6);
+  expected.append(9, 10);
+
+  EXPECT_EQ(lhs.intersect(rhs), expected);
+  EXPECT_EQ(rhs.intersect(lhs), expected);
+  EXPECT_TRUE(lhs.intersect(IntervalSet::range(3, 5)).empty());
+}
+
+TEST(VersionTableTest, SortsByPrecedence) {
+  VersionTable table = makeVersionTable();
+
+  const std::vector<ArbiterSelectedVersion> &versions = table.versions();
+  EXPECT_FALSE(versions.front()._semanticVersion);
+  EXPECT_EQ(versions.back(), makeSelectedVersion("3.0.0-alpha.1"));
+
+  for (size_t i = 1; i < versions.size(); ++i) {
+    EXPECT_FALSE(versions[i] < versions[i - 1]) << versions[i - 1] << " before " << versions[i];
+  }
+}
+
+TEST(VersionTableTest, CompilesSemanticVersionRequirements) {
+  VersionTable table = makeVersionTable();
+
+  expectCompiledCorrectly(table, Requirement::Any());
+
+  for (const char *version : { "0.0.1", "0.1.1", "1.0.0-alpha", "1.0.0", "1.2.3", "1.2.3+dailybuild", "2.0.0", "4.0.0" }) {
+    const ArbiterSemanticVersion semanticVersion = ArbiterSemanticVersion::fromString(version).value();
+
+    expectCompiledCorrectly(table, Requirement::AtLeast(semanticVersion));
+    expectCompiledCorrectly(table, Requirement::Exactly(semanticVersion));
+    expectCompiledCorrectly(table, Requirement::CompatibleWith(semanticVersion, ArbiterRequirementStrictnessStrict));
+    expectCompiledCorrectly(table, Requirement::CompatibleWith(semanticVersion, ArbiterRequirementStrictnessAllowVersionZeroPatches));
+  }
+}
+
+TEST(VersionTableTest, CompilesCompoundRequirements) {
+  VersionTable table = makeVersionTable();
+
+  Requirement::Compound compound({
+    std::make_shared<Requirement::AtLeast>(ArbiterSemanticVersion(1, 0, 0)),
+    std::make_shared<Requirement::CompatibleWith>(ArbiterSemanticVersion(1, 1, 0), ArbiterRequirementStrictnessStrict)
+  });
+
+  expectCompiledCorrectly(table, compound);
+}
+
+TEST(VersionTableTest, DoesNotCompileOtherRequirements) {
+  VersionTable table = makeVersionTable();
+
+  EXPECT_FALSE(table.compile(Requirement::Custom(&alwaysSatisfied, nullptr)));
+  EXPECT_FALSE(table.compile(Requirement::Unversioned(makeSharedUserValue<ArbiterSelectedVersion, StringTestValue>("master"))));
+
+  Requirement::Compound compound({
+    std::make_shared<Requirement::AtLeast>(ArbiterSemanticVersion(1, 0, 0)),
+    std::make_shared<Requirement::Custom>(&alwaysSatisfied, nullptr)
+  });
+
+  EXPECT_FALSE(table.compile(compound));
+}
+
+TEST(VersionTableTest, MasksOtherRequirements) {
+  VersionTable table = makeVersionTable();
+
+  Requirement::Unversioned unversioned(makeSharedUserValue<ArbiterSelectedVersion, StringTestValue>("master"));
+
+  Bitset expected(table.versions().size());
+  expected.set(0);
+
+  EXPECT_EQ(table.mask(unversioned), expected);
+  EXPECT_EQ(table.mask(Requirement::Custom(&alwaysSatisfied, nullptr)).count(), table.versions().size());
+}
+
+TEST(VersionTableTest, ListsCandidatesWithoutCopying) {
+  auto table = std::make_shared<const VersionTable>(makeVersionTable());
+
+  CandidateList candidates;
+  candidates.append(makeSelectedVersion("1.5.0"));
+  candidates.append(table, table->mask(Requirement::AtLeast(ArbiterSemanticVersion(1, 2, 4))));
+
+  // Versions from the table are referenced in place, newest first.
+  EXPECT_EQ(&candidates[1], &table->versions().back());
+
+  candidates.sortNewestFirst();
+  candidates.remove(makeSelectedVersion("3.0.0-alpha.1"));
+  candidates.moveToFront(makeSelectedVersion("1.10.0"));
+
+  CandidateList moved = std::move(candidates);
+
+  std::vector<ArbiterSelectedVersion> versions;
+  for (size_t i = 0; i < moved.size(); ++i) {
+    versions.emplace_back(moved[i]);
+  }
+
+  const std::vector<ArbiterSelectedVersion> expected = {
+    makeSelectedVersion("1.10.0"),
+    makeSelectedVersion("2.0.0"),
+    makeSelectedVersion("1.5.0"),
+  };
+
+  EXPECT_EQ(versions, expected);
+}
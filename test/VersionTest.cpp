@@ -1,11 +1,18 @@
 #include "Version.h"
 
+#include "TestValue.h"
+
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <memory>
 #include <sstream>
+#include <string>
 #include <utility>
+#include <vector>
 
 using namespace Arbiter;
+using namespace Testing;
 
 TEST(VersionTest, Initializes) {
   ArbiterSemanticVersion version(1, 0, 2);
@@ -44,6 +51,50 @@ TEST(VersionTest, FailsToParseMalformedVersions) {
   EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0-alpha.01").pointer(), nullptr);
   EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0-alpha$1").pointer(), nullptr);
   EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0+build$1").pointer(), nullptr);
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0-").pointer(), nullptr);
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0-alpha.").pointer(), nullptr);
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0-alpha..1").pointer(), nullptr);
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0+").pointer(), nullptr);
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0+build+1").pointer(), nullptr);
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.01").pointer(), nullptr);
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0 ").pointer(), nullptr);
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("4294967296.0.0").pointer(), nullptr);
+}
+
+TEST(VersionTest, ParsesEdgeCases) {
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("4294967295.0.0").value(), ArbiterSemanticVersion(4294967295u, 0, 0));
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0-0.a-b.-").value(), ArbiterSemanticVersion(1, 0, 0, makeOptional("0.a-b.-")));
+  EXPECT_EQ(ArbiterSemanticVersion::fromString("1.0.0-x+0.build-1").value(), ArbiterSemanticVersion(1, 0, 0, makeOptional("x"), makeOptional("0.build-1")));
+}
+
+TEST(VersionTest, ParsesWithoutNULTerminator) {
+  const std::string tags = "1.2.3-beta.2,10.0.0";
+
+  EXPECT_EQ(ArbiterSemanticVersion::fromString(tags.data(), 12).value(), ArbiterSemanticVersion(1, 2, 3, makeOptional("beta.2")));
+  EXPECT_EQ(ArbiterSemanticVersion::fromString(tags.data() + 13, 6).value(), ArbiterSemanticVersion(10, 0, 0));
+  EXPECT_EQ(ArbiterSemanticVersion::fromString(tags.data(), 13).pointer(), nullptr);
+
+  std::unique_ptr<ArbiterSemanticVersion> version(ArbiterCreateSemanticVersionFromStringWithLength(tags.data(), 5));
+  ASSERT_TRUE(version);
+  EXPECT_EQ(*version, ArbiterSemanticVersion(1, 2, 3));
+}
+
+TEST(VersionTest, ParsesVersionListsInBulk) {
+  const char *tags[] = { "1.0.0", "master", "2.0.0-rc.1" };
+  const ArbiterUserValue metadata[] = {
+    TestValue::convertToUserValue(std::make_unique<StringTestValue>("1.0.0")),
+    TestValue::convertToUserValue(std::make_unique<StringTestValue>("master")),
+    TestValue::convertToUserValue(std::make_unique<StringTestValue>("2.0.0-rc.1")),
+  };
+
+  std::unique_ptr<ArbiterSelectedVersionList> list(ArbiterCreateSelectedVersionListFromStrings(tags, nullptr, metadata, 3));
+
+  const std::vector<ArbiterSelectedVersion> expected = {
+    ArbiterSelectedVersion(ArbiterSemanticVersion(1, 0, 0), makeSharedUserValue<ArbiterSelectedVersion, StringTestValue>("1.0.0")),
+    ArbiterSelectedVersion(ArbiterSemanticVersion(2, 0, 0, makeOptional("rc.1")), makeSharedUserValue<ArbiterSelectedVersion, StringTestValue>("2.0.0-rc.1")),
+  };
+
+  EXPECT_EQ(list->_versions, expected);
 }
 
 TEST(VersionTest, ComparesForEquality) {
@@ -71,6 +122,84 @@ TEST(VersionTest, ComparesForPrecedence) {
   EXPECT_LT(ArbiterSemanticVersion(1, 2, 3, makeOptional("1")), ArbiterSemanticVersion(1, 2, 3, makeOptional("alpha")));
 }
 
+TEST(VersionTest, ComparesPrereleaseVersionsLikeSemVer) {
+  // The example from the SemVer specification, plus some edge cases.
+  const std::vector<ArbiterSemanticVersion> ordered = {
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("1")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("1.a")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("255")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("18446744073709551616")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("-")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.1")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.beta")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha0")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("beta")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("beta.2")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("beta.11")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("rc.1")),
+    ArbiterSemanticVersion(1, 0, 0),
+  };
+
+  for (size_t i = 0; i < ordered.size(); ++i) {
+    for (size_t j = 0; j < ordered.size(); ++j) {
+      EXPECT_EQ(ordered[i] < ordered[j], i < j) << ordered[i] << " vs. " << ordered[j];
+    }
+  }
+
+  // Build metadata is ignored, even after copying.
+  const ArbiterSemanticVersion withMetadata(1, 0, 0, makeOptional("beta.11"), makeOptional("build.5"));
+  const ArbiterSemanticVersion copy = withMetadata;
+  EXPECT_FALSE(copy < ordered[11]);
+  EXPECT_FALSE(ordered[11] < copy);
+}
+
+TEST(VersionTest, ComparesLongPrereleaseVersions) {
+  // These share a prefix longer than the precedence keys stored inline.
+  const std::vector<ArbiterSemanticVersion> ordered = {
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.beta.gamma.delta")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.beta.gamma.delta.2")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.beta.gamma.delta.0010")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.beta.gamma.delta.12345678901234567890")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.beta.gamma.delta.epsilon")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.beta.gamma.delta.epsilon.1")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.beta.gamma.delta.epsilon0")),
+    ArbiterSemanticVersion(1, 0, 0, makeOptional("alpha.beta.gamma.deltas")),
+    ArbiterSemanticVersion(1, 0, 0),
+  };
+
+  for (size_t i = 0; i < ordered.size(); ++i) {
+    for (size_t j = 0; j < ordered.size(); ++j) {
+      EXPECT_EQ(ordered[i] < ordered[j], i < j) << ordered[i] << " vs. " << ordered[j];
+    }
+  }
+
+  // Leading zeroes don't affect precedence, even beyond the stored key.
+  const ArbiterSemanticVersion padded(1, 0, 0, makeOptional("alpha.beta.gamma.delta.010"));
+  EXPECT_FALSE(padded < ordered[2]);
+  EXPECT_FALSE(ordered[2] < padded);
+}
+
+TEST(VersionTest, ComparesLargeVersionNumbers) {
+  // Some of these are too large to pack into a single key.
+  const std::vector<ArbiterSemanticVersion> ordered = {
+    ArbiterSemanticVersion(1, 2097151, 2097151),
+    ArbiterSemanticVersion(1, 2097152, 0),
+    ArbiterSemanticVersion(2, 0, 0),
+    ArbiterSemanticVersion(2, 0, 4294967295u, makeOptional("rc.1")),
+    ArbiterSemanticVersion(2, 0, 4294967295u),
+    ArbiterSemanticVersion(2097151, 0, 0),
+    ArbiterSemanticVersion(2097152, 0, 0),
+    ArbiterSemanticVersion(4294967295u, 0, 0),
+  };
+
+  for (size_t i = 0; i < ordered.size(); ++i) {
+    for (size_t j = 0; j < ordered.size(); ++j) {
+      EXPECT_EQ(ordered[i] < ordered[j], i < j) << ordered[i] << " vs. " << ordered[j];
+    }
+  }
+}
+
 TEST(VersionTest, ConvertsToString) {
   std::stringstream stream;
   stream << ArbiterSemanticVersion(1, 2, 3, makeOptional("alpha.1"), makeOptional("dailybuild"));
@@ -0,0 +1,50 @@
+#include "WorkStealingPool.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <vector>
+
+using namespace Arbiter;
+
+TEST(WorkStealingPoolTest, RunsEveryTaskOnce) {
+  for (size_t threadCount : {0, 1, 2, 7}) {
+    WorkStealingPool pool(threadCount);
+    EXPECT_GE(pool.threadCount(), 1);
+
+    std::vector<std::atomic<unsigned>> counts(100);
+    pool.run(counts.size(), [&counts](size_t index) {
+      ++counts[index];
+    });
+
+    for (const auto &count : counts) {
+      EXPECT_EQ(count.load(), 1);
+    }
+  }
+}
+
+TEST(WorkStealingPoolTest, RunsNoTasks) {
+  WorkStealingPool pool(4);
+
+  bool invoked = false;
+  pool.run(0, [&invoked](size_t) {
+    invoked = true;
+  });
+
+  EXPECT_FALSE(invoked);
+}
+
+TEST(WorkStealingPoolTest, CanBeReused) {
+  WorkStealingPool pool(3);
+  std::atomic<size_t> sum(0);
+
+  pool.run(10, [&sum](size_t index) {
+    sum += index;
+  });
+
+  pool.run(10, [&sum](size_t index) {
+    sum += index;
+  });
+
+  EXPECT_EQ(sum.load(), 90);
+}